@@ -1,85 +1,193 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <dirent.h>
 #include <math.h>
 #include <time.h>
 #include <sys/stat.h> // 新增此行
 
 #ifdef _WIN32
+    #include <windows.h>
     #define PATH_SEPARATOR "\\"
+    typedef CRITICAL_SECTION mutex_t;
+    typedef HANDLE thread_t;
+    #define THREAD_RETURN DWORD WINAPI
+    #define mutex_init(m) InitializeCriticalSection(m)
+    #define mutex_destroy(m) DeleteCriticalSection(m)
+    #define mutex_lock(m) EnterCriticalSection(m)
+    #define mutex_unlock(m) LeaveCriticalSection(m)
 #else
+    #include <pthread.h>
+    #include <unistd.h>
     #define PATH_SEPARATOR "/"
+    typedef pthread_mutex_t mutex_t;
+    typedef pthread_t thread_t;
+    #define THREAD_RETURN void *
+    #define mutex_init(m) pthread_mutex_init(m, NULL)
+    #define mutex_destroy(m) pthread_mutex_destroy(m)
+    #define mutex_lock(m) pthread_mutex_lock(m)
+    #define mutex_unlock(m) pthread_mutex_unlock(m)
 #endif
 
+// 工作執行緒數的上限
+#define MAX_WORKERS 64
+
+// 一個待處理的 .sec 文件與它的處理結果
+typedef struct {
+    char input_path[1024];
+    char output_path[1024];
+    long line_count;        // 處理的資料行數（不含標題）
+    const char *error_step; // 失敗的步驟，NULL 表示成功
+    int error_code;         // 失敗時的 errno
+    int done;
+} FileJob;
+
+// 工作執行緒共用的文件佇列
+// 文件依名稱排序；各文件的訊息依排序順序輸出，與工作執行緒數及完成順序無關
+typedef struct {
+    FileJob *jobs;
+    int job_count;
+    int next_job;       // 下一個待處理的文件
+    int next_report;    // 下一個要輸出訊息的文件
+    mutex_t lock;
+} JobQueue;
+
 // 計算磁場強度
 float calculate_magnitude(float x, float y, float z) {
     return sqrt(x*x + y*y + z*z);
 }
 
-// 手動解析日期時間字符串
-void parse_datetime(const char *date_time_str, struct tm *tm, char *millis) {
-    sscanf(date_time_str, "%4d-%2d-%2d %2d:%2d:%2d.%3s",
-           &tm->tm_year, &tm->tm_mon, &tm->tm_mday,
-           &tm->tm_hour, &tm->tm_min, &tm->tm_sec, millis);
-    tm->tm_year -= 1900; // 年份從1900開始
-    tm->tm_mon -= 1;     // 月份從0開始
-    tm->tm_isdst = -1;   // 讓mktime自動檢測夏令時
+// UTC+8 的時差（小時）
+#define UTC8_OFFSET_HOURS 8
+
+// 時間戳記 "YYYY-MM-DD HH:MM:SS.sss" 的固定長度
+#define TIMESTAMP_LENGTH 23
+
+// 日期快取：同一天的資料行只比對日期，不重新計算日曆
+// today 為該 UTC 日期的 "MM/DD/YY"，next_day 為隔天（加 8 小時後跨日時使用）
+typedef struct {
+    char utc_date[10];  // 快取對應的 UTC 日期 "YYYY-MM-DD"（不含結尾 '\0'）
+    int valid;
+    char today[8];      // "MM/DD/YY"（不含結尾 '\0'）
+    char next_day[8];
+} DateCache;
+
+static int is_leap_year(int year) {
+    return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
 }
 
-// 處理跨天和月末/年末的轉換
-static void normalize_time(struct tm *tm) {
-    time_t t = mktime(tm);
-    *tm = *localtime(&t); // normalize tm
+static int days_in_month(int year, int month) {
+    static const int days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return (month == 2 && is_leap_year(year)) ? 29 : days[month - 1];
 }
 
-// 將UTC時間轉換為UTC+8
-void convert_to_utc8(char *date_time) {
-    struct tm tm = {0};
-    char millis[4] = {0}; // 存放毫秒部分
-    // 手動解析日期時間字符串
-    parse_datetime(date_time, &tm, millis);
-    // 增加8小時
-    tm.tm_hour += 8;
-    // 檢查是否需要跨天
-    if (tm.tm_hour >= 24) {
-        tm.tm_hour -= 24;
-        tm.tm_mday += 1;
+// 讀取 count 位數字，遇到非數字時返回 -1
+static int parse_digits(const char *p, int count) {
+    int value = 0;
+    for (int i = 0; i < count; i++) {
+        if (p[i] < '0' || p[i] > '9') {
+            return -1;
+        }
+        value = value * 10 + (p[i] - '0');
     }
-    // 處理跨月和跨年
-    normalize_time(&tm);
-    // 格式化新的時間字符串，保留毫秒部分
-    char temp[30]; // 臨時緩衝區來存放格式化後的時間
-    strftime(temp, sizeof(temp), "%Y-%m-%d %H:%M:%S", &tm);
-    snprintf(date_time, 24, "%s.%s", temp, millis); // 組合日期時間和毫秒
+    return value;
+}
+
+static void write_two_digits(char *p, int value) {
+    p[0] = (char)('0' + value / 10);
+    p[1] = (char)('0' + value % 10);
 }
 
-void convert_date_format(const char* input, char* output, size_t output_size) {
-    struct tm tm = {0};
-    char millis[4];
+// 寫出 "MM/DD/YY"
+static void format_date(char *p, int year, int month, int day) {
+    write_two_digits(p, month);
+    p[2] = '/';
+    write_two_digits(p + 3, day);
+    p[5] = '/';
+    write_two_digits(p + 6, year % 100);
+}
+
+// 更新日期快取；日期格式或範圍不正確時返回 0
+static int update_date_cache(DateCache *cache, const char *date) {
+    if (date[4] != '-' || date[7] != '-') {
+        return 0;
+    }
+    int year = parse_digits(date, 4);
+    int month = parse_digits(date + 5, 2);
+    int day = parse_digits(date + 8, 2);
+    if (year < 0 || month < 1 || month > 12 || day < 1 || day > days_in_month(year, month)) {
+        return 0;
+    }
+
+    format_date(cache->today, year, month, day);
+    // 處理跨月和跨年
+    if (++day > days_in_month(year, month)) {
+        day = 1;
+        if (++month > 12) {
+            month = 1;
+            year++;
+        }
+    }
+    format_date(cache->next_day, year, month, day);
 
-    // 解析輸入的日期時間字符串
-    sscanf(input, "%4d-%2d-%2d %2d:%2d:%2d.%3s",
-           &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
-           &tm.tm_hour, &tm.tm_min, &tm.tm_sec, millis);
+    memcpy(cache->utc_date, date, sizeof(cache->utc_date));
+    cache->valid = 1;
+    return 1;
+}
 
-    tm.tm_year -= 1900; // 年份從1900開始計算
-    tm.tm_mon -= 1;     // 月份從0開始計算
+// 將 UTC 時間戳記 "YYYY-MM-DD HH:MM:SS.sss" 轉換為 UTC+8 的 "MM/DD/YY HH:MM:SS"（捨去毫秒）
+// 以固定欄位位置直接解析數字，只有日期改變時才重新計算日曆，不使用 mktime/localtime，結果與系統時區無關
+// output 至少需要 18 個字元；時間戳記格式不正確時返回 0
+int convert_to_utc8(const char *date_time, DateCache *cache, char *output) {
+    if (!cache->valid || memcmp(cache->utc_date, date_time, sizeof(cache->utc_date)) != 0) {
+        if (!update_date_cache(cache, date_time)) {
+            cache->valid = 0;
+            return 0;
+        }
+    }
+
+    if (date_time[10] != ' ' || date_time[13] != ':' || date_time[16] != ':') {
+        return 0;
+    }
+    int hour = parse_digits(date_time + 11, 2);
+    int minute = parse_digits(date_time + 14, 2);
+    int second = parse_digits(date_time + 17, 2);
+    if (hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 59) {
+        return 0;
+    }
 
-    // 格式化輸出字符串，只包含日期和時間，忽略毫秒
-    strftime(output, output_size, "%m/%d/%y %H:%M:%S", &tm);
+    // 增加8小時，檢查是否需要跨天
+    hour += UTC8_OFFSET_HOURS;
+    if (hour >= 24) {
+        hour -= 24;
+        memcpy(output, cache->next_day, sizeof(cache->next_day));
+    } else {
+        memcpy(output, cache->today, sizeof(cache->today));
+    }
+    output[8] = ' ';
+    write_two_digits(output + 9, hour);
+    output[11] = ':';
+    write_two_digits(output + 12, minute);
+    output[14] = ':';
+    write_two_digits(output + 15, second);
+    output[17] = '\0';
+    return 1;
 }
 
-void process_file(const char *input_file, const char *output_file) {
-    FILE *in = fopen(input_file, "r");
+// 處理一個文件；不輸出訊息，結果與錯誤記錄在 job 中，由 report_finished_jobs 依序輸出
+void process_file(FileJob *job) {
+    FILE *in = fopen(job->input_path, "r");
     if (in == NULL) {
-        perror("無法打開輸入文件");
+        job->error_step = "無法打開輸入文件";
+        job->error_code = errno;
         return;
     }
 
-    FILE *out = fopen(output_file, "w");
+    FILE *out = fopen(job->output_path, "w");
     if (out == NULL) {
-        perror("無法創建輸出文件");
+        job->error_step = "無法創建輸出文件";
+        job->error_code = errno;
         fclose(in);
         return;
     }
@@ -92,42 +200,154 @@ void process_file(const char *input_file, const char *output_file) {
     }
 
     char line[1024];
-    int line_count = 0;
-    printf("\n開始處理數據...\n");
+    long line_count = 0;
+    DateCache date_cache = {0};
     while (fgets(line, sizeof(line), in)) {
         line_count++;
-        // 初始化變數來存儲日期、時間和數據
-        char date_time[24]; // doy: Day of Year
+        // 初始化變數來存儲時間和數據
+        char formated_datetime[18];
         float ncgx, ncgy, ncgz, magnitude;
 
-        // 解析每行數據，%*s 跳過不需要的欄位
-        if (sscanf(line, "%24c %*s %f %f %f %*f", date_time, &ncgx, &ncgy, &ncgz) == 4) {
-            // 確保字符串以空字符結尾
-            date_time[24] = '\0';
-            // printf("抓到時間字串:%s \n", date_time);
-
+        // 時間戳記是行首固定長度的欄位，之後以 %*s 跳過 DOY 欄位
+        if (strlen(line) <= TIMESTAMP_LENGTH) {
+            continue;
+        }
+        if (sscanf(line + TIMESTAMP_LENGTH, " %*s %f %f %f %*f", &ncgx, &ncgy, &ncgz) == 3) {
             // 將UTC時間轉換為UTC+8
-            // char original_time[24];
-            // strcpy(original_time, date_time);
-            convert_to_utc8(date_time);
-            char formated_datetime[20];
-            convert_date_format(date_time, formated_datetime, sizeof(formated_datetime));
-            // printf("時間轉換: %s -> %s\n", original_time, date_time);
+            if (!convert_to_utc8(line, &date_cache, formated_datetime)) {
+                continue;
+            }
 
             // 計算磁場強度
             magnitude = calculate_magnitude(ncgx, ncgy, ncgz);
-            // printf("磁場數據: X=%.2f, Y=%.2f, Z=%.2f\n", ncgx, ncgy, ncgz);
-            // printf("計算強度: %.2f\n", magnitude);
 
             // 輸出到文件
             fprintf(out, "%s\t%f\n", formated_datetime, magnitude);
         }
     }
 
-    printf("總共處理了%d行數據\n", line_count);
+    job->line_count = line_count;
 
+    if (ferror(in)) {
+        job->error_step = "讀取輸入文件失敗";
+        job->error_code = errno;
+    }
     fclose(in);
-    fclose(out);
+    if (ferror(out) && job->error_step == NULL) {
+        job->error_step = "寫入輸出文件失敗";
+        job->error_code = errno;
+    }
+    if (fclose(out) != 0 && job->error_step == NULL) {
+        job->error_step = "寫入輸出文件失敗";
+        job->error_code = errno;
+    }
+}
+
+// 輸出一個文件的處理訊息
+static void print_job_report(const FileJob *job) {
+    printf("正在處理文件: %s\n", job->input_path);
+    if (job->error_step != NULL) {
+        printf("%s: %s\n", job->error_step, strerror(job->error_code));
+        return;
+    }
+    printf("\n開始處理數據...\n");
+    printf("總共處理了%ld行數據\n", job->line_count);
+}
+
+// 依排序順序輸出已完成文件的訊息，遇到尚未完成的文件就停止（呼叫端需持有 queue->lock）
+static void report_finished_jobs(JobQueue *queue) {
+    while (queue->next_report < queue->job_count && queue->jobs[queue->next_report].done) {
+        print_job_report(&queue->jobs[queue->next_report]);
+        queue->next_report++;
+    }
+    fflush(stdout);
+}
+
+// 工作執行緒：從佇列取出文件處理，直到佇列為空
+static THREAD_RETURN worker_main(void *arg) {
+    JobQueue *queue = arg;
+    for (;;) {
+        mutex_lock(&queue->lock);
+        // 略過收集時就已失敗（例如 stat 失敗）的文件
+        while (queue->next_job < queue->job_count && queue->jobs[queue->next_job].done) {
+            queue->next_job++;
+        }
+        int index = queue->next_job < queue->job_count ? queue->next_job++ : -1;
+        mutex_unlock(&queue->lock);
+        if (index < 0) {
+            break;
+        }
+
+        process_file(&queue->jobs[index]);
+
+        mutex_lock(&queue->lock);
+        queue->jobs[index].done = 1;
+        report_finished_jobs(queue);
+        mutex_unlock(&queue->lock);
+    }
+    return 0;
+}
+
+static int compare_jobs(const void *a, const void *b) {
+    return strcmp(((const FileJob *)a)->input_path, ((const FileJob *)b)->input_path);
+}
+
+// 處理器數量，用於 -j 0
+static int cpu_count(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+#endif
+}
+
+// 單調時鐘（秒），用於計算處理速度
+static double now_seconds(void) {
+#ifdef _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+#endif
+}
+
+// 以 worker_count 個工作執行緒處理所有文件
+static void run_jobs(JobQueue *queue, int worker_count) {
+    thread_t threads[MAX_WORKERS];
+    int started = 0;
+
+    for (int i = 1; i < worker_count; i++) {
+#ifdef _WIN32
+        threads[started] = CreateThread(NULL, 0, worker_main, queue, 0, NULL);
+        if (threads[started] == NULL) {
+            break;
+        }
+#else
+        if (pthread_create(&threads[started], NULL, worker_main, queue) != 0) {
+            break;
+        }
+#endif
+        started++;
+    }
+
+    // 主執行緒也是其中一個工作執行緒；建立執行緒失敗時由已建立的執行緒完成剩下的文件
+    worker_main(queue);
+
+    for (int i = 0; i < started; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
+    }
 }
 
 int main(int argc, char *argv[]) {
@@ -136,50 +356,125 @@ int main(int argc, char *argv[]) {
         system("chcp 65001");
     #endif
 
-    if (argc != 2) {
-        printf("使用方法: %s <目錄>\n", argv[0]);
+    // 解析參數：[-j N] <目錄>
+    int worker_count = 1;
+    const char *directory = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            worker_count = atoi(argv[++i]);
+        } else if (strncmp(argv[i], "-j", 2) == 0 && argv[i][2] != '\0') {
+            worker_count = atoi(argv[i] + 2);
+        } else if (directory == NULL) {
+            directory = argv[i];
+        } else {
+            directory = NULL;
+            break;
+        }
+    }
+    if (directory == NULL || worker_count < 0) {
+        printf("使用方法: %s [-j 工作執行緒數] <目錄>\n", argv[0]);
+        printf("  -j N  同時處理 N 個文件（預設 1，0 表示依處理器數量決定）\n");
         return 1;
     }
+    if (worker_count == 0) {
+        worker_count = cpu_count();
+    }
+    if (worker_count > MAX_WORKERS) {
+        worker_count = MAX_WORKERS;
+    }
 
     DIR *dir;
     struct dirent *ent;
     // 打開指定的目錄
-    if ((dir = opendir(argv[1])) != NULL) {
-        char input_path[1024], output_path[1024];
-        struct stat st;
-        // 遍歷目錄中的每個文件
-        while ((ent = readdir(dir)) != NULL) {
-            // 首先檢查文件是否為普通文件並有.sec後綴，節省路徑組合的開銷
-            if (strstr(ent->d_name, ".sec") != NULL) {
-                printf("正在處理文件: %s\n", input_path);
-                // 組合完整路徑，然後檢查文件類型
-                snprintf(input_path, sizeof(input_path), "%s" PATH_SEPARATOR "%s", argv[1], ent->d_name);
-                if (stat(input_path, &st) == 0 && S_ISREG(st.st_mode)) {
-                    // 生成輸出文件的路徑，移除.sec並添加.txt
-                    char *dot = strrchr(ent->d_name, '.');
-                    if (dot && strcmp(dot, ".sec") == 0) {
-                        *dot = '\0'; // 移除.sec 在C語言中，字符串是以空字符 (\0) 結束的
-                        snprintf(output_path, sizeof(output_path), "%s" PATH_SEPARATOR "%s.txt", argv[1], ent->d_name);
-                        *dot = '.';  // 恢復原文件名
-                    } else {
-                        // 如果文件不是以.sec結尾，則直接添加.txt
-                        snprintf(output_path, sizeof(output_path), "%s" PATH_SEPARATOR "%s.txt", argv[1], ent->d_name);
-                    }
-
-                    // 對每個符合條件的文件進行處理
-                    process_file(input_path, output_path);
-                } else {
-                    // 如果stat失敗，報告錯誤
-                    perror("無法獲取文件信息");
-                }
-            }
-        }
-        closedir(dir);
-        printf("資料夾中的文本文件已處理完畢。\n");
-    } else {
+    if ((dir = opendir(directory)) == NULL) {
         perror("無法開啟目錄");
         return 1;
     }
 
-    return 0;
-}
\ No newline at end of file
+    JobQueue queue = {0};
+    int capacity = 0;
+    struct stat st;
+    // 遍歷目錄中的每個文件，收集待處理的文件
+    while ((ent = readdir(dir)) != NULL) {
+        // 首先檢查文件名是否有.sec後綴，節省路徑組合的開銷
+        if (strstr(ent->d_name, ".sec") == NULL) {
+            continue;
+        }
+        if (queue.job_count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            FileJob *jobs = realloc(queue.jobs, capacity * sizeof(FileJob));
+            if (jobs == NULL) {
+                perror("無法配置記憶體");
+                free(queue.jobs);
+                closedir(dir);
+                return 1;
+            }
+            queue.jobs = jobs;
+        }
+        FileJob *job = &queue.jobs[queue.job_count++];
+        memset(job, 0, sizeof(*job));
+
+        // 組合完整路徑，然後檢查文件類型
+        snprintf(job->input_path, sizeof(job->input_path), "%s" PATH_SEPARATOR "%s", directory, ent->d_name);
+        if (stat(job->input_path, &st) != 0) {
+            // 如果stat失敗，記錄錯誤，不處理此文件
+            job->error_step = "無法獲取文件信息";
+            job->error_code = errno;
+            job->done = 1;
+            continue;
+        }
+        if (!S_ISREG(st.st_mode)) {
+            queue.job_count--;
+            continue;
+        }
+
+        // 生成輸出文件的路徑，移除.sec並添加.txt
+        char *dot = strrchr(ent->d_name, '.');
+        if (dot && strcmp(dot, ".sec") == 0) {
+            *dot = '\0'; // 移除.sec 在C語言中，字符串是以空字符 (\0) 結束的
+            snprintf(job->output_path, sizeof(job->output_path), "%s" PATH_SEPARATOR "%s.txt", directory, ent->d_name);
+            *dot = '.';  // 恢復原文件名
+        } else {
+            // 如果文件不是以.sec結尾，則直接添加.txt
+            snprintf(job->output_path, sizeof(job->output_path), "%s" PATH_SEPARATOR "%s.txt", directory, ent->d_name);
+        }
+    }
+    closedir(dir);
+
+    // readdir 的順序依檔案系統而定，排序後處理與輸出訊息的順序才固定
+    qsort(queue.jobs, queue.job_count, sizeof(FileJob), compare_jobs);
+    if (worker_count > queue.job_count) {
+        worker_count = queue.job_count > 0 ? queue.job_count : 1;
+    }
+
+    double start_time = now_seconds();
+    mutex_init(&queue.lock);
+    run_jobs(&queue, worker_count);
+    mutex_destroy(&queue.lock);
+    double elapsed = now_seconds() - start_time;
+
+    // 最後的摘要：總行數、處理速度與失敗的文件
+    long long total_lines = 0;
+    int failed_count = 0;
+    for (int i = 0; i < queue.job_count; i++) {
+        total_lines += queue.jobs[i].line_count;
+        if (queue.jobs[i].error_step != NULL) {
+            failed_count++;
+        }
+    }
+    printf("\n共處理 %d 個文件、%lld 行數據，耗時 %.2f 秒（%.0f 行/秒，%d 個工作執行緒）\n",
+           queue.job_count, total_lines, elapsed, elapsed > 0 ? total_lines / elapsed : 0.0, worker_count);
+    if (failed_count > 0) {
+        printf("處理失敗的文件（%d 個）:\n", failed_count);
+        for (int i = 0; i < queue.job_count; i++) {
+            const FileJob *job = &queue.jobs[i];
+            if (job->error_step != NULL) {
+                printf("  %s: %s: %s\n", job->input_path, job->error_step, strerror(job->error_code));
+            }
+        }
+    }
+    printf("資料夾中的文本文件已處理完畢。\n");
+
+    free(queue.jobs);
+    return failed_count > 0 ? 1 : 0;
+}
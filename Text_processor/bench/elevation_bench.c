@@ -0,0 +1,548 @@
+// 高程轉換效能基準測試
+// 產生可重現的合成SEP模型與潮位資料，以無介面方式執行高程轉換，
+// 每個測試案例輸出一行 JSON（每秒行數、每筆查詢奈秒數、尖峰常駐記憶體），方便跨版本比較
+//
+// 用法: elevation_bench [--sep-kinds lattice,clustered,irregular] [--points N,N,...]
+//                       [--tracks stationary,zigzag] [--rows N,N,...] [--workers N]
+//                       [--backends point,tin]
+//                       [--work-dir 目錄] [--out 結果檔] [--label 標籤]
+//
+// 每個案例在獨立的子行程中執行，尖峰常駐記憶體只反映該案例；合成資料依參數命名存放在
+// 工作目錄，已存在時直接沿用。
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#ifdef G_OS_WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#include "../include/elevation_processing.h"
+#include "../include/sep_data.h"
+#include "../include/sep_tin.h"
+
+// 合成資料的地理範圍（度）
+#define BENCH_WEST 120.0
+#define BENCH_SOUTH 23.5
+#define BENCH_SIZE 1.0
+
+#define BENCH_CLUSTER_POINTS 2000        // 叢集型SEP每個叢集的平均點數
+#define BENCH_CLUSTER_SIGMA 0.01         // 叢集的標準差（度）
+#define BENCH_STATIONARY_ROWS 600        // 靜止航跡每個停泊點的行數（每秒一行，即 10 分鐘）
+#define BENCH_STATIONARY_SPOTS 16        // 靜止航跡的停泊點數
+#define BENCH_ZIGZAG_LINES 40            // 之字形航跡的測線數
+#define BENCH_LOOKUP_SAMPLE (1 << 20)    // 單獨量測查詢時間的查詢筆數上限
+
+typedef enum {
+    BENCH_SEP_LATTICE = 0,   // 規則格網
+    BENCH_SEP_CLUSTERED,     // 數個高斯叢集
+    BENCH_SEP_IRREGULAR      // 均勻隨機散佈
+} BenchSepKind;
+
+typedef enum {
+    BENCH_TRACK_STATIONARY = 0,  // 船舶在幾個停泊點靜止，位置長時間不變
+    BENCH_TRACK_ZIGZAG           // 來回測線
+} BenchTrack;
+
+typedef enum {
+    BENCH_BACKEND_POINT = 0,     // 逐點查詢（精確匹配或兩近鄰插值）
+    BENCH_BACKEND_TIN            // 三角網線性內插
+} BenchBackend;
+
+static const char *bench_sep_kind_names[] = { "lattice", "clustered", "irregular" };
+static const char *bench_track_names[] = { "stationary", "zigzag" };
+static const char *bench_backend_names[] = { "point", "tin" };
+
+// ---------- 可重現的亂數（splitmix64） ----------
+
+static guint64 bench_random_next(guint64 *state) {
+    guint64 z = (*state += G_GUINT64_CONSTANT(0x9E3779B97F4A7C15));
+    z = (z ^ (z >> 30)) * G_GUINT64_CONSTANT(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * G_GUINT64_CONSTANT(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+// [0, 1) 均勻分布
+static double bench_random_uniform(guint64 *state) {
+    return (bench_random_next(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// 標準常態分布（Box-Muller）
+static double bench_random_gaussian(guint64 *state) {
+    double u1 = MAX(bench_random_uniform(state), 1e-300);
+    double u2 = bench_random_uniform(state);
+    return sqrt(-2.0 * log(u1)) * cos(2.0 * G_PI * u2);
+}
+
+// 調整值曲面：平滑變化，插值結果有意義
+static double bench_surface(double longitude, double latitude) {
+    return 15.0 + 2.0 * sin(longitude * 7.0) + 1.5 * cos(latitude * 5.0);
+}
+
+// 合成資料先寫到暫存檔，全部寫完才 rename 成正式檔名；失敗時刪除暫存檔，
+// 不會留下不完整的檔案被下次執行當成已存在的資料沿用
+static gboolean bench_finish_file(FILE *file, const char *temp_path, const char *path, gboolean ok) {
+    ok = (fclose(file) == 0) && ok;
+    ok = ok && g_rename(temp_path, path) == 0;
+    if (!ok) {
+        g_unlink(temp_path);
+    }
+    return ok;
+}
+
+// ---------- 合成SEP模型 ----------
+
+static gboolean bench_write_sep(const char *path, BenchSepKind kind, gint64 points) {
+    char *temp_path = g_strdup_printf("%s.tmp", path);
+    FILE *file = g_fopen(temp_path, "w");
+    if (!file) {
+        g_free(temp_path);
+        return FALSE;
+    }
+
+    guint64 state = G_GUINT64_CONSTANT(0x5EB0000) + (guint64)kind * 1000003 + (guint64)points;
+    gint64 side = (gint64)ceil(sqrt((double)points));
+    double step = BENCH_SIZE / (double)MAX(side - 1, 1);
+    gint64 clusters = MAX(points / BENCH_CLUSTER_POINTS, 1);
+
+    // 叢集中心：獨立的亂數序列，與點的數量無關
+    double *centers = NULL;
+    if (kind == BENCH_SEP_CLUSTERED) {
+        guint64 center_state = G_GUINT64_CONSTANT(0xC1D5);
+        centers = g_new(double, 2 * clusters);
+        for (gint64 c = 0; c < clusters; c++) {
+            centers[2 * c] = BENCH_WEST + 0.05 + bench_random_uniform(&center_state) * (BENCH_SIZE - 0.1);
+            centers[2 * c + 1] = BENCH_SOUTH + 0.05 + bench_random_uniform(&center_state) * (BENCH_SIZE - 0.1);
+        }
+    }
+
+    gboolean ok = TRUE;
+    for (gint64 k = 0; ok && k < points; k++) {
+        double longitude, latitude;
+        if (kind == BENCH_SEP_LATTICE) {
+            longitude = BENCH_WEST + (k % side) * step;
+            latitude = BENCH_SOUTH + (k / side) * step;
+        } else if (kind == BENCH_SEP_CLUSTERED) {
+            gint64 c = k % clusters;
+            longitude = centers[2 * c] + bench_random_gaussian(&state) * BENCH_CLUSTER_SIGMA;
+            latitude = centers[2 * c + 1] + bench_random_gaussian(&state) * BENCH_CLUSTER_SIGMA;
+        } else {
+            longitude = BENCH_WEST + bench_random_uniform(&state) * BENCH_SIZE;
+            latitude = BENCH_SOUTH + bench_random_uniform(&state) * BENCH_SIZE;
+        }
+        ok = fprintf(file, "%.9f %.9f %.4f\n", longitude, latitude, bench_surface(longitude, latitude)) > 0;
+    }
+
+    g_free(centers);
+    ok = bench_finish_file(file, temp_path, path, ok);
+    g_free(temp_path);
+    return ok;
+}
+
+// ---------- 合成潮位資料 ----------
+
+// 第 k 行的位置；所有列都通過過濾（col6、col7 不為 0），重複執行覆寫原始檔案時內容不變
+static void bench_track_position(BenchTrack track, gint64 rows, gint64 k, double *longitude, double *latitude) {
+    const double margin = 0.05;
+    const double width = BENCH_SIZE - 2 * margin;
+
+    if (track == BENCH_TRACK_STATIONARY) {
+        guint64 spot_state = (guint64)(k / BENCH_STATIONARY_ROWS % BENCH_STATIONARY_SPOTS) + 1;
+        *longitude = BENCH_WEST + margin + bench_random_uniform(&spot_state) * width;
+        *latitude = BENCH_SOUTH + margin + bench_random_uniform(&spot_state) * width;
+        return;
+    }
+
+    double t = (double)k / (double)MAX(rows, 1) * BENCH_ZIGZAG_LINES;
+    int line = MIN((int)t, BENCH_ZIGZAG_LINES - 1);
+    double fraction = t - line;
+    *longitude = BENCH_WEST + margin + (line % 2 == 0 ? fraction : 1.0 - fraction) * width;
+    *latitude = BENCH_SOUTH + margin + line * (width / (BENCH_ZIGZAG_LINES - 1));
+}
+
+static gboolean bench_write_tide(const char *path, BenchTrack track, gint64 rows) {
+    char *temp_path = g_strdup_printf("%s.tmp", path);
+    FILE *file = g_fopen(temp_path, "w");
+    if (!file) {
+        g_free(temp_path);
+        return FALSE;
+    }
+
+    GDate *date = g_date_new_dmy(1, G_DATE_JANUARY, 2024);
+    gint64 current_day = 0;
+    gboolean ok = TRUE;
+
+    for (gint64 k = 0; ok && k < rows; k++) {
+        gint64 day = k / 86400;
+        if (day != current_day) {
+            g_date_add_days(date, (guint)(day - current_day));
+            current_day = day;
+        }
+        int seconds = (int)(k % 86400);
+
+        double longitude, latitude;
+        bench_track_position(track, rows, k, &longitude, &latitude);
+        double tide = 0.8 * sin(k * (2.0 * G_PI / 44712.0));   // 半日潮
+        double depth = 20.0 + 5.0 * sin(longitude * 11.0) * cos(latitude * 13.0);
+
+        ok = fprintf(file, "%04d/%02d/%02d/%02d:%02d:%02d.000/%.3f/%.7f/%.7f/%.3f/1.000/2.000\n",
+                     g_date_get_year(date), g_date_get_month(date), g_date_get_day(date),
+                     seconds / 3600, seconds / 60 % 60, seconds % 60,
+                     tide, longitude, latitude, depth) > 0;
+    }
+
+    g_date_free(date);
+    ok = bench_finish_file(file, temp_path, path, ok);
+    g_free(temp_path);
+    return ok;
+}
+
+// ---------- 量測 ----------
+
+// 尖峰常駐記憶體（KB）
+static gint64 bench_peak_rss_kb(void) {
+#ifdef G_OS_WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return (gint64)(counters.PeakWorkingSetSize / 1024);
+    }
+    return -1;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return (gint64)usage.ru_maxrss;   // Linux 以 KB 為單位
+    }
+    return -1;
+#endif
+}
+
+static void bench_discard_print(const gchar *message) {
+    (void)message;
+}
+
+// 單獨量測批次查詢：以相同航跡的前 BENCH_LOOKUP_SAMPLE 筆座標，單一執行緒依轉換時的區塊大小查詢
+// 三角網模式與轉換時相同，三角網外的點退回逐點查詢
+static double bench_lookup_ns(const char *sep_path, BenchTrack track, gint64 rows, BenchBackend backend) {
+    SepDataStructure *data = load_sep_file_optimized(sep_path);
+    if (!data) return -1.0;
+
+    SepTin *tin = NULL;
+    if (backend == BENCH_BACKEND_TIN) {
+        tin = sep_tin_load_or_build(sep_path, data, NULL, NULL);
+        if (!tin) {
+            sep_data_free(data);
+            return -1.0;
+        }
+    }
+
+    int count = (int)MIN(rows, (gint64)BENCH_LOOKUP_SAMPLE);
+    double *longitudes = g_new(double, count);
+    double *latitudes = g_new(double, count);
+    double *adjustments = g_new(double, SEP_BATCH_BLOCK_ROWS);
+    SepMatchKind *kinds = g_new(SepMatchKind, SEP_BATCH_BLOCK_ROWS);
+    for (int k = 0; k < count; k++) {
+        bench_track_position(track, rows, k, &longitudes[k], &latitudes[k]);
+    }
+
+    SepLookupContext *ctx = sep_lookup_context_new();
+    gint64 start = g_get_monotonic_time();
+    for (int offset = 0; offset < count; offset += SEP_BATCH_BLOCK_ROWS) {
+        int block = MIN(SEP_BATCH_BLOCK_ROWS, count - offset);
+        if (tin) {
+            sep_tin_lookup_batch(tin, longitudes + offset, latitudes + offset, block, adjustments, kinds);
+            for (int k = 0; k < block; k++) {
+                if (kinds[k] == SEP_MATCH_NONE) {
+                    adjustments[k] = sep_data_lookup(data, longitudes[offset + k], latitudes[offset + k], &kinds[k]);
+                }
+            }
+        } else {
+            sep_data_lookup_batch(data, ctx, longitudes + offset, latitudes + offset, block, adjustments, kinds);
+        }
+    }
+    double elapsed_ns = (g_get_monotonic_time() - start) * 1000.0;
+
+    sep_lookup_context_free(ctx);
+    g_free(kinds);
+    g_free(adjustments);
+    g_free(latitudes);
+    g_free(longitudes);
+    sep_tin_free(tin);
+    sep_data_free(data);
+    return count > 0 ? elapsed_ns / count : 0.0;
+}
+
+// 轉換結果的檔名：與轉換程式相同，在副檔名前加上 "_converted"
+static char* bench_converted_path(const char *tide_path) {
+    const char *dot = strrchr(tide_path, '.');
+    const char *separator = strrchr(tide_path, G_DIR_SEPARATOR);
+    if (!dot || (separator && dot < separator)) {
+        return g_strdup_printf("%s_converted", tide_path);
+    }
+    return g_strdup_printf("%.*s_converted%s", (int)(dot - tide_path), tide_path, dot);
+}
+
+// 子行程：執行一個案例並在標準輸出印出一行 JSON
+static int bench_run_case(const char *sep_path, const char *tide_path, const char *label,
+                          BenchSepKind kind, gint64 points, BenchTrack track, gint64 rows, int workers,
+                          BenchBackend backend) {
+    g_set_print_handler(bench_discard_print);
+
+    ElevationOptions options;
+    elevation_options_init(&options);
+    options.worker_count = workers;
+    options.use_tin = backend == BENCH_BACKEND_TIN;
+    // 只量測查詢與內插：不覆寫輸入檔（重複執行時輸入不變），也不寫檢查點
+    options.filtered_output = ELEVATION_FILTERED_NONE;
+    options.checkpoint_interval = 0;
+
+    GString *report = g_string_new(NULL);
+    GError *error = NULL;
+    gint64 start = g_get_monotonic_time();
+    gboolean ok = process_elevation_conversion_ex(tide_path, sep_path, &options, report, &error, NULL);
+    double seconds = (g_get_monotonic_time() - start) / 1e6;
+    gint64 peak_rss_kb = bench_peak_rss_kb();
+    double lookup_ns = ok ? bench_lookup_ns(sep_path, track, rows, backend) : -1.0;
+
+    // 轉換結果只用來計時，不保留
+    char *converted_path = bench_converted_path(tide_path);
+    g_unlink(converted_path);
+    g_free(converted_path);
+
+    char *escaped_label = g_strescape(label, NULL);
+    char *escaped_error = g_strescape(error ? error->message : "", NULL);
+    printf("{\"label\":\"%s\",\"sep_kind\":\"%s\",\"sep_points\":%" G_GINT64_FORMAT ",\"track\":\"%s\","
+           "\"backend\":\"%s\",\"rows\":%" G_GINT64_FORMAT ",\"workers\":%d,\"ok\":%s,\"seconds\":%.6f,\"rows_per_sec\":%.1f,"
+           "\"ns_per_row\":%.1f,\"ns_per_lookup\":%.1f,\"peak_rss_kb\":%" G_GINT64_FORMAT ",\"error\":\"%s\"}\n",
+           escaped_label, bench_sep_kind_names[kind], points, bench_track_names[track],
+           bench_backend_names[backend], rows, workers,
+           ok ? "true" : "false", seconds, seconds > 0 ? rows / seconds : 0.0,
+           rows > 0 ? seconds * 1e9 / rows : 0.0, lookup_ns, peak_rss_kb, escaped_error);
+    fflush(stdout);
+
+    g_free(escaped_label);
+    g_free(escaped_error);
+    g_clear_error(&error);
+    g_string_free(report, TRUE);
+    return ok ? 0 : 1;
+}
+
+// ---------- 主行程 ----------
+
+// 解析以逗號分隔的名稱清單，回傳對應的索引陣列
+static GArray* bench_parse_names(const char *list, const char **names, int name_count) {
+    GArray *values = g_array_new(FALSE, FALSE, sizeof(int));
+    gchar **items = g_strsplit(list, ",", -1);
+    for (int i = 0; items[i]; i++) {
+        for (int n = 0; n < name_count; n++) {
+            if (strcmp(g_strstrip(items[i]), names[n]) == 0) {
+                g_array_append_val(values, n);
+            }
+        }
+    }
+    g_strfreev(items);
+    return values;
+}
+
+// 解析以逗號分隔的數量清單（可用 1e6 之類的寫法）
+static GArray* bench_parse_counts(const char *list) {
+    GArray *values = g_array_new(FALSE, FALSE, sizeof(gint64));
+    gchar **items = g_strsplit(list, ",", -1);
+    for (int i = 0; items[i]; i++) {
+        gint64 value = (gint64)g_ascii_strtod(items[i], NULL);
+        if (value > 0) {
+            g_array_append_val(values, value);
+        }
+    }
+    g_strfreev(items);
+    return values;
+}
+
+// 確保合成資料存在：不存在時產生，SEP 另外先載入一次建立二進位快取，量測的是穩定狀態
+static gboolean bench_prepare_sep(const char *path, BenchSepKind kind, gint64 points) {
+    if (g_file_test(path, G_FILE_TEST_EXISTS)) return TRUE;
+
+    fprintf(stderr, "產生合成SEP: %s\n", path);
+    if (!bench_write_sep(path, kind, points)) return FALSE;
+
+    SepDataStructure *data = load_sep_file_optimized(path);
+    gboolean loaded = data != NULL;
+    sep_data_free(data);
+    return loaded;
+}
+
+// 三角網快取不存在時先建立一次，轉換量測的同樣是穩定狀態
+static gboolean bench_prepare_tin(const char *sep_path) {
+    char *cache_path = g_strdup_printf("%s.septin", sep_path);
+    gboolean exists = g_file_test(cache_path, G_FILE_TEST_EXISTS);
+    g_free(cache_path);
+    if (exists) return TRUE;
+
+    fprintf(stderr, "建立三角網快取: %s.septin\n", sep_path);
+    SepDataStructure *data = load_sep_file_optimized(sep_path);
+    if (!data) return FALSE;
+    SepTin *tin = sep_tin_load_or_build(sep_path, data, NULL, NULL);
+    gboolean built = tin != NULL;
+    sep_tin_free(tin);
+    sep_data_free(data);
+    return built;
+}
+
+static gboolean bench_prepare_tide(const char *path, BenchTrack track, gint64 rows) {
+    if (g_file_test(path, G_FILE_TEST_EXISTS)) return TRUE;
+
+    fprintf(stderr, "產生合成潮位資料: %s\n", path);
+    return bench_write_tide(path, track, rows);
+}
+
+int main(int argc, char **argv) {
+    // 子行程：--run-case <SEP> <潮位> <標籤> <SEP種類> <點數> <航跡> <行數> <執行緒數> <查詢方式>
+    if (argc == 11 && strcmp(argv[1], "--run-case") == 0) {
+        return bench_run_case(argv[2], argv[3], argv[4], (BenchSepKind)atoi(argv[5]),
+                              g_ascii_strtoll(argv[6], NULL, 10), (BenchTrack)atoi(argv[7]),
+                              g_ascii_strtoll(argv[8], NULL, 10), atoi(argv[9]), (BenchBackend)atoi(argv[10]));
+    }
+
+    const char *sep_kinds = "lattice,clustered,irregular";
+    const char *points_list = "1000,100000";
+    const char *tracks = "stationary,zigzag";
+    const char *rows_list = "100000";
+    const char *backends = "point";
+    const char *work_dir = "bench_data";
+    const char *out_path = "bench_results.jsonl";
+    const char *label = "";
+    int workers = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            fprintf(stderr, "參數缺少值: %s\n", argv[i]);
+            return 2;
+        } else if (strcmp(argv[i], "--sep-kinds") == 0) {
+            sep_kinds = argv[++i];
+        } else if (strcmp(argv[i], "--points") == 0) {
+            points_list = argv[++i];
+        } else if (strcmp(argv[i], "--tracks") == 0) {
+            tracks = argv[++i];
+        } else if (strcmp(argv[i], "--rows") == 0) {
+            rows_list = argv[++i];
+        } else if (strcmp(argv[i], "--backends") == 0) {
+            backends = argv[++i];
+        } else if (strcmp(argv[i], "--workers") == 0) {
+            workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--work-dir") == 0) {
+            work_dir = argv[++i];
+        } else if (strcmp(argv[i], "--out") == 0) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "--label") == 0) {
+            label = argv[++i];
+        } else {
+            fprintf(stderr, "未知的參數: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    GArray *kind_values = bench_parse_names(sep_kinds, bench_sep_kind_names, G_N_ELEMENTS(bench_sep_kind_names));
+    GArray *track_values = bench_parse_names(tracks, bench_track_names, G_N_ELEMENTS(bench_track_names));
+    GArray *point_values = bench_parse_counts(points_list);
+    GArray *row_values = bench_parse_counts(rows_list);
+    GArray *backend_values = bench_parse_names(backends, bench_backend_names, G_N_ELEMENTS(bench_backend_names));
+    if (kind_values->len == 0 || track_values->len == 0 || point_values->len == 0 || row_values->len == 0 ||
+        backend_values->len == 0) {
+        fprintf(stderr, "測試案例為空，請檢查 --sep-kinds、--points、--tracks、--rows、--backends\n");
+        return 2;
+    }
+
+    if (g_mkdir_with_parents(work_dir, 0755) != 0) {
+        fprintf(stderr, "無法建立工作目錄: %s\n", work_dir);
+        return 1;
+    }
+    FILE *out = g_fopen(out_path, "a");
+    if (!out) {
+        fprintf(stderr, "無法開啟結果檔: %s\n", out_path);
+        return 1;
+    }
+
+    int failed_cases = 0;
+    for (guint ki = 0; ki < kind_values->len; ki++) {
+        for (guint pi = 0; pi < point_values->len; pi++) {
+            BenchSepKind kind = (BenchSepKind)g_array_index(kind_values, int, ki);
+            gint64 points = g_array_index(point_values, gint64, pi);
+            char *sep_name = g_strdup_printf("sep_%s_%" G_GINT64_FORMAT ".xyz", bench_sep_kind_names[kind], points);
+            char *sep_path = g_build_filename(work_dir, sep_name, NULL);
+            g_free(sep_name);
+            if (!bench_prepare_sep(sep_path, kind, points)) {
+                fprintf(stderr, "無法產生合成SEP: %s\n", sep_path);
+                g_free(sep_path);
+                failed_cases++;
+                continue;
+            }
+
+            for (guint ti = 0; ti < track_values->len; ti++) {
+                for (guint ri = 0; ri < row_values->len; ri++) {
+                    BenchTrack track = (BenchTrack)g_array_index(track_values, int, ti);
+                    gint64 rows = g_array_index(row_values, gint64, ri);
+                    char *tide_name = g_strdup_printf("tide_%s_%" G_GINT64_FORMAT ".txt", bench_track_names[track], rows);
+                    char *tide_path = g_build_filename(work_dir, tide_name, NULL);
+                    g_free(tide_name);
+                    if (!bench_prepare_tide(tide_path, track, rows)) {
+                        fprintf(stderr, "無法產生合成潮位資料: %s\n", tide_path);
+                        g_free(tide_path);
+                        failed_cases++;
+                        continue;
+                    }
+
+                    for (guint bi = 0; bi < backend_values->len; bi++) {
+                        BenchBackend backend = (BenchBackend)g_array_index(backend_values, int, bi);
+                        if (backend == BENCH_BACKEND_TIN && !bench_prepare_tin(sep_path)) {
+                            fprintf(stderr, "無法建立三角網: %s\n", sep_path);
+                            failed_cases++;
+                            continue;
+                        }
+
+                        char kind_arg[16], points_arg[32], track_arg[16], rows_arg[32], workers_arg[16], backend_arg[16];
+                        g_snprintf(kind_arg, sizeof(kind_arg), "%d", kind);
+                        g_snprintf(points_arg, sizeof(points_arg), "%" G_GINT64_FORMAT, points);
+                        g_snprintf(track_arg, sizeof(track_arg), "%d", track);
+                        g_snprintf(rows_arg, sizeof(rows_arg), "%" G_GINT64_FORMAT, rows);
+                        g_snprintf(workers_arg, sizeof(workers_arg), "%d", workers);
+                        g_snprintf(backend_arg, sizeof(backend_arg), "%d", backend);
+                        char *child_argv[] = { argv[0], "--run-case", sep_path, tide_path, (char *)label,
+                                               kind_arg, points_arg, track_arg, rows_arg, workers_arg, backend_arg, NULL };
+
+                        // 子行程的標準輸出只有一行 JSON；失敗時沒有輸出
+                        char *child_output = NULL;
+                        GError *spawn_error = NULL;
+                        if (g_spawn_sync(NULL, child_argv, NULL, G_SPAWN_SEARCH_PATH, NULL, NULL,
+                                         &child_output, NULL, NULL, &spawn_error) &&
+                            child_output && *child_output) {
+                            fputs(child_output, out);
+                            fflush(out);
+                            fputs(child_output, stdout);
+                            if (strstr(child_output, "\"ok\":false")) failed_cases++;
+                        } else {
+                            fprintf(stderr, "案例執行失敗: %s / %s: %s\n", sep_path, tide_path,
+                                    spawn_error ? spawn_error->message : "子行程沒有輸出");
+                            failed_cases++;
+                        }
+                        g_clear_error(&spawn_error);
+                        g_free(child_output);
+                    }
+                    g_free(tide_path);
+                }
+            }
+            g_free(sep_path);
+        }
+    }
+
+    fclose(out);
+    g_array_free(kind_values, TRUE);
+    g_array_free(track_values, TRUE);
+    g_array_free(point_values, TRUE);
+    g_array_free(row_values, TRUE);
+    g_array_free(backend_values, TRUE);
+    return failed_cases > 0 ? 1 : 0;
+}
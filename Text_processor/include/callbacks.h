@@ -3,6 +3,8 @@
 
 #include <gtk/gtk.h>
 #include "angle_parser.h" // 為了 AngleAnalysisResult
+#include "progress_channel.h"
+#include "sep_model_cache.h"
 
 // 高程數據結構，用於文件解析
 typedef struct {
@@ -26,15 +28,30 @@ typedef struct {
     GtkWidget *altitude_text_view;      // 高程轉換的文字視圖
     GtkTextBuffer *altitude_text_buffer; // 高程轉換的文字緩衝區
     GtkWidget *elevation_progress_bar;  // 高程轉換專用進度條
+    GtkWidget *raster_check_button;     // 高程轉換：使用預計算調整值網格
+    GtkWidget *raster_resolution_spin;  // 高程轉換：網格解析度（度）
+    GtkWidget *tin_check_button;        // 高程轉換：使用三角網線性內插
+    GtkWidget *tiles_check_button;      // 高程轉換：使用分塊模型
+    GtkWidget *tile_size_spin;          // 高程轉換：分塊大小（度）
+    GtkWidget *shard_count_spin;        // 高程轉換：多行程分段數（0 表示不分段，Windows 上不建立）
+    GtkWidget *filtered_output_combo;   // 高程轉換：過濾結果的輸出方式
+    GtkWidget *tide_format_combo;       // 高程轉換：輸入格式（內建版面或自訂設定）
     GtkWidget *progress_bar;
     GtkWidget *progress_label;
     GtkWidget *progress_container;
     char *selected_folder_path;
     char *selected_file_path;   // 高程轉換選擇的檔案路徑
     char *selected_sep_path;    // 高程轉換選擇的SEP檔案路徑
+    GPtrArray *batch_file_paths; // 高程轉換：批次轉換的檔案清單（char*），NULL 表示單檔模式
+    SepModelCache *sep_model_cache; // 高程轉換：常駐的SEP模型，同一SEP檔案不重複載入
     gboolean is_processing;     // 處理狀態標記
     gboolean cancel_requested;  // 取消請求標記
     GMutex cancel_mutex;        // 保護取消標記的互斥鎖
+    ProgressChannel progress_channel;   // 工作執行緒寫入的進度（無鎖）
+    ProgressSnapshot progress_snapshot; // UI 執行緒上次取樣的結果
+    guint progress_timer_id;            // 進度取樣計時器，0 表示未啟動
+    GtkWidget *progress_target_bar;     // 取樣後更新的進度條
+    GtkWidget *progress_target_label;   // 取樣後更新的標籤，NULL 時訊息顯示在進度條上
 } AppState;
 
 // 異步處理資料結構
@@ -82,6 +99,19 @@ gboolean is_cancel_requested(AppState *state);
  */
 void set_cancel_requested(AppState *state, gboolean cancel);
 
+/**
+ * 重置進度通道並啟動 UI 取樣計時器（UI 執行緒呼叫）
+ *
+ * @param bar 要更新的進度條
+ * @param label 要更新的訊息標籤，NULL 表示訊息顯示在進度條上
+ */
+void progress_view_start(AppState *state, GtkWidget *bar, GtkWidget *label);
+
+/**
+ * 做最後一次取樣後停止 UI 取樣計時器（UI 執行緒呼叫）
+ */
+void progress_view_stop(AppState *state);
+
 /**
  * 初始化應用狀態
  */
@@ -105,7 +135,23 @@ void on_select_file(GtkWidget *widget, gpointer data);
 void on_select_sep_file(GtkWidget *widget, gpointer data);
 
 /**
- * 執行高程轉換的回調函數
+ * 切換高程轉換查詢方式（網格、三角網、分塊模型）的回調函數
+ * 改用分塊模型時取消完整SEP模型的背景預先載入，改回完整模型時重新開始
+ */
+void on_elevation_backend_toggled(GtkToggleButton *button, gpointer data);
+
+/**
+ * 選擇多個檔案進行批次轉換的回調函數
+ */
+void on_select_batch_files(GtkWidget *widget, gpointer data);
+
+/**
+ * 選擇資料夾進行批次轉換的回調函數（資料夾內所有 TXT 檔案）
+ */
+void on_select_batch_folder(GtkWidget *widget, gpointer data);
+
+/**
+ * 執行高程轉換的回調函數（已選擇批次清單時改為批次轉換）
  */
 void on_perform_conversion(GtkWidget *widget, gpointer data);
 
@@ -0,0 +1,92 @@
+// 輸入診斷模組頭文件
+// 收集格式錯誤資料行的統計：每個錯誤類別的次數、前幾筆範例（含行號與內容摘錄），
+// 並以限制頻率的方式把摘要寫到標準錯誤。結構大小固定，記憶體用量與錯誤行數無關
+
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <glib.h>
+
+// 最多的錯誤類別數
+#define DIAGNOSTICS_MAX_CATEGORIES 8
+
+// 保留的範例筆數上限
+#define DIAGNOSTICS_MAX_EXAMPLES 20
+
+// 每筆範例保留的內容長度（含結尾 '\0'）
+#define DIAGNOSTICS_EXAMPLE_TEXT 96
+
+// 標準錯誤摘要的最短間隔（微秒）
+#define DIAGNOSTICS_STDERR_INTERVAL_US (2 * 1000 * 1000)
+
+// 一筆範例
+typedef struct {
+    gint64 line_number;                     // 行號（1 起算）
+    int category;
+    char text[DIAGNOSTICS_EXAMPLE_TEXT];    // 內容摘錄（不含換行）
+} DiagnosticsExample;
+
+// 診斷收集器：不是線程安全的，由單一執行緒記錄（例如依序寫出的一端）
+typedef struct {
+    const char *source;                             // 來源名稱（檔案路徑），用於標準錯誤訊息
+    const char * const *category_names;             // 各類別的說明，長度為 category_count
+    int category_count;
+    guint64 counts[DIAGNOSTICS_MAX_CATEGORIES];
+    guint64 total;
+    int example_count;
+    DiagnosticsExample examples[DIAGNOSTICS_MAX_EXAMPLES];
+    gboolean echo_stderr;                           // 是否寫出到標準錯誤
+    gint64 last_stderr_time;                        // 上次寫出摘要的時間（g_get_monotonic_time）
+    guint64 stderr_reported;                        // 上次寫出摘要時的總數
+} Diagnostics;
+
+/**
+ * 初始化診斷收集器
+ *
+ * @param source 來源名稱，須在收集器使用期間保持有效
+ * @param category_names 各類別的說明（靜態字串陣列），最多 DIAGNOSTICS_MAX_CATEGORIES 個
+ * @param category_count 類別數
+ * @param echo_stderr 是否把範例與定期摘要寫到標準錯誤
+ */
+void diagnostics_init(Diagnostics *diag, const char *source, const char * const *category_names,
+                      int category_count, gboolean echo_stderr);
+
+/**
+ * 記錄一筆格式錯誤的資料行
+ *
+ * 前 DIAGNOSTICS_MAX_EXAMPLES 筆保留為範例（並寫到標準錯誤），之後只計數，
+ * 每隔 DIAGNOSTICS_STDERR_INTERVAL_US 最多寫出一次累計摘要。
+ *
+ * @param category 錯誤類別（0 起算）
+ * @param line_number 行號（1 起算）
+ * @param line 資料行內容，只複製開頭的一小段；可為 NULL
+ * @param length 資料行長度，-1 表示以 '\0' 結尾
+ */
+void diagnostics_record(Diagnostics *diag, int category, gint64 line_number, const char *line, gssize length);
+
+/**
+ * 累加另一個收集器的各類別次數（批次合計用，不合併範例）
+ */
+void diagnostics_merge_counts(Diagnostics *total, const Diagnostics *diag);
+
+/**
+ * 依序附加另一個收集器的範例（分段處理合併用，次數另以 diagnostics_merge_counts 累加）
+ *
+ * 範例的行號加上 line_offset（該段之前的總行數），合併後仍只保留前 DIAGNOSTICS_MAX_EXAMPLES 筆，
+ * 依段落順序合併時與不分段處理保留的範例相同。
+ */
+void diagnostics_merge_examples(Diagnostics *total, const Diagnostics *diag, gint64 line_offset);
+
+/**
+ * 處理結束時把尚未寫出的累計摘要寫到標準錯誤
+ */
+void diagnostics_finish(Diagnostics *diag);
+
+/**
+ * 附加各類別次數與範例到報告；沒有任何錯誤時不附加
+ *
+ * @param title 報告段落的標題
+ */
+void diagnostics_append_report(const Diagnostics *diag, const char *title, GString *report);
+
+#endif // DIAGNOSTICS_H
@@ -4,10 +4,56 @@
 #define ELEVATION_PROCESSING_H
 
 #include <glib.h>
+#include "sep_model_cache.h"
+
+struct _GtkProgressBar;  // GtkProgressBar，不引入 GTK 標頭
 
 // 简化的进度更新回调函数类型（避免与 angle_parser.h 冲突）
 typedef void (*ElevationProgressCallback)(double progress, const char *message);
 
+// 過濾結果的輸出方式
+typedef enum {
+    ELEVATION_FILTERED_REWRITE = 0,  // 以過濾後版本覆寫原始檔案（預設）
+    ELEVATION_FILTERED_NONE,         // 不保留過濾結果，原始檔案保持不變
+    ELEVATION_FILTERED_BITMAP        // 原始檔案保持不變，另存列索引位元圖
+} ElevationFilteredOutput;
+
+// 列索引位元圖 "<輸入檔>.filtered.bitmap" 的格式：
+// ElevationBitmapHeader 之後是每個輸入行一個位元（LSB 優先），1 表示該行通過過濾。
+// 行號與報告中的行號相同（0 起算）；超過 8191 位元組的長行與原本一樣分段計數
+#define ELEVATION_BITMAP_MAGIC "ELVFBMP1"
+
+typedef struct {
+    char magic[8];          // ELEVATION_BITMAP_MAGIC（不含結尾 '\0'）
+    guint64 line_count;     // 輸入行數（位元數）
+    guint64 kept_count;     // 通過過濾的行數
+} ElevationBitmapHeader;
+
+// 檔案轉換的檢查點 "<輸入檔>.checkpoint"：轉換中定期記錄已寫出區塊對應的輸入位置、各輸出檔案的
+// 位置與累計統計。取消、錯誤或當機後以相同的SEP與選項重新轉換同一個檔案時，驗證部分輸出與檢查點
+// 相符後從該位置繼續，而不是從頭開始；轉換成功後刪除檢查點。串流模式不使用檢查點
+#define ELEVATION_CHECKPOINT_DEFAULT_INTERVAL 30.0  // 預設的檢查點間隔（秒）
+
+// 高程轉換選項
+typedef struct {
+    gboolean use_raster;        // 使用預計算調整值網格（雙線性內插）取代逐點插值
+    double raster_resolution;   // 網格解析度（度）
+    gboolean use_tin;           // 使用SEP點的 Delaunay 三角網（三角形內線性內插），與 use_raster 同時設定時以網格為準
+    gboolean use_tiles;         // 使用分塊模型，只載入查詢落入的分塊（與 use_raster、use_tin 同時設定時以完整模型為準）
+    double tile_size;           // 分塊大小（度）
+    int worker_count;           // 平行處理的工作執行緒數，0 表示依處理器數量決定
+    int shard_count;            // 多行程分段轉換的段數（每段一個工作行程，只支援 POSIX 平台且須先呼叫 elevation_set_shard_executable，批次轉換不使用），0 或 1 表示不分段
+    ElevationFilteredOutput filtered_output; // 過濾結果的輸出方式
+    double checkpoint_interval; // 寫出檢查點的間隔（秒），0 表示不寫檢查點也不從檢查點繼續
+    SepModelCache *model_cache; // SEP模型常駐快取，NULL 表示每次轉換重新載入
+    const struct TideFormat *tide_format; // 輸入檔案的格式（已編譯），NULL 表示預設格式
+} ElevationOptions;
+
+/**
+ * 以預設值初始化高程轉換選項（逐點插值）
+ */
+void elevation_options_init(ElevationOptions *options);
+
 /**
  * 處理高程轉換的核心函數
  *
@@ -15,11 +61,12 @@ typedef void (*ElevationProgressCallback)(double progress, const char *message);
  * @param sep_path SEP參數文件的路徑
  * @param result_text 用於存儲處理結果的GString
  * @param error 如果發生錯誤，會設置錯誤信息
- * @param progress_bar 可選的進度條控件，用於顯示處理進度
+ * @param progress_bar 可選的進度條控件（GtkProgressBar），用於顯示處理進度；
+ *                     以結構名稱宣告，只使用其他函數的程式（例如效能基準測試）不必引入 GTK
  *
  * @return TRUE 如果處理成功，FALSE 如果發生錯誤
  */
-gboolean process_elevation_conversion(const char *xyz_path, const char *sep_path, GString *result_text, GError **error, GtkProgressBar *progress_bar);
+gboolean process_elevation_conversion(const char *xyz_path, const char *sep_path, GString *result_text, GError **error, struct _GtkProgressBar *progress_bar);
 
 /**
  * 帶進度回調的高程轉換處理函數（線程安全）
@@ -34,4 +81,81 @@ gboolean process_elevation_conversion(const char *xyz_path, const char *sep_path
  */
 gboolean process_elevation_conversion_with_callback(const char *xyz_path, const char *sep_path, GString *result_text, GError **error, ElevationProgressCallback progress_callback);
 
+/**
+ * 帶選項的高程轉換處理函數（線程安全）
+ *
+ * @param xyz_path 文件路徑
+ * @param sep_path SEP參數文件路徑
+ * @param options 轉換選項，NULL 表示使用預設值
+ * @param result_text 結果字符串
+ * @param error 錯誤信息
+ * @param progress_callback 進度更新回调函数
+ *
+ * @return TRUE 如果處理成功，FALSE 如果發生錯誤
+ */
+gboolean process_elevation_conversion_ex(const char *xyz_path, const char *sep_path, const ElevationOptions *options,
+                                         GString *result_text, GError **error, ElevationProgressCallback progress_callback);
+
+/**
+ * 串流高程轉換：從檔案描述符讀取潮位資料，轉換後的資料行寫到另一個檔案描述符（線程安全）
+ *
+ * 只循序讀寫、不做 seek，輸入與輸出可以是管線；記憶體用量固定，與資料量無關。
+ * 此模式不保留過濾結果（忽略 options->filtered_output），也不會產生 _converted 檔案。
+ * 兩個描述符都不會被關閉。
+ *
+ * @param input_fd 輸入的檔案描述符（例如 0 為標準輸入）
+ * @param output_fd 輸出的檔案描述符（例如 1 為標準輸出）
+ * @param sep_path SEP參數文件路徑
+ * @param options 轉換選項，NULL 表示使用預設值
+ * @param result_text 結果字符串（轉換報告，不會寫到輸出描述符）
+ * @param error 錯誤信息
+ * @param progress_callback 進度更新回调函数，可為 NULL
+ *
+ * @return TRUE 如果處理成功，FALSE 如果發生錯誤
+ */
+gboolean process_elevation_stream(int input_fd, int output_fd, const char *sep_path, const ElevationOptions *options,
+                                  GString *result_text, GError **error, ElevationProgressCallback progress_callback);
+
+/**
+ * 批次高程轉換：SEP 只載入並建立索引一次，多個檔案以工作執行緒池同時轉換（線程安全）
+ *
+ * 每個檔案的輸出與單檔轉換相同。單一檔案失敗不影響其他檔案，報告依輸入順序
+ * 列出各檔案的統計與失敗原因，最後附上合計統計。進度以整批檔案的總位元組數計算，
+ * 進度回調只會在呼叫端執行緒中被呼叫。
+ *
+ * @param input_paths 輸入檔案路徑陣列
+ * @param file_count 檔案數
+ * @param sep_path SEP參數文件路徑
+ * @param options 轉換選項，NULL 表示使用預設值；worker_count 為整批共用的執行緒數
+ * @param result_text 結果字符串
+ * @param error 錯誤信息
+ * @param progress_callback 進度更新回调函数
+ *
+ * @return TRUE 如果批次處理完成（個別檔案可能失敗，見報告），FALSE 如果SEP載入失敗或被取消
+ */
+gboolean process_elevation_batch(const char * const *input_paths, int file_count, const char *sep_path,
+                                 const ElevationOptions *options, GString *result_text, GError **error,
+                                 ElevationProgressCallback progress_callback);
+
+// 分段轉換工作行程的命令列模式（main 在初始化 GTK 之前檢查 argv[1]）
+#define ELEVATION_SHARD_WORKER_ARG "--elevation-shard"
+
+/**
+ * 設定分段轉換工作行程使用的執行檔（本程式），在 main 開頭以 argv[0] 呼叫
+ *
+ * 分段轉換以 posix_spawn 重新執行本程式的 ELEVATION_SHARD_WORKER_ARG 模式，不在多執行緒的
+ * 行程中 fork；未設定（或找不到執行檔）時 shard_count 不生效，改用單一行程的平行管線。
+ */
+void elevation_set_shard_executable(const char *argv0);
+
+/**
+ * 分段轉換工作行程的進入點（argv[1] 為 ELEVATION_SHARD_WORKER_ARG）
+ *
+ * 以記憶體映射重新開啟SEP快取，以單一執行緒轉換父行程指定的輸入範圍，進度、統計與錯誤訊息
+ * 寫入與父行程共用的狀態檔。命令列由分段轉換的父行程產生，不供直接使用。
+ *
+ * @return 行程結束碼，0 表示該段轉換成功
+ */
+int elevation_shard_worker_main(int argc, char **argv);
+
 #endif // ELEVATION_PROCESSING_H
@@ -0,0 +1,91 @@
+// 進度通道模組頭文件
+// 工作執行緒以 atomic 操作寫入進度（不加鎖、不配置記憶體、不觸碰 GTK），
+// UI 執行緒以計時器定期取樣並重繪，多次更新自然合併為一次繪製
+
+#ifndef PROGRESS_CHANNEL_H
+#define PROGRESS_CHANNEL_H
+
+#include <glib.h>
+
+// 進度訊息的最大長度（含結尾 '\0'）
+#define PROGRESS_MESSAGE_SIZE 256
+
+// UI 取樣週期（毫秒，約 20 Hz）
+#define PROGRESS_SAMPLE_INTERVAL_MS 50
+
+// 處理階段
+typedef enum {
+    PROGRESS_PHASE_IDLE = 0,    // 尚未開始
+    PROGRESS_PHASE_PREPARING,   // 準備中（總量未知）
+    PROGRESS_PHASE_RUNNING,     // 處理中
+    PROGRESS_PHASE_DONE         // 已結束
+} ProgressPhase;
+
+// 共享進度狀態：所有欄位只能透過下列函數以 atomic 操作存取
+typedef struct {
+    gint current;           // 目前進度
+    gint total;             // 總量，<= 0 表示未知
+    gint phase;             // ProgressPhase
+    gint version;           // 每次更新遞增，取樣端據此判斷是否需要重繪
+    gint message_sequence;  // 訊息的 seqlock 序號，奇數表示寫入中
+    char message[PROGRESS_MESSAGE_SIZE];
+} ProgressChannel;
+
+// UI 端取樣結果
+typedef struct {
+    int current;
+    int total;
+    ProgressPhase phase;
+    gint version;           // 上次取樣時的版本
+    char message[PROGRESS_MESSAGE_SIZE];
+} ProgressSnapshot;
+
+/**
+ * 重置進度通道（只能在沒有工作執行緒寫入時呼叫）
+ */
+void progress_channel_reset(ProgressChannel *channel);
+
+/**
+ * 設定處理階段
+ */
+void progress_channel_set_phase(ProgressChannel *channel, ProgressPhase phase);
+
+/**
+ * 設定目前進度與總量
+ *
+ * @param total 總量，<= 0 表示未知（UI 以跳動方式顯示）
+ */
+void progress_channel_set_counts(ProgressChannel *channel, int current, int total);
+
+/**
+ * 設定進度訊息
+ *
+ * 另一個執行緒正在寫入訊息時直接略過這次更新，不會等待；
+ * 取樣端本來就只顯示最新狀態，略過的訊息很快會被下一次更新取代。
+ * 超過 PROGRESS_MESSAGE_SIZE 的訊息在 UTF-8 字元邊界截斷。
+ */
+void progress_channel_set_message(ProgressChannel *channel, const char *message);
+
+/**
+ * 以格式字串設定進度訊息（在堆疊緩衝區格式化，不配置記憶體）
+ */
+void progress_channel_set_messagef(ProgressChannel *channel, const char *format, ...) G_GNUC_PRINTF(2, 3);
+
+/**
+ * 取樣目前進度（UI 執行緒呼叫）
+ *
+ * snapshot 需跨次取樣保留：版本與上次相同時不修改內容並回傳 FALSE。
+ * 訊息正好在寫入中而無法取得一致內容時，沿用上次取樣的訊息。
+ *
+ * @return TRUE 表示進度自上次取樣後有變化，需要重繪
+ */
+gboolean progress_channel_sample(const ProgressChannel *channel, ProgressSnapshot *snapshot);
+
+/**
+ * 取得取樣結果的完成比例
+ *
+ * @return 0.0 - 1.0，總量未知時回傳 -1
+ */
+double progress_snapshot_fraction(const ProgressSnapshot *snapshot);
+
+#endif // PROGRESS_CHANNEL_H
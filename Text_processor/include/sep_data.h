@@ -0,0 +1,166 @@
+// SEP 對照資料模組頭文件
+// 負責 SEP 檔案載入、索引結構與高程調整值查詢
+
+#ifndef SEP_DATA_H
+#define SEP_DATA_H
+
+#include <glib.h>
+
+// 查無對照值時的特殊回傳值
+#define SEP_NOT_FOUND -99999.0
+
+// 批次查詢建議的區塊大小（行數）
+#define SEP_BATCH_BLOCK_ROWS 32768
+
+// 分塊模型預設的分塊大小（度）
+#define SEP_TILES_DEFAULT_SIZE 0.25
+
+// SEP 複合資料結構（規則格網密集陣列，或 hash table + 空間網格索引）
+typedef struct SepDataStructure SepDataStructure;
+
+// 批次查詢的可重用工作區（排序鍵、候選清單），每個執行緒各自持有一份
+typedef struct SepLookupContext SepLookupContext;
+
+// 單筆查詢的匹配類型
+typedef enum {
+    SEP_MATCH_NONE = 0,       // 找不到任何對照點
+    SEP_MATCH_EXACT,          // hash table 精確匹配
+    SEP_MATCH_INTERPOLATED,   // 兩近鄰距離加權插值
+    SEP_MATCH_RASTER,         // 預計算調整值網格的雙線性內插
+    SEP_MATCH_TIN             // 三角網的三角形內線性內插
+} SepMatchKind;
+
+// 查詢游標統計（時間連續性快取）
+typedef struct {
+    guint64 lookups;        // 查詢總數
+    guint64 reuse_hits;     // 位置與上一筆相同，直接沿用結果
+    guint64 warm_starts;    // 與上一筆同 cell，以上一筆近鄰的距離作為起始上界
+    guint64 cold_starts;    // 換到新的 cell，重新建立候選清單
+    guint64 lattice_lookups; // 規則格網以索引運算直接查詢
+    guint64 rings_scanned;  // 擴圈搜尋掃描的總圈數（重建候選清單與規則格網查詢）
+} SepLookupStats;
+
+/**
+ * 載入SEP文件並建立所有索引結構
+ *
+ * 優先以唯讀記憶體映射載入 "<sep_path>.sepbin" 二進位快取；快取不存在或
+ * SEP檔案的大小、修改時間、取樣雜湊不符時解析文字檔，並將結果寫回快取。
+ *
+ * @param sep_path SEP檔案路徑
+ *
+ * @return 載入後的資料結構，檔案無法開啟時回傳 NULL
+ */
+SepDataStructure* load_sep_file_optimized(const char *sep_path);
+
+/**
+ * 載入SEP分塊模型，供涵蓋範圍遠大於測量範圍的大型SEP檔案使用
+ *
+ * 分塊檔 "<sep_path>.septiles" 由分塊目錄與各分塊的二進位模型組成，每個分塊包含
+ * 分塊內的點與周圍鄰域（分塊大小的 1/4）內的點。開啟時只讀取目錄，查詢第一次落入
+ * 某個分塊時才映射並建立該分塊的索引，記憶體用量隨測量範圍而非模型大小增加。
+ * 分塊檔不存在或與來源不符時解析文字檔重新建立。
+ *
+ * 查詢先在所在分塊（含鄰域）找兩個最近鄰，第二近鄰可能在鄰域外時再逐圈搜尋周圍的分塊，
+ * 結果與完整模型相同。不支援 sep_data_get_point（預計算網格需使用完整模型）。
+ *
+ * @param sep_path SEP檔案路徑
+ * @param tile_size 分塊大小（度），<= 0 時使用 SEP_TILES_DEFAULT_SIZE
+ *
+ * @return 載入後的資料結構，檔案無法開啟或分塊檔無法寫出時回傳 NULL
+ */
+SepDataStructure* load_sep_file_tiled(const char *sep_path, double tile_size);
+
+/**
+ * 釋放SEP資料結構
+ */
+void sep_data_free(SepDataStructure *data);
+
+/**
+ * 取得已載入的SEP對照點數量
+ */
+int sep_data_point_count(const SepDataStructure *data);
+
+/**
+ * 附加模型來源（二進位快取或文字檔）與索引結構說明（規則格網或一般索引）到報告
+ */
+void sep_data_describe(const SepDataStructure *data, GString *report);
+
+/**
+ * 附加分塊模型目前已載入的分塊數與大小到報告（非分塊模型時不附加）
+ */
+void sep_data_describe_tiles_loaded(const SepDataStructure *data, GString *report);
+
+/**
+ * 取得SEP對照點的經緯度範圍
+ *
+ * @return 沒有任何對照點時回傳 FALSE
+ */
+gboolean sep_data_get_bounds(const SepDataStructure *data, double *min_lon, double *max_lon,
+                             double *min_lat, double *max_lat);
+
+/**
+ * 取得第 index 個SEP對照點（0 <= index < sep_data_point_count）
+ *
+ * 點的順序依索引結構而定（一般索引依空間網格 cell 排列，規則格網依載入順序）；
+ * 規則格網時回傳的是該點所在節點的座標。
+ */
+void sep_data_get_point(const SepDataStructure *data, int index,
+                        double *longitude, double *latitude, double *adjustment);
+
+/**
+ * 取得模型資料大小與載入過程的尖峰記憶體估計值（位元組）
+ *
+ * @param model_bytes 可為 NULL；分塊模型為目前已載入的分塊大小
+ * @param peak_bytes 可為 NULL；由二進位快取載入時等於映射大小
+ */
+void sep_data_memory_usage(const SepDataStructure *data, gsize *model_bytes, gsize *peak_bytes);
+
+/**
+ * 查詢單一座標的調整值（先精確匹配，再以網格插值）
+ *
+ * @param data SEP資料結構
+ * @param longitude 經度
+ * @param latitude 緯度
+ * @param kind 可為 NULL，回傳匹配類型
+ *
+ * @return 調整值，找不到時回傳 SEP_NOT_FOUND
+ */
+double sep_data_lookup(const SepDataStructure *data, double longitude, double latitude, SepMatchKind *kind);
+
+/**
+ * 建立批次查詢工作區
+ */
+SepLookupContext* sep_lookup_context_new(void);
+
+/**
+ * 釋放批次查詢工作區
+ */
+void sep_lookup_context_free(SepLookupContext *ctx);
+
+/**
+ * 取得工作區累計的查詢游標統計
+ */
+void sep_lookup_context_get_stats(const SepLookupContext *ctx, SepLookupStats *stats);
+
+/**
+ * 批次查詢多筆座標的調整值
+ *
+ * 查詢會先依網格 cell 的 Morton 碼排序，同一 cell 的查詢共用同一份近鄰候選清單，
+ * 結果再依原始順序寫回 adjustments / kinds。結果與逐筆呼叫 sep_data_lookup 完全相同。
+ *
+ * 工作區保留上一筆查詢的 cell 與近鄰：位置未變時直接沿用結果，
+ * 同一 cell 時以上一筆近鄰的距離作為搜尋上界，游標可跨區塊延續。
+ *
+ * @param data SEP資料結構
+ * @param ctx 工作區（可跨區塊重複使用）
+ * @param longitudes 經度陣列
+ * @param latitudes 緯度陣列
+ * @param count 查詢筆數
+ * @param adjustments 輸出：調整值，找不到時為 SEP_NOT_FOUND
+ * @param kinds 輸出：匹配類型
+ */
+void sep_data_lookup_batch(const SepDataStructure *data, SepLookupContext *ctx,
+                           const double *longitudes, const double *latitudes, int count,
+                           double *adjustments, SepMatchKind *kinds);
+
+#endif // SEP_DATA_H
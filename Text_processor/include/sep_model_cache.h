@@ -0,0 +1,95 @@
+// SEP 模型常駐快取頭文件
+// 在程式執行期間保留已載入的 SEP 模型，同一個 SEP 檔案再次轉換時不必重新載入與建立索引
+
+#ifndef SEP_MODEL_CACHE_H
+#define SEP_MODEL_CACHE_H
+
+#include <glib.h>
+#include "sep_data.h"
+
+// 預設記憶體上限（位元組），超過時依最近最少使用順序移出快取
+#define SEP_MODEL_CACHE_DEFAULT_LIMIT ((gsize)512 * 1024 * 1024)
+
+// SEP 模型快取（執行緒安全，參考計數）
+typedef struct SepModelCache SepModelCache;
+
+// 快取中的 SEP 模型（參考計數；移出快取後仍可使用，直到最後一個參考釋放）
+typedef struct SepModel SepModel;
+
+// 取得模型的方式
+typedef enum {
+    SEP_MODEL_CACHE_LOADED = 0,   // 快取中沒有，剛才在呼叫端執行緒載入
+    SEP_MODEL_CACHE_PREFETCHED,   // 由背景預先載入（可能等待了載入完成）
+    SEP_MODEL_CACHE_HIT           // 之前的轉換已使用過，直接沿用
+} SepModelCacheResult;
+
+/**
+ * 建立SEP模型快取
+ *
+ * @param memory_limit 記憶體上限（位元組），以 sep_data_memory_usage 的模型大小計算
+ */
+SepModelCache* sep_model_cache_new(gsize memory_limit);
+
+/**
+ * 增加快取的參考
+ */
+SepModelCache* sep_model_cache_ref(SepModelCache *cache);
+
+/**
+ * 釋放快取的參考；背景載入中的執行緒也持有一個參考，完成後才真正釋放
+ */
+void sep_model_cache_unref(SepModelCache *cache);
+
+/**
+ * 在背景執行緒開始載入SEP模型（立即返回）
+ *
+ * 快取中已有相同檔案（路徑、大小、修改時間都相同）或正在載入時不做任何事。
+ */
+void sep_model_cache_prefetch(SepModelCache *cache, const char *sep_path);
+
+/**
+ * 取消尚未被任何轉換取得的預先載入（例如改用分塊模型時）
+ *
+ * 已載入的模型立即移出快取；仍在載入時於載入完成後釋放，期間若有轉換開始等待同一個檔案則保留。
+ */
+void sep_model_cache_cancel_prefetch(SepModelCache *cache, const char *sep_path);
+
+/**
+ * 取得SEP模型的參考，必要時載入（可在任何執行緒呼叫）
+ *
+ * 背景正在載入同一個檔案時等待載入完成；SEP檔案的大小或修改時間改變時重新載入。
+ *
+ * @param result 可為 NULL，回傳取得模型的方式
+ * @param error 載入失敗時設定
+ *
+ * @return 模型參考，使用完畢以 sep_model_unref 釋放；失敗時回傳 NULL
+ */
+SepModel* sep_model_cache_acquire(SepModelCache *cache, const char *sep_path,
+                                  SepModelCacheResult *result, GError **error);
+
+/**
+ * 附加快取目前的模型數與記憶體用量到報告
+ */
+void sep_model_cache_describe(SepModelCache *cache, GString *report);
+
+/**
+ * 以已載入的SEP資料建立不屬於任何快取的模型（取得 data 的所有權，參考數為 1）
+ */
+SepModel* sep_model_new(SepDataStructure *data);
+
+/**
+ * 增加模型的參考
+ */
+SepModel* sep_model_ref(SepModel *model);
+
+/**
+ * 釋放模型的參考，最後一個參考釋放時一併釋放SEP資料
+ */
+void sep_model_unref(SepModel *model);
+
+/**
+ * 取得模型的SEP資料（唯讀，可由多個執行緒同時查詢）
+ */
+const SepDataStructure* sep_model_get_data(const SepModel *model);
+
+#endif // SEP_MODEL_CACHE_H
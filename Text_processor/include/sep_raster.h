@@ -0,0 +1,58 @@
+// SEP 預計算調整值網格模組頭文件
+// 在SEP範圍上以固定解析度預先計算插值結果，查詢時改為雙線性內插（O(1)）
+
+#ifndef SEP_RASTER_H
+#define SEP_RASTER_H
+
+#include <glib.h>
+#include "sep_data.h"
+
+// 預設網格解析度（度）
+#define SEP_RASTER_DEFAULT_RESOLUTION 0.001
+
+// 網格節點數上限，避免解析度過細時耗盡記憶體
+#define SEP_RASTER_MAX_NODES (64 * 1024 * 1024)
+
+// 預計算調整值網格
+typedef struct SepRaster SepRaster;
+
+/**
+ * 載入或建立SEP調整值網格
+ *
+ * 先嘗試讀取與SEP檔案同目錄的 "<sep_path>.raster" 快取；快取不存在、
+ * SEP檔案已變更或解析度不同時重新建立，並將結果寫回快取。
+ * 建立時會與逐點插值比較，誤差報告附加到 report。
+ *
+ * @param sep_path SEP檔案路徑（決定快取位置並檢查是否變更）
+ * @param data 已載入的SEP資料結構
+ * @param resolution 網格解析度（度）
+ * @param report 可為 NULL，附加建立/載入訊息與誤差報告
+ * @param error 發生錯誤時設置錯誤信息
+ *
+ * @return 網格，失敗時回傳 NULL
+ */
+SepRaster* sep_raster_load_or_build(const char *sep_path, const SepDataStructure *data,
+                                    double resolution, GString *report, GError **error);
+
+/**
+ * 釋放調整值網格
+ */
+void sep_raster_free(SepRaster *raster);
+
+/**
+ * 以雙線性內插查詢單一座標的調整值
+ *
+ * @return 調整值，座標落在網格範圍外時回傳 SEP_NOT_FOUND
+ */
+double sep_raster_lookup(const SepRaster *raster, double longitude, double latitude);
+
+/**
+ * 批次查詢多筆座標的調整值
+ *
+ * 網格範圍內的座標 kinds 設為 SEP_MATCH_RASTER；範圍外設為 SEP_MATCH_NONE，
+ * adjustments 為 SEP_NOT_FOUND，由呼叫端改用 sep_data_lookup 處理。
+ */
+void sep_raster_lookup_batch(const SepRaster *raster, const double *longitudes, const double *latitudes,
+                             int count, double *adjustments, SepMatchKind *kinds);
+
+#endif // SEP_RASTER_H
@@ -0,0 +1,48 @@
+// SEP 不規則三角網（TIN）模組頭文件
+// 以SEP點建立 Delaunay 三角網，查詢時從上一筆所在的三角形逐步走訪定位，在三角形內線性內插
+
+#ifndef SEP_TIN_H
+#define SEP_TIN_H
+
+#include <glib.h>
+#include "sep_data.h"
+
+// 三角網可容納的SEP點數上限（三角形數約為點數的兩倍）
+#define SEP_TIN_MAX_POINTS (256 * 1024 * 1024)
+
+// SEP 三角網
+typedef struct SepTin SepTin;
+
+/**
+ * 載入或建立SEP三角網
+ *
+ * 先嘗試以唯讀記憶體映射載入與SEP檔案同目錄的 "<sep_path>.septin" 快取；快取不存在
+ * 或SEP檔案已變更時重新建立，並將結果寫回快取。
+ *
+ * @param sep_path SEP檔案路徑（決定快取位置並檢查是否變更）
+ * @param data 已載入的SEP資料結構
+ * @param report 可為 NULL，附加建立/載入訊息
+ * @param error 發生錯誤時設置錯誤信息
+ *
+ * @return 三角網，失敗時回傳 NULL
+ */
+SepTin* sep_tin_load_or_build(const char *sep_path, const SepDataStructure *data,
+                              GString *report, GError **error);
+
+/**
+ * 釋放三角網
+ */
+void sep_tin_free(SepTin *tin);
+
+/**
+ * 批次查詢多筆座標的調整值
+ *
+ * 每筆查詢從上一筆所在的三角形開始走訪，連續且相鄰的查詢只需幾步即可定位。
+ * 走訪會越過邊界凹處的外圍三角形，不會因三角網邊界內凹而漏掉網內的點。
+ * 三角網內的座標 kinds 設為 SEP_MATCH_TIN；不在任何SEP點構成的三角形內時設為 SEP_MATCH_NONE，
+ * adjustments 為 SEP_NOT_FOUND，由呼叫端改用 sep_data_lookup 處理。
+ */
+void sep_tin_lookup_batch(const SepTin *tin, const double *longitudes, const double *latitudes,
+                          int count, double *adjustments, SepMatchKind *kinds);
+
+#endif // SEP_TIN_H
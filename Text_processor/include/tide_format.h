@@ -0,0 +1,114 @@
+// 潮位資料格式模組頭文件
+// 每個轉換工作可設定分隔符、datetime 寬度與欄位對應；設定編譯為解析函數，
+// 常見版面在編譯期由巨集產生專用的解析函數，其餘版面走通用的對應表解析
+
+#ifndef TIDE_FORMAT_H
+#define TIDE_FORMAT_H
+
+#include <glib.h>
+#include "callbacks.h"  // TideDataRow
+
+// 最多的欄位數（datetime 算一欄）
+#define TIDE_FORMAT_MAX_COLUMNS 16
+
+// 欄位對應的資料
+typedef enum {
+    TIDE_FIELD_DATETIME = 0,    // 日期時間，佔 datetime_fields 個以分隔符隔開的欄位
+    TIDE_FIELD_TIDE,
+    TIDE_FIELD_LONGITUDE,
+    TIDE_FIELD_LATITUDE,
+    TIDE_FIELD_PROCESSED_DEPTH,
+    TIDE_FIELD_COL6,
+    TIDE_FIELD_COL7,
+    TIDE_FIELD_SKIP,            // 忽略此欄
+    TIDE_FIELD_KIND_COUNT
+} TideField;
+
+// 解析失敗的原因（tide_format_diagnose_row）
+typedef enum {
+    TIDE_ROW_ERROR_EMPTY = 0,       // 空行
+    TIDE_ROW_ERROR_FIELD_COUNT,     // 分隔符數量少於格式所需（常見於分隔符或格式設定錯誤）
+    TIDE_ROW_ERROR_DATETIME,        // datetime 為空或過長
+    TIDE_ROW_ERROR_NUMBER,          // 數值欄位為空或無法解析
+    TIDE_ROW_ERROR_OTHER,           // 其他格式錯誤
+    TIDE_ROW_ERROR_COUNT
+} TideRowError;
+
+typedef struct TideFormat TideFormat;
+
+// 編譯後的解析函數：成功時填入 row 的所有欄位
+typedef gboolean (*TideRowParser)(const char *line, TideDataRow *row, const TideFormat *format);
+
+// 潮位資料格式
+struct TideFormat {
+    char delimiter;                            // 欄位分隔符
+    int datetime_fields;                       // datetime 由幾個以分隔符隔開的欄位組成（例如 2024/01/01/12:00:00 為 4）
+    int column_count;                          // columns 的欄位數
+    TideField columns[TIDE_FORMAT_MAX_COLUMNS]; // 依出現順序的欄位對應
+    TideRowParser parse;                       // 由 tide_format_compile 設定
+    const char *layout_name;                   // 使用的專用版面名稱，通用解析時為 NULL
+};
+
+/**
+ * 取得預設格式（datetime/tide/經度/緯度/ProcessedDepth/col6/col7，datetime 佔 4 欄）
+ */
+const TideFormat* tide_format_default(void);
+
+/**
+ * 編譯格式：檢查設定並選擇解析函數
+ *
+ * 設定與內建版面完全相同時使用編譯期產生的專用函數，否則使用通用的對應表解析。
+ * datetime、tide、經緯度、ProcessedDepth、col6、col7 都必須各對應一欄。
+ *
+ * @return TRUE 如果設定有效
+ */
+gboolean tide_format_compile(TideFormat *format, GError **error);
+
+/**
+ * 由文字設定建立格式
+ *
+ * 可以是內建版面名稱（slash、csv、csv-latlon、tab），或以分號隔開的設定，例如
+ * "delimiter=,;datetime=1;columns=datetime,lat,lon,tide,depth,col6,col7"。
+ * delimiter 可為單一字元或 tab、space、semicolon；columns 可用的名稱為 datetime、tide、lon、lat、
+ * depth、col6、col7、skip。未指定的項目沿用預設格式。結果已經編譯。
+ *
+ * @return TRUE 如果設定有效
+ */
+gboolean tide_format_from_spec(TideFormat *format, const char *spec, GError **error);
+
+/**
+ * 把格式轉回文字設定（tide_format_from_spec 可還原為相同的格式）
+ *
+ * 使用內建版面時回傳版面名稱，否則回傳完整的 delimiter、datetime 與 columns 設定。
+ *
+ * @return 新配置的字串，以 g_free 釋放
+ */
+char* tide_format_to_spec(const TideFormat *format);
+
+/**
+ * 取得內建版面的數量與名稱（供介面列出選項）
+ */
+int tide_format_builtin_count(void);
+const char* tide_format_builtin_name(int index);
+
+/**
+ * 附加格式說明到報告（欄位順序與使用的解析方式）
+ */
+void tide_format_describe(const TideFormat *format, GString *report);
+
+/**
+ * 以格式解析一行潮位資料
+ */
+gboolean tide_format_parse_row(const TideFormat *format, const char *line, TideDataRow *row);
+
+/**
+ * 判斷一行資料解析失敗的原因（只在解析失敗後呼叫，不影響正常解析的速度）
+ */
+TideRowError tide_format_diagnose_row(const TideFormat *format, const char *line);
+
+/**
+ * 取得解析失敗原因的說明（長度為 TIDE_ROW_ERROR_COUNT，依 TideRowError 的順序）
+ */
+const char * const * tide_format_row_error_names(void);
+
+#endif // TIDE_FORMAT_H
@@ -8,8 +8,21 @@
 #include "scan.h"
 #include "safe_getline.h"
 #include "max_finder.h"
+#include "diagnostics.h"
 #include "callbacks.h" // 為了存取 AppState 和 is_cancel_requested
 
+// 角度資料行的錯誤類別（順序與 angle_line_error_names 相同）
+typedef enum {
+    ANGLE_LINE_ERROR_FIELD_COUNT = 0,   // 無法解析出三個數字
+    ANGLE_LINE_ERROR_NEGATIVE,          // 前兩段數字為負值
+    ANGLE_LINE_ERROR_NOT_FINITE,        // 角度為 NaN 或無限值
+    ANGLE_LINE_ERROR_COUNT
+} AngleLineError;
+
+static const char * const angle_line_error_names[ANGLE_LINE_ERROR_COUNT] = {
+    "欄位數不足", "負值", "角度為 NaN/Inf"
+};
+
 // 全局 mutex 保護 hash table 操作
 static GMutex angle_parser_mutex;
 static gboolean mutex_initialized = FALSE;
@@ -18,7 +31,7 @@ static gboolean mutex_initialized = FALSE;
 static int is_result_file(const char *filename);
 static int expand_angle_range_array(AngleAnalysisResult *result);
 static AngleAnalysisResult init_angle_analysis_result(void);
-static int parse_angle_line(const char *line, AngleData *data);
+static int parse_angle_line(const char *line, AngleData *data, int *error_category);
 static void update_angle_range(GHashTable *ranges_table, const AngleData *data);
 static void ensure_mutex_initialized(void);
 
@@ -70,7 +83,10 @@ static int expand_angle_range_array(AngleAnalysisResult *result) {
 }
 
 // 解析單行角度資料
-static int parse_angle_line(const char *line, AngleData *data) {
+// 失敗時 error_category 設為 AngleLineError；空行與註解不算錯誤，error_category 設為 -1
+// 錯誤不在這裡逐行輸出，由呼叫端的診斷收集器計數並限制輸出頻率
+static int parse_angle_line(const char *line, AngleData *data, int *error_category) {
+    *error_category = -1;
     if (!line || !data) {
         g_printerr("Error: parse_angle_line called with NULL parameters\n");
         return 0;
@@ -83,27 +99,20 @@ static int parse_angle_line(const char *line, AngleData *data) {
 
     // 嘗試解析三個數字
     int parsed = sscanf(line, "%d %d %lf", &data->first_num, &data->second_num, &data->third_num);
-    if (parsed == EOF) {
-        g_printerr("Warning: EOF encountered while parsing line\n");
-        return 0;
-    }
     if (parsed != 3) {
-        // 詳細錯誤報告
-        g_printerr("Warning: Failed to parse line (got %d/3 fields): %.50s\n", parsed, line);
+        *error_category = ANGLE_LINE_ERROR_FIELD_COUNT;
         return 0;
     }
 
     // 基本有效性檢查
     if (data->first_num < 0 || data->second_num < 0) {
-        g_printerr("Warning: Invalid negative values in line: %d %d %f\n",
-                  data->first_num, data->second_num, data->third_num);
+        *error_category = ANGLE_LINE_ERROR_NEGATIVE;
         return 0;
     }
 
     // 檢查 NaN 和無限值
     if (!isfinite(data->third_num)) {
-        g_printerr("Warning: Invalid angle value (NaN/Inf) in line: %d %d %f\n",
-                  data->first_num, data->second_num, data->third_num);
+        *error_category = ANGLE_LINE_ERROR_NOT_FINITE;
         return 0;
     }
 
@@ -194,6 +203,10 @@ AngleAnalysisResult parse_angle_file(const char *file_path, void *user_data) {
         goto cleanup;
     }
 
+    // 格式錯誤的行只計數並保留前幾筆範例，標準錯誤輸出限制頻率
+    Diagnostics diagnostics;
+    diagnostics_init(&diagnostics, file_path, angle_line_error_names, ANGLE_LINE_ERROR_COUNT, TRUE);
+
     int line_number = 0;
     while ((line = safe_getline(file)) != NULL) {
         line_number++;
@@ -204,18 +217,23 @@ AngleAnalysisResult parse_angle_file(const char *file_path, void *user_data) {
                 result.error = g_strdup("操作已取消");
                 free(line);
                 line = NULL;
+                diagnostics_finish(&diagnostics);
                 goto cleanup;
             }
         }
 
         AngleData data;
-        if (parse_angle_line(line, &data)) {
+        int error_category;
+        if (parse_angle_line(line, &data, &error_category)) {
             update_angle_range(ranges_table, &data);
+        } else if (error_category >= 0) {
+            diagnostics_record(&diagnostics, error_category, line_number, line, -1);
         }
 
         free(line);
         line = NULL;
     }
+    diagnostics_finish(&diagnostics);
 
     // 檢查是否是因為錯誤而結束
     if (ferror(file)) {
@@ -8,6 +8,7 @@
 #include "angle_parser.h"
 #include "max_finder.h"
 #include "elevation_processing.h"
+#include "tide_format.h"
 
 // 延遲捲動用的數據結構
 typedef struct {
@@ -41,6 +42,7 @@ void init_app_state(AppState *state) {
     g_mutex_init(&state->cancel_mutex);
     state->cancel_requested = FALSE;
     state->is_processing = FALSE;
+    state->sep_model_cache = sep_model_cache_new(SEP_MODEL_CACHE_DEFAULT_LIMIT);
 }
 
 // 清理應用狀態
@@ -50,10 +52,74 @@ void cleanup_app_state(AppState *state) {
     g_free(state->selected_folder_path);
     g_free(state->selected_file_path);
     g_free(state->selected_sep_path);
+    if (state->batch_file_paths) {
+        g_ptr_array_free(state->batch_file_paths, TRUE);
+    }
+    if (state->progress_timer_id) {
+        g_source_remove(state->progress_timer_id);
+    }
+    sep_model_cache_unref(state->sep_model_cache);
     g_mutex_clear(&state->cancel_mutex);
     memset(state, 0, sizeof(AppState));
 }
 
+// 將進度取樣結果繪製到目標元件
+static void progress_view_render(AppState *state) {
+    ProgressSnapshot *snapshot = &state->progress_snapshot;
+
+    if (state->progress_target_bar) {
+        GtkProgressBar *bar = GTK_PROGRESS_BAR(state->progress_target_bar);
+        double fraction = progress_snapshot_fraction(snapshot);
+        if (fraction >= 0.0) {
+            gtk_progress_bar_set_fraction(bar, fraction);
+        } else if (snapshot->phase == PROGRESS_PHASE_RUNNING) {
+            gtk_progress_bar_pulse(bar); // 總量未知時以跳動方式顯示仍在處理
+        }
+
+        if (!state->progress_target_label && snapshot->message[0]) {
+            gtk_progress_bar_set_text(bar, snapshot->message);
+        }
+    }
+
+    if (state->progress_target_label && snapshot->message[0]) {
+        gtk_label_set_text(GTK_LABEL(state->progress_target_label), snapshot->message);
+    }
+}
+
+// 進度取樣計時器（UI 執行緒）：只有進度有變化時才重繪
+static gboolean progress_view_timeout(gpointer user_data) {
+    AppState *state = (AppState *)user_data;
+
+    if (progress_channel_sample(&state->progress_channel, &state->progress_snapshot)) {
+        progress_view_render(state);
+    }
+
+    return G_SOURCE_CONTINUE;
+}
+
+// 重置進度通道並啟動 UI 取樣計時器
+void progress_view_start(AppState *state, GtkWidget *bar, GtkWidget *label) {
+    if (!state) return;
+
+    progress_view_stop(state);
+    progress_channel_reset(&state->progress_channel);
+    state->progress_snapshot.version = g_atomic_int_get(&state->progress_channel.version);
+    state->progress_target_bar = bar;
+    state->progress_target_label = label;
+    state->progress_timer_id = g_timeout_add(PROGRESS_SAMPLE_INTERVAL_MS, progress_view_timeout, state);
+}
+
+// 做最後一次取樣後停止 UI 取樣計時器
+void progress_view_stop(AppState *state) {
+    if (!state || !state->progress_timer_id) return;
+
+    progress_view_timeout(state);
+    g_source_remove(state->progress_timer_id);
+    state->progress_timer_id = 0;
+    state->progress_target_bar = NULL;
+    state->progress_target_label = NULL;
+}
+
 // 檢查是否請求取消
 gboolean is_cancel_requested(AppState *state) {
     if (!state) return FALSE;
@@ -113,6 +179,7 @@ void set_processing_state(AppState *state, gboolean processing) {
             }
         }
     } else {
+        progress_view_stop(state);
         gtk_widget_hide(state->progress_container);
         gtk_widget_hide(state->cancel_button);
         // 重置取消標記
@@ -135,117 +202,22 @@ typedef struct {
     GString *parsed_info; // 解析后的字段信息
 } FileAnalysisResult;
 
-// 解析Tide數據行
-// 潮汐資料格式描述結構 - 支援自訂格式
-typedef struct {
-    char delimiter;           // 欄位分隔符
-    int datetime_delimiters;  // datetime欄位結束的分隔符數量
-    int numeric_fields;       // 數值欄位數量
-} TideFormat;
-
-// 預設格式定義（當前使用的格式：datetime/tide/longitude/latitude/ProcessedDepth/col6/col7）
-const TideFormat CURRENT_TIDE_FORMAT = {
-    .delimiter = '/',
-    .datetime_delimiters = 4,
-    .numeric_fields = 6
-};
-
-// 解析Tide數據行 —— 高速版（零配置 + 指標走訪 + strtod）
-// 通用版本：支援自訂格式
-// 說明：避免 g_strdup 與 sscanf，改用指標掃描與 strtod，顯著減少每行開銷。
-//
-// 格式限制：
-// - datetime 必須有指定數量的分隔符結束
-// - 數值欄位必須是有效的浮點數
-// - 使用指定字符作為欄位分隔符
-//
-// 效能特點：
-// - 零動態配置：無 malloc/free 呼叫
-// - 指標走訪：直接在原字串操作
-// - strtod 解析：高效浮點數轉換
-gboolean parse_tide_data_row_ex(const char *line, TideDataRow *row,
-                               const TideFormat *format) {
-    if (!line || !row || !format) return FALSE;
-
-    const char *p = line;
-
-    // 1) 跳過前導空白
-    while (*p == ' ' || *p == '\t' || *p == '\r') p++;
-
-    // 2) 找出 datetime 的結束位置（第 datetime_delimiters 個 delimiter）
-    const char *q = p;
-    int delimiter_count = 0;
-    for (; *q; ++q) {
-        if (*q == format->delimiter) {
-            ++delimiter_count;
-            if (delimiter_count == format->datetime_delimiters) break;
-        }
-    }
-    if (delimiter_count != format->datetime_delimiters || *q != format->delimiter) {
-        return FALSE; // 格式不含足夠的分隔符來結束 datetime
-    }
-
-    // 3) 複製 datetime（不配置臨時字串）
-    size_t dt_len = (size_t)(q - p);
-    if (dt_len == 0 || dt_len >= sizeof(row->datetime)) {
-        return FALSE; // datetime 太長或為空
-    }
-    memcpy(row->datetime, p, dt_len);
-    row->datetime[dt_len] = '\0';
-
-    // 4) 依序解析指定數量的數值欄位
-    p = q + 1; // 跳過 datetime 結束的分隔符
-
-    char *end = NULL;
-
-    // 根據數值欄位數量動態解析
-    // 注意：目前實作假設欄位順序固定為 tide/longitude/latitude/processed_depth/col6/col7
-    // 如果需要支援不同欄位順序，可以進一步擴展 TideFormat 結構
-    if (format->numeric_fields >= 1) {
-        row->tide = strtod(p, &end);
-        if (end == p || (format->numeric_fields > 1 && *end != format->delimiter)) return FALSE;
-        p = end + 1;
-    }
-
-    if (format->numeric_fields >= 2) {
-        row->longitude = strtod(p, &end);
-        if (end == p || (format->numeric_fields > 2 && *end != format->delimiter)) return FALSE;
-        p = end + 1;
-    }
-
-    if (format->numeric_fields >= 3) {
-        row->latitude = strtod(p, &end);
-        if (end == p || (format->numeric_fields > 3 && *end != format->delimiter)) return FALSE;
-        p = end + 1;
-    }
-
-    if (format->numeric_fields >= 4) {
-        row->processed_depth = strtod(p, &end);
-        if (end == p || (format->numeric_fields > 4 && *end != format->delimiter)) return FALSE;
-        p = end + 1;
-    }
-
-    if (format->numeric_fields >= 5) {
-        row->col6 = strtod(p, &end);
-        if (end == p || (format->numeric_fields > 5 && *end != format->delimiter)) return FALSE;
-        p = end + 1;
-    }
-
-    if (format->numeric_fields >= 6) {
-        row->col7 = strtod(p, &end);
-        if (end == p) return FALSE;
-    }
-
-    // 至此成功；尾端可能有換行或其他字元，無需特別處理
-    return TRUE;
+// 解析Tide數據行 —— 使用預設格式（datetime/tide/longitude/latitude/ProcessedDepth/col6/col7）
+// 其他格式見 tide_format.h
+gboolean parse_tide_data_row(const char *line, TideDataRow *row) {
+    if (!line || !row) return FALSE;
+    return tide_format_parse_row(tide_format_default(), line, row);
 }
 
-// 解析Tide數據行 —— 高速版（零配置 + 指標走訪 + strtod）
-// 向後相容版本：使用預設格式
-// 格式：datetime/tide/longitude/latitude/ProcessedDepth/col6/col7
-// 說明：避免 g_strdup 與 sscanf，改用指標掃描與 strtod，顯著減少每行開銷。
-gboolean parse_tide_data_row(const char *line, TideDataRow *row) {
-    return parse_tide_data_row_ex(line, row, &CURRENT_TIDE_FORMAT);
+// 讀取高程轉換頁籤選擇的輸入格式（內建版面名稱或自訂設定），空白時使用預設格式
+static gboolean get_selected_tide_format(AppState *state, TideFormat *format, GError **error) {
+    char *spec = NULL;
+    if (state->tide_format_combo) {
+        spec = gtk_combo_box_text_get_active_text(GTK_COMBO_BOX_TEXT(state->tide_format_combo));
+    }
+    gboolean ok = tide_format_from_spec(format, spec, error);
+    g_free(spec);
+    return ok;
 }
 
 // 清理檔案分析結果
@@ -371,7 +343,14 @@ void on_select_file(GtkWidget *widget, gpointer data) {
             if (is_elevation_format) {
                 // 高程數據格式分析 - 簡化驗證結果顯示
                 g_string_append_printf(display_text, "檔案格式: 高程數據 (7欄)\n");
-                g_string_append_printf(display_text, "期望格式: datetime/tide/經度/緯度/ProcessedDepth/col6/col7\n\n");
+                // 以目前選擇的輸入格式驗證，設定有誤時退回預設格式
+                TideFormat preview_format;
+                if (!get_selected_tide_format(state, &preview_format, NULL)) {
+                    preview_format = *tide_format_default();
+                }
+                g_string_append_printf(display_text, "期望");
+                tide_format_describe(&preview_format, display_text);
+                g_string_append_c(display_text, '\n');
 
                 // 簡化格式驗證邏輯
                 int valid_lines = 0;
@@ -391,7 +370,7 @@ void on_select_file(GtkWidget *widget, gpointer data) {
 
                     // 試著解析7欄數據
                     TideDataRow test_row;
-                    if (parse_tide_data_row(analysis_result->lines[i], &test_row)) {
+                    if (tide_format_parse_row(&preview_format, analysis_result->lines[i], &test_row)) {
                         valid_lines++;
 
                         // 檢查過濾條件
@@ -490,9 +469,13 @@ void on_select_file(GtkWidget *widget, gpointer data) {
         }
     }
 
-    // 儲存選擇的檔案路徑（用於高程轉換）
+    // 儲存選擇的檔案路徑（用於高程轉換），並回到單檔模式
     g_free(state->selected_file_path);
     state->selected_file_path = g_strdup(filename);
+    if (state->batch_file_paths) {
+        g_ptr_array_free(state->batch_file_paths, TRUE);
+        state->batch_file_paths = NULL;
+    }
 
     gtk_text_buffer_set_text(target_buffer, display_text->str, -1);
     g_string_free(display_text, TRUE);
@@ -537,6 +520,36 @@ void on_select_file(GtkWidget *widget, gpointer data) {
     gtk_widget_destroy(dialog);
 }
 
+// 目前的選項是否使用分塊模型（與網格或三角網同時勾選時以完整模型為準，與 elevation_processing 相同）
+static gboolean elevation_tiles_selected(AppState *state) {
+    if (!state->tiles_check_button ||
+        !gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(state->tiles_check_button))) {
+        return FALSE;
+    }
+    if (state->raster_check_button &&
+        gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(state->raster_check_button))) {
+        return FALSE;
+    }
+    if (state->tin_check_button &&
+        gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(state->tin_check_button))) {
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void on_elevation_backend_toggled(GtkToggleButton *button, gpointer data) {
+    (void)button;
+    AppState *state = (AppState *)data;
+    if (!state->selected_sep_path) return;
+
+    // 分塊模型不使用常駐快取，預先載入的完整模型只會佔用記憶體
+    if (elevation_tiles_selected(state)) {
+        sep_model_cache_cancel_prefetch(state->sep_model_cache, state->selected_sep_path);
+    } else {
+        sep_model_cache_prefetch(state->sep_model_cache, state->selected_sep_path);
+    }
+}
+
 // 選擇SEP檔案的回調函數
 void on_select_sep_file(GtkWidget *widget, gpointer data) {
     (void)widget;  // 壓制警告
@@ -578,6 +591,12 @@ void on_select_sep_file(GtkWidget *widget, gpointer data) {
         g_free(state->selected_sep_path);
         state->selected_sep_path = g_strdup(filename);
 
+        // 立即在背景載入並建立索引，按下執行轉換時多半已經完成；分塊模型只載入用到的分塊，不預先載入完整模型
+        gboolean prefetch = !elevation_tiles_selected(state);
+        if (prefetch) {
+            sep_model_cache_prefetch(state->sep_model_cache, filename);
+        }
+
         // 在結果區域顯示SEP檔案確認訊息 (追加到現有文字後)
         GString *confirm_text = g_string_new("\n");
         g_string_append_printf(confirm_text, "SEP檔案確認:\n");
@@ -585,6 +604,11 @@ void on_select_sep_file(GtkWidget *widget, gpointer data) {
         g_string_append_printf(confirm_text, "SEP檔案已選擇\n");
         g_string_append_printf(confirm_text, "檔案路徑: %s\n", filename);
         g_string_append_printf(confirm_text, "\n此SEP檔案將用於高程轉換的地理空間插值處理。\n");
+        if (prefetch) {
+            g_string_append_printf(confirm_text, "已在背景開始載入SEP模型，載入後保留供之後的轉換使用。\n");
+        } else {
+            g_string_append_printf(confirm_text, "使用分塊模型，轉換時只載入資料點所在的分塊。\n");
+        }
 
         // 根據當前活動標籤頁選擇正確的緩衝區和視圖
         GtkTextBuffer *target_buffer = state->text_buffer;
@@ -634,6 +658,119 @@ void on_select_sep_file(GtkWidget *widget, gpointer data) {
     gtk_widget_destroy(dialog);
 }
 
+// 設定批次轉換的檔案清單（取代單檔選擇），並在高程轉換結果區顯示清單
+static void set_batch_file_list(AppState *state, GPtrArray *paths, const char *source) {
+    if (state->batch_file_paths) {
+        g_ptr_array_free(state->batch_file_paths, TRUE);
+    }
+    state->batch_file_paths = paths;
+    g_free(state->selected_file_path);
+    state->selected_file_path = NULL;
+
+    GString *display_text = g_string_new("");
+    g_string_append_printf(display_text, "批次轉換檔案清單:\n");
+    g_string_append_printf(display_text, "===========================================\n");
+    g_string_append_printf(display_text, "來源: %s\n", source);
+    g_string_append_printf(display_text, "檔案數: %u\n\n", paths->len);
+    for (guint i = 0; i < paths->len; i++) {
+        g_string_append_printf(display_text, "%3u. %s\n", i + 1, (const char *)g_ptr_array_index(paths, i));
+    }
+    g_string_append_printf(display_text, "\n所有檔案將共用同一份SEP模型進行轉換。\n");
+
+    if (state->altitude_text_buffer) {
+        gtk_text_buffer_set_text(state->altitude_text_buffer, display_text->str, -1);
+    }
+    g_string_free(display_text, TRUE);
+
+    char *status_text = g_strdup_printf("已選擇 %u 個檔案進行批次轉換", paths->len);
+    gtk_label_set_text(GTK_LABEL(state->status_label), status_text);
+    g_free(status_text);
+}
+
+// 選擇多個檔案進行批次轉換的回調函數
+void on_select_batch_files(GtkWidget *widget, gpointer data) {
+    (void)widget;  // 壓制警告
+    AppState *state = (AppState *)data;
+
+    GtkWidget *dialog = gtk_file_chooser_dialog_new("選擇批次轉換檔案",
+                                                    GTK_WINDOW(state->window),
+                                                    GTK_FILE_CHOOSER_ACTION_OPEN,
+                                                    "_取消",
+                                                    GTK_RESPONSE_CANCEL,
+                                                    "_選擇",
+                                                    GTK_RESPONSE_ACCEPT,
+                                                    NULL);
+    gtk_file_chooser_set_select_multiple(GTK_FILE_CHOOSER(dialog), TRUE);
+
+    GtkFileFilter *filter = gtk_file_filter_new();
+    gtk_file_filter_set_name(filter, "文字檔案");
+    gtk_file_filter_add_pattern(filter, "*.txt");
+    gtk_file_filter_add_pattern(filter, "*.csv");
+    gtk_file_filter_add_pattern(filter, "*");
+    gtk_file_chooser_add_filter(GTK_FILE_CHOOSER(dialog), filter);
+
+    if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_ACCEPT) {
+        GSList *filenames = gtk_file_chooser_get_filenames(GTK_FILE_CHOOSER(dialog));
+        GPtrArray *paths = g_ptr_array_new_with_free_func(g_free);
+        for (GSList *item = filenames; item; item = item->next) {
+            g_ptr_array_add(paths, item->data);  // 路徑字串的所有權轉移給清單
+        }
+        g_slist_free(filenames);
+
+        if (paths->len > 0) {
+            set_batch_file_list(state, paths, "手動選擇的檔案");
+        } else {
+            g_ptr_array_free(paths, TRUE);
+            gtk_label_set_text(GTK_LABEL(state->status_label), "未選擇任何檔案");
+        }
+    }
+
+    gtk_widget_destroy(dialog);
+}
+
+// 選擇資料夾進行批次轉換的回調函數（資料夾內所有 TXT 檔案，排除轉換結果檔案）
+void on_select_batch_folder(GtkWidget *widget, gpointer data) {
+    (void)widget;  // 壓制警告
+    AppState *state = (AppState *)data;
+
+    GtkWidget *dialog = gtk_file_chooser_dialog_new("選擇批次轉換資料夾",
+                                                    GTK_WINDOW(state->window),
+                                                    GTK_FILE_CHOOSER_ACTION_SELECT_FOLDER,
+                                                    "_取消",
+                                                    GTK_RESPONSE_CANCEL,
+                                                    "_選擇",
+                                                    GTK_RESPONSE_ACCEPT,
+                                                    NULL);
+
+    if (gtk_dialog_run(GTK_DIALOG(dialog)) == GTK_RESPONSE_ACCEPT) {
+        char *folder = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(dialog));
+        ScanResult scan = scan_txt_files(folder);
+
+        if (!scan.success) {
+            gtk_label_set_text(GTK_LABEL(state->status_label), scan.error ? scan.error : "掃描資料夾失敗");
+        } else {
+            GPtrArray *paths = g_ptr_array_new_with_free_func(g_free);
+            for (int i = 0; i < scan.count; i++) {
+                // 排除之前轉換產生的 *_converted.* 檔案
+                if (strstr(scan.files[i].name, "_converted")) continue;
+                g_ptr_array_add(paths, g_build_filename(folder, scan.files[i].name, NULL));
+            }
+
+            if (paths->len > 0) {
+                set_batch_file_list(state, paths, folder);
+            } else {
+                g_ptr_array_free(paths, TRUE);
+                gtk_label_set_text(GTK_LABEL(state->status_label), "資料夾中沒有可轉換的 TXT 檔案");
+            }
+        }
+
+        free_scan_result(&scan);
+        g_free(folder);
+    }
+
+    gtk_widget_destroy(dialog);
+}
+
 // 高程轉換處理工作線程數據
 typedef struct {
     AppState *app_state;
@@ -641,33 +778,20 @@ typedef struct {
     GError *error;
     char *input_path;
     char *sep_path;
-    double current_progress;
-    char progress_text[200];
+    char **batch_paths;     // 批次轉換的檔案清單（NULL 結尾），NULL 表示單檔模式
+    TideFormat tide_format; // 輸入格式（options.tide_format 指向此處）
+    ElevationOptions options;
 } ElevationProcessData;
 
 
-
-// 更新進度條的回調函數（線程安全）
-static gboolean update_progress_callback(gpointer user_data) {
-    ElevationProcessData *data = (ElevationProcessData*)user_data;
-
-    if (data->app_state->elevation_progress_bar) {
-        // 正確設置進度：將百分比轉為0.0-1.0範圍
-        double fraction = data->current_progress / 100.0;
-        fraction = CLAMP(fraction, 0.0, 1.0); // 確保範圍正確
-
-        gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(data->app_state->elevation_progress_bar), fraction);
-        gtk_progress_bar_set_text(GTK_PROGRESS_BAR(data->app_state->elevation_progress_bar), data->progress_text);
-    }
-
-    return FALSE; // 只執行一次
-}
-
 // 更新最終結果的回調函數（線程安全）
 static gboolean update_result_callback(gpointer user_data) {
     ElevationProcessData *data = (ElevationProcessData*)user_data;
     AppState *state = data->app_state;
 
+    // 停止進度取樣，以下的最終狀態不會再被覆寫
+    progress_view_stop(state);
+
     // 恢復按鈕狀態 - 重新啟用執行按鈕，禁用停止按鈕
     GtkWidget *convert_button = GTK_WIDGET(g_object_get_data(G_OBJECT(state->window), "convert_button"));
     if (convert_button) {
@@ -747,6 +871,8 @@ static gboolean update_result_callback(gpointer user_data) {
     }
     g_free(data->input_path);
     g_free(data->sep_path);
+    g_strfreev(data->batch_paths);
+    sep_model_cache_unref(data->options.model_cache);
     g_free(data);
 
     return FALSE; // 只執行一次
@@ -760,24 +886,21 @@ static void* elevation_conversion_worker(void *user_data) {
     data->result_text = g_string_new("");
     data->error = NULL;
 
-    // 創建進度更新上下文
-    typedef struct {
-        ElevationProcessData *data;
-    } ProgressContext;
+    ProgressChannel *channel = &data->app_state->progress_channel;
 
-    ProgressContext *ctx = g_new(ProgressContext, 1);
-    ctx->data = data;
-
-    // 進度更新回調函數 (線程安全)
+    // 進度更新回調函數（工作執行緒呼叫）：只寫入進度通道，由 UI 計時器取樣重繪
+    // percentage 為 0-100，小於 0 表示總量未知
     void progress_update_callback(double percentage, const char *message) {
-        ctx->data->current_progress = percentage;
-        strncpy(ctx->data->progress_text, message, sizeof(ctx->data->progress_text) - 1);
-
-        // 通過 GTK 的異步機制通知主線程更新UI
-        g_idle_add(update_progress_callback, ctx->data);
+        if (percentage >= 0.0) {
+            progress_channel_set_counts(channel, (int)(percentage * 10.0), 1000);
+        } else {
+            progress_channel_set_counts(channel, 0, 0);
+        }
+        progress_channel_set_message(channel, message);
     }
 
     // 開始處理 - 通過回調初始化進度
+    progress_channel_set_phase(channel, PROGRESS_PHASE_RUNNING);
     progress_update_callback(0.0, "準備處理...");
 
     // 調用高程轉換處理函數（使用回調版本）
@@ -797,24 +920,32 @@ static void* elevation_conversion_worker(void *user_data) {
     }
 
 
-    if (!process_elevation_conversion_with_callback(data->input_path, data->sep_path,
-                                          data->result_text, &data->error,
-                                          progress_callback_with_cancel)) {
+    gboolean success;
+    if (data->batch_paths) {
+        success = process_elevation_batch((const char * const *)data->batch_paths,
+                                          (int)g_strv_length(data->batch_paths), data->sep_path,
+                                          &data->options, data->result_text, &data->error,
+                                          progress_callback_with_cancel);
+    } else {
+        success = process_elevation_conversion_ex(data->input_path, data->sep_path, &data->options,
+                                                  data->result_text, &data->error,
+                                                  progress_callback_with_cancel);
+    }
+
+    if (!success) {
         // 處理失敗 - 立即通知主線程
+        progress_channel_set_phase(channel, PROGRESS_PHASE_DONE);
         g_idle_add(update_result_callback, data);
-        g_free(ctx);
         return NULL;
     }
 
     // 處理成功 - 最終進度更新
-    progress_update_callback(1.0, "處理完成");
+    progress_update_callback(100.0, "處理完成");
+    progress_channel_set_phase(channel, PROGRESS_PHASE_DONE);
 
     // 通知主線程處理完成并顯示結果
     g_idle_add(update_result_callback, data);
 
-    // 清理資源
-    g_free(ctx);
-
     return NULL;
 }
 
@@ -823,12 +954,14 @@ void on_perform_conversion(GtkWidget *widget, gpointer data) {
     (void)widget;  // 壓制警告
     AppState *state = (AppState *)data;
 
-    // 檢查必要的文件是否都已選擇
-    if (!state->selected_file_path || !state->selected_sep_path) {
+    // 檢查必要的文件是否都已選擇（單檔或批次清單）
+    gboolean batch_mode = state->batch_file_paths && state->batch_file_paths->len > 0;
+    gboolean has_input = batch_mode || state->selected_file_path;
+    if (!has_input || !state->selected_sep_path) {
         char *error_msg;
-        if (!state->selected_file_path && !state->selected_sep_path) {
+        if (!has_input && !state->selected_sep_path) {
             error_msg = "請先選擇檔案和SEP檔案";
-        } else if (!state->selected_file_path) {
+        } else if (!has_input) {
             error_msg = "請先選擇檔案";
         } else {
             error_msg = "請先選擇SEP檔案";
@@ -842,10 +975,25 @@ void on_perform_conversion(GtkWidget *widget, gpointer data) {
         return;
     }
 
-    // 快速檢查文件是否存在
-    FILE *test_file = fopen(state->selected_file_path, "r");
+    // 快速檢查文件是否存在（批次模式的個別檔案錯誤會列在報告中，不中斷整批）
+    FILE *test_file;
+    if (!batch_mode) {
+        test_file = fopen(state->selected_file_path, "r");
+        if (!test_file) {
+            char *error_msg = g_strdup_printf("主要檔案不存在或無法讀取: %s", state->selected_file_path);
+            gtk_label_set_text(GTK_LABEL(state->status_label), error_msg);
+            if (state->altitude_text_buffer) {
+                gtk_text_buffer_set_text(state->altitude_text_buffer, error_msg, -1);
+            }
+            g_free(error_msg);
+            return;
+        }
+        fclose(test_file);
+    }
+
+    test_file = fopen(state->selected_sep_path, "r");
     if (!test_file) {
-        char *error_msg = g_strdup_printf("主要檔案不存在或無法讀取: %s", state->selected_file_path);
+        char *error_msg = g_strdup_printf("SEP檔案不存在或無法讀取: %s", state->selected_sep_path);
         gtk_label_set_text(GTK_LABEL(state->status_label), error_msg);
         if (state->altitude_text_buffer) {
             gtk_text_buffer_set_text(state->altitude_text_buffer, error_msg, -1);
@@ -855,17 +1003,18 @@ void on_perform_conversion(GtkWidget *widget, gpointer data) {
     }
     fclose(test_file);
 
-    test_file = fopen(state->selected_sep_path, "r");
-    if (!test_file) {
-        char *error_msg = g_strdup_printf("SEP檔案不存在或無法讀取: %s", state->selected_sep_path);
+    TideFormat tide_format;
+    GError *format_error = NULL;
+    if (!get_selected_tide_format(state, &tide_format, &format_error)) {
+        char *error_msg = g_strdup_printf("輸入格式設定錯誤: %s", format_error->message);
         gtk_label_set_text(GTK_LABEL(state->status_label), error_msg);
         if (state->altitude_text_buffer) {
             gtk_text_buffer_set_text(state->altitude_text_buffer, error_msg, -1);
         }
         g_free(error_msg);
+        g_error_free(format_error);
         return;
     }
-    fclose(test_file);
 
     // 準備多線程處理數據
     ElevationProcessData *process_data = g_new(ElevationProcessData, 1);
@@ -874,8 +1023,44 @@ void on_perform_conversion(GtkWidget *widget, gpointer data) {
     process_data->error = NULL;
     process_data->input_path = g_strdup(state->selected_file_path);
     process_data->sep_path = g_strdup(state->selected_sep_path);
-    process_data->current_progress = 0.0;
-    strcpy(process_data->progress_text, "準備處理...");
+    process_data->batch_paths = NULL;
+    if (batch_mode) {
+        process_data->batch_paths = g_new0(char *, state->batch_file_paths->len + 1);
+        for (guint i = 0; i < state->batch_file_paths->len; i++) {
+            process_data->batch_paths[i] = g_strdup(g_ptr_array_index(state->batch_file_paths, i));
+        }
+    }
+    process_data->tide_format = tide_format;
+    elevation_options_init(&process_data->options);
+    process_data->options.tide_format = &process_data->tide_format;
+    if (state->raster_check_button) {
+        process_data->options.use_raster =
+            gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(state->raster_check_button));
+        process_data->options.raster_resolution =
+            gtk_spin_button_get_value(GTK_SPIN_BUTTON(state->raster_resolution_spin));
+    }
+    if (state->tin_check_button) {
+        process_data->options.use_tin =
+            gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(state->tin_check_button));
+    }
+    if (state->tiles_check_button) {
+        process_data->options.use_tiles =
+            gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(state->tiles_check_button));
+        process_data->options.tile_size =
+            gtk_spin_button_get_value(GTK_SPIN_BUTTON(state->tile_size_spin));
+    }
+    if (state->shard_count_spin) {
+        process_data->options.shard_count =
+            gtk_spin_button_get_value_as_int(GTK_SPIN_BUTTON(state->shard_count_spin));
+    }
+    if (state->filtered_output_combo) {
+        int active = gtk_combo_box_get_active(GTK_COMBO_BOX(state->filtered_output_combo));
+        if (active >= 0) {
+            process_data->options.filtered_output = (ElevationFilteredOutput)active;
+        }
+    }
+    // 工作執行緒持有快取的參考，轉換結束時在 update_result_callback 釋放
+    process_data->options.model_cache = sep_model_cache_ref(state->sep_model_cache);
 
     // 設定處理中狀態
     state->is_processing = TRUE;
@@ -885,7 +1070,7 @@ void on_perform_conversion(GtkWidget *widget, gpointer data) {
     gtk_widget_set_sensitive(GTK_WIDGET(g_object_get_data(G_OBJECT(state->window), "elevation_stop_button")), TRUE);
 
     // 設置狀態
-    gtk_label_set_text(GTK_LABEL(state->status_label), "開始高程轉換...");
+    gtk_label_set_text(GTK_LABEL(state->status_label), batch_mode ? "開始批次高程轉換..." : "開始高程轉換...");
 
     // 在結果框內新增開始處理訊息
     if (state->altitude_text_buffer) {
@@ -903,11 +1088,12 @@ void on_perform_conversion(GtkWidget *widget, gpointer data) {
         }
     }
 
-    // 重置進度條
+    // 重置進度條，並啟動進度取樣計時器（工作執行緒不直接觸碰 GTK）
     if (state->elevation_progress_bar) {
         gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(state->elevation_progress_bar), 0.0);
         gtk_progress_bar_set_text(GTK_PROGRESS_BAR(state->elevation_progress_bar), "準備處理...");
     }
+    progress_view_start(state, state->elevation_progress_bar, NULL);
 
     // 創建工作線程 - 支援強力取消
     GThread *worker_thread = g_thread_new("elevation_worker",
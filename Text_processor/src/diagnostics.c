@@ -0,0 +1,136 @@
+// 輸入診斷：格式錯誤資料行的分類計數、範例與限制頻率的標準錯誤摘要
+
+#include <string.h>
+#include "diagnostics.h"
+
+// 初始化診斷收集器
+void diagnostics_init(Diagnostics *diag, const char *source, const char * const *category_names,
+                      int category_count, gboolean echo_stderr) {
+    memset(diag, 0, sizeof(*diag));
+    diag->source = source ? source : "";
+    diag->category_names = category_names;
+    diag->category_count = CLAMP(category_count, 0, DIAGNOSTICS_MAX_CATEGORIES);
+    diag->echo_stderr = echo_stderr;
+}
+
+// 複製資料行的開頭作為範例：去掉行尾換行，控制字元以空白取代，
+// 無效的 UTF-8 位元組以 '?' 取代（報告會顯示在 GTK 文字區域，必須是有效的 UTF-8）
+static void diagnostics_copy_text(char *dest, const char *line, gssize length) {
+    gsize len = length < 0 ? strlen(line) : (gsize)length;
+    while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) len--;
+
+    const char *p = line;
+    const char *end = line + len;
+    gsize out = 0;
+    while (p < end) {
+        gunichar c = g_utf8_get_char_validated(p, (gssize)(end - p));
+        gsize n = (c == (gunichar)-1 || c == (gunichar)-2) ? 1 : (gsize)(g_utf8_next_char(p) - p);
+        if (out + n >= DIAGNOSTICS_EXAMPLE_TEXT) break;
+
+        if (c == (gunichar)-1 || c == (gunichar)-2) {
+            dest[out++] = '?';
+        } else if (c < 0x20 || c == 0x7f) {
+            dest[out++] = ' ';
+        } else {
+            memcpy(dest + out, p, n);
+            out += n;
+        }
+        p += n;
+    }
+    dest[out] = '\0';
+}
+
+// 寫出目前為止的累計摘要
+static void diagnostics_print_summary(Diagnostics *diag) {
+    g_printerr("Warning: %s: %" G_GUINT64_FORMAT " malformed lines so far (", diag->source, diag->total);
+    gboolean first = TRUE;
+    for (int i = 0; i < diag->category_count; i++) {
+        if (diag->counts[i] == 0) continue;
+        g_printerr("%s%s: %" G_GUINT64_FORMAT, first ? "" : ", ", diag->category_names[i], diag->counts[i]);
+        first = FALSE;
+    }
+    g_printerr(")\n");
+
+    diag->stderr_reported = diag->total;
+    diag->last_stderr_time = g_get_monotonic_time();
+}
+
+// 記錄一筆格式錯誤的資料行
+void diagnostics_record(Diagnostics *diag, int category, gint64 line_number, const char *line, gssize length) {
+    if (category < 0 || category >= diag->category_count) return;
+
+    diag->counts[category]++;
+    diag->total++;
+
+    if (diag->example_count < DIAGNOSTICS_MAX_EXAMPLES) {
+        DiagnosticsExample *example = &diag->examples[diag->example_count++];
+        example->line_number = line_number;
+        example->category = category;
+        if (line) {
+            diagnostics_copy_text(example->text, line, length);
+        } else {
+            example->text[0] = '\0';
+        }
+
+        if (diag->echo_stderr) {
+            g_printerr("Warning: %s:%" G_GINT64_FORMAT ": %s: %s\n", diag->source, line_number,
+                       diag->category_names[category], example->text);
+            diag->stderr_reported = diag->total;
+        }
+        return;
+    }
+
+    // 範例已滿：只計數，定期寫出一次累計摘要
+    if (diag->echo_stderr &&
+        g_get_monotonic_time() - diag->last_stderr_time >= DIAGNOSTICS_STDERR_INTERVAL_US) {
+        diagnostics_print_summary(diag);
+    }
+}
+
+// 累加另一個收集器的各類別次數
+void diagnostics_merge_counts(Diagnostics *total, const Diagnostics *diag) {
+    for (int i = 0; i < diag->category_count && i < total->category_count; i++) {
+        total->counts[i] += diag->counts[i];
+    }
+    total->total += diag->total;
+}
+
+// 依序附加另一個收集器的範例，行號加上該段之前的總行數
+void diagnostics_merge_examples(Diagnostics *total, const Diagnostics *diag, gint64 line_offset) {
+    for (int i = 0; i < diag->example_count && total->example_count < DIAGNOSTICS_MAX_EXAMPLES; i++) {
+        DiagnosticsExample *example = &total->examples[total->example_count++];
+        *example = diag->examples[i];
+        example->line_number += line_offset;
+    }
+}
+
+// 處理結束時寫出尚未寫出的累計摘要
+void diagnostics_finish(Diagnostics *diag) {
+    if (diag->echo_stderr && diag->total > diag->stderr_reported) {
+        diagnostics_print_summary(diag);
+    }
+}
+
+// 附加各類別次數與範例到報告
+void diagnostics_append_report(const Diagnostics *diag, const char *title, GString *report) {
+    if (diag->total == 0) return;
+
+    g_string_append_printf(report, "\n%s: %" G_GUINT64_FORMAT " 行\n", title, diag->total);
+    for (int i = 0; i < diag->category_count; i++) {
+        if (diag->counts[i] == 0) continue;
+        g_string_append_printf(report, "  %s: %" G_GUINT64_FORMAT "\n", diag->category_names[i], diag->counts[i]);
+    }
+
+    if (diag->example_count == 0) return;
+
+    g_string_append_printf(report, "前 %d 筆範例:\n", diag->example_count);
+    for (int i = 0; i < diag->example_count; i++) {
+        const DiagnosticsExample *example = &diag->examples[i];
+        g_string_append_printf(report, "  第%" G_GINT64_FORMAT "行 [%s] %s\n", example->line_number,
+                               diag->category_names[example->category], example->text);
+    }
+    if (diag->total > (guint64)diag->example_count) {
+        g_string_append_printf(report, "  ……其餘 %" G_GUINT64_FORMAT " 行只計數\n",
+                               diag->total - (guint64)diag->example_count);
+    }
+}
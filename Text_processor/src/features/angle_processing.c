@@ -6,36 +6,13 @@
 #include "angle_parser.h"
 #include "max_finder.h"
 
-// 進度更新資料結構
-typedef struct {
-    AppState *state;
-    double progress;
-    gchar *text;
-} ProgressUpdateData;
-
 // 靜態函數聲明 (角度分析相關)
-static gboolean update_progress_ui(gpointer data);
 static void progress_callback(int current, int total, const char *filename, void *user_data);
 static gpointer angle_analysis_thread(gpointer data);
 static gboolean angle_analysis_finished(gpointer data);
 static void free_async_process_data(AsyncProcessData *data);
 
-// 在主執行緒中更新進度 UI
-static gboolean update_progress_ui(gpointer data) {
-    ProgressUpdateData *update_data = (ProgressUpdateData *)data;
-    AppState *state = update_data->state;
-
-    // 更新進度條
-    gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(state->progress_bar), update_data->progress);
-
-    // 更新進度標籤
-    gtk_label_set_text(GTK_LABEL(state->progress_label), update_data->text);
-
-    g_free(update_data->text);
-    return FALSE; // 只執行一次
-}
-
-// 進度回調函數（在工作執行緒中調用）
+// 進度回調函數（在工作執行緒中調用）：只寫入進度通道，由 UI 計時器取樣重繪
 static void progress_callback(int current, int total, const char *filename, void *user_data) {
     AsyncProcessData *async_data = (AsyncProcessData *)user_data;
     AppState *state = async_data->app_state;
@@ -45,26 +22,8 @@ static void progress_callback(int current, int total, const char *filename, void
         return; // 不再發送進度更新
     }
 
-    // 計算進度百分比
-    double progress = (double)current / total;
-
-    // 建立進度資訊字串
-    gchar *progress_text = g_strdup_printf("處理檔案 %d/%d: %s", current, total, filename);
-
-    // 建立進度更新資料
-    ProgressUpdateData *update_data = g_new(ProgressUpdateData, 1);
-    if (!update_data) {
-        g_printerr("Error: Failed to allocate progress update data\n");
-        g_free(progress_text);
-        return;
-    }
-
-    update_data->state = state;
-    update_data->progress = progress;
-    update_data->text = progress_text;
-
-    // 在主執行緒中更新 UI
-    g_idle_add_full(G_PRIORITY_DEFAULT_IDLE, update_progress_ui, update_data, g_free);
+    progress_channel_set_counts(&state->progress_channel, current, total);
+    progress_channel_set_messagef(&state->progress_channel, "處理檔案 %d/%d: %s", current, total, filename);
 }
 
 // 工作執行緒函數
@@ -132,7 +91,7 @@ static gboolean angle_analysis_finished(gpointer data) {
     AppState *state = async_data->app_state;
     AngleAnalysisResult *result = &async_data->result;
 
-    // 還原處理狀態
+    // 還原處理狀態（同時停止進度取樣）
     set_processing_state(state, FALSE);
 
     if (!result->success) {
@@ -219,9 +178,11 @@ void on_analyze_angles(GtkWidget *widget, gpointer data) {
     // 重置取消標記
     set_cancel_requested(state, FALSE);
 
-    // 設定處理狀態
+    // 設定處理狀態並啟動進度取樣計時器
     set_processing_state(state, TRUE);
     gtk_label_set_text(GTK_LABEL(state->status_label), "開始角度分析...");
+    progress_view_start(state, state->progress_bar, state->progress_label);
+    progress_channel_set_phase(&state->progress_channel, PROGRESS_PHASE_RUNNING);
 
     // 準備異步處理資料
     AsyncProcessData *async_data = g_new0(AsyncProcessData, 1);
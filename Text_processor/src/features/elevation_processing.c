@@ -1,14 +1,35 @@
 // 高程轉換處理模組
 // 負責處理7欄文字文件和SEP對照文件的高程轉換邏輯
 
+// copy_file_range（Linux）需要 _GNU_SOURCE，必須在所有 #include 之前定義
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include <glib.h>
+#include <glib/gstdio.h>  // g_open
 #include <gtk/gtk.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
-#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
 #include <float.h>   // DBL_MAX
+#include <sys/stat.h>  // fstat
+#ifdef G_OS_WIN32
+#include <io.h>        // _commit
+#else
+#include <unistd.h>    // fsync、ftruncate
+#include <signal.h>    // kill
+#include <spawn.h>     // posix_spawn
+#include <sys/mman.h>  // mmap（分段轉換的共用狀態）
+#include <sys/wait.h>  // waitpid
+extern char **environ;
+#endif
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
 #ifndef MIN
 #define MIN(a,b) ((a) < (b) ? (a) : (b))
 #endif
@@ -16,474 +37,615 @@
 #define MAX(a,b) ((a) > (b) ? (a) : (b))
 #endif
 
-// 非同步統計行數的資料結構
-typedef struct {
-    const char *input_path;
-    volatile int *total_lines_ptr;  // 指向總行數變數
-    volatile gboolean *counting_done_ptr;  // 統計完成標記
-    volatile gboolean *cancel_counting_ptr; // 取消統計標記
-    volatile int *known_total_lines_ptr;    // 主線程的已知總行數
-    GMutex *counting_mutex;  // 保護共享變數
-    GCond *counting_cond;    // 條件變數，用於通知主線程
-} CountingData;
+#include "../../include/callbacks.h"  // 引入 TideDataRow 和 parse_tide_data_row
+#include "../../include/sep_data.h"
+#include "../../include/sep_raster.h"
+#include "../../include/sep_tin.h"
+#include "../../include/sep_model_cache.h"
+#include "../../include/tide_format.h"
+#include "../../include/diagnostics.h"
+#include "../../include/elevation_processing.h"
+
+// 平行管線配置：讀取執行緒切出以完整行結尾的大區塊，工作執行緒各自解析、過濾、查詢與格式化，
+// 呼叫端執行緒依區塊序號寫出，輸出與逐行處理完全相同
+#define ELEVATION_PIPELINE_BLOCK_BYTES (2 * 1024 * 1024)
+#define ELEVATION_PIPELINE_READ_MIN (64 * 1024)     // 區塊已滿但尚未遇到換行時，每次追加讀取的大小
+#define ELEVATION_PIPELINE_MAX_WORKERS 16
+#define ELEVATION_MAX_SHARDS 64                      // 多行程分段轉換的段數上限
+#define ELEVATION_LINE_BUFFER 8192                   // 與原本 fgets 的行緩衝區相同，超長行以相同方式切段
+#define ELEVATION_OUTPUT_BUFFER (1024 * 1024)        // 輸出檔案的 stdio 緩衝區
+#define ELEVATION_COPY_CHUNK (8 * 1024 * 1024)       // rename 失敗時複製檔案的每次大小
+#define ELEVATION_BATCH_PROGRESS_INTERVAL_US (100 * 1000)  // 批次轉換彙總進度的週期
+
+// 報告中分段計時的處理階段（g_get_monotonic_time，微秒）
+// 解析、查詢、格式化在工作執行緒中以區塊為單位計時，報告的是各執行緒時間的合計；
+// 讀取與寫出分別只在讀取執行緒與寫出端執行緒中計時
+typedef enum {
+    ELEVATION_STAGE_SEP_LOAD = 0,   // 載入SEP模型（含索引、網格與分塊）
+    ELEVATION_STAGE_READ,           // 讀取輸入
+    ELEVATION_STAGE_PARSE,          // 解析與過濾
+    ELEVATION_STAGE_LOOKUP,         // 查詢SEP對照值
+    ELEVATION_STAGE_FORMAT,         // 格式化轉換後資料行
+    ELEVATION_STAGE_WRITE,          // 寫出（含關閉檔案與覆寫原始檔案）
+    ELEVATION_STAGE_COUNT
+} ElevationStage;
 
 typedef struct {
-    double distance;
-    double adjustment;
-} Neighbor2;
-
-// 背景統計行數的線程函數
-static gpointer counting_thread_func(gpointer data) {
-    CountingData *counting_data = (CountingData *)data;
-
-    FILE *count_file = fopen(counting_data->input_path, "r");
-    if (!count_file) {
-        g_mutex_lock(counting_data->counting_mutex);
-        *counting_data->counting_done_ptr = TRUE;
-        g_cond_signal(counting_data->counting_cond);
-        g_mutex_unlock(counting_data->counting_mutex);
-        return NULL;
-    }
+    gint64 us[ELEVATION_STAGE_COUNT];
+} ElevationStageTimes;
 
-    char line[8192];
-    int lines_count = 0;
-
-    // 統計行數
-    while (fgets(line, sizeof(line), count_file)) {
-        // 檢查取消請求
-        if (*counting_data->cancel_counting_ptr) {
-            break;
-        }
-
-        g_strstrip(line);
-        if (strlen(line) > 0 && line[0] != ';') {
-            lines_count++;
-        }
+static void elevation_stage_times_add(ElevationStageTimes *total, const ElevationStageTimes *times) {
+    for (int i = 0; i < ELEVATION_STAGE_COUNT; i++) {
+        total->us[i] += times->us[i];
     }
-
-    fclose(count_file);
-
-    // 通知主線程統計完成
-    g_mutex_lock(counting_data->counting_mutex);
-    *counting_data->counting_done_ptr = TRUE;
-    *counting_data->known_total_lines_ptr = lines_count;  // 在鎖內更新統計結果
-    g_cond_signal(counting_data->counting_cond);  // 發出完成訊號
-    g_mutex_unlock(counting_data->counting_mutex);
-
-    return NULL;
 }
-#include "../../include/callbacks.h"  // 引入 TideDataRow 和 parse_tide_data_row
 
-// Hash table 配置
-#define SEP_HASH_SIZE 8192
-
-// 最近鄰資料結構，用於儲存到目標點的距離和調整值
-typedef struct {
-    double distance;     // 到目標點的距離
-    double adjustment;   // SEP調整值
-    double latitude;     // 緯度
-    double longitude;    // 經度
-} NeighborPoint;
-
-// 大圓距離公式 (Haversine formula) 計算兩點間的距離
-static double calculate_distance(double lat1, double lon1, double lat2, double lon2) {
-    const double R = 6371000.0; // 地球半徑（公尺）
-    double dlat = (lat2 - lat1) * G_PI / 180.0;
-    double dlon = (lon2 - lon1) * G_PI / 180.0;
-
-    double a = sin(dlat/2) * sin(dlat/2) +
-               cos(lat1 * G_PI / 180.0) * cos(lat2 * G_PI / 180.0) *
-               sin(dlon/2) * sin(dlon/2);
-    double c = 2 * atan2(sqrt(a), sqrt(1-a));
-
-    return R * c; // 返回距離（公尺）
-}
-
-// SEP對照資料結構
-typedef struct SepEntry {
-    double longitude;   // 經度
-    double latitude;    // 緯度
-    double adjustment;  // 調整值
-    struct SepEntry *next; // 鏈表下一節點
-} SepEntry;
-
-// Hash table 結構
+// 區塊內解析失敗的一行：行號、失敗原因與在原始位元組中的位置（寫出端據此取出範例內容）
 typedef struct {
-    SepEntry **buckets;  // 桶陣列
-    int size;           // 哈希表大小
-    int count;          // 項目總數
-} SepHashTable;
+    int line_index;           // 區塊內行號
+    int error;                // TideRowError
+    gsize offset;             // 在 text 中的起始位置
+    int length;
+} ElevationFailedLine;
 
-// 效能優化：連續陣列儲存SEP點，用於快速最近鄰搜索
+// 分區塊處理的資料：原始位元組、通過過濾的資料行、查詢結果與該區塊的輸出
 typedef struct {
-    double *longitudes;
-    double *latitudes;
-    double *adjustments;
-    int count;
-    int capacity;
-} SepPointArray;
-
-// 地理空間網格索引：第二階段效能優化
-typedef struct {
-    SepPointArray ***grids;          // 2D網格陣列 [lat][lon]
-    int lat_grid_size, lon_grid_size; // 網格尺寸
-    double min_lat, max_lat;         // 經緯度範圍
-    double min_lon, max_lon;
-    double lat_resolution, lon_resolution; // 每個網格的經緯度解析度
-} SpatialGrid;
-
-// 簡易複合結構：同時維護hash table和多層索引
-typedef struct {
-    SepHashTable *hash_table;   // 保留用於精確匹配
-    SepPointArray *point_array; // 第一階段：全量陣列
-    SpatialGrid *spatial_grid;  // 第二階段：空間網格索引
-} SepDataStructure;
-
-// 初始化效能優化的SEP點陣列
-static SepPointArray* sep_point_array_init(int initial_capacity) {
-    SepPointArray *array = g_new(SepPointArray, 1);
-    array->capacity = initial_capacity > 0 ? initial_capacity : 1024;
-    array->count = 0;
+    gint64 sequence;          // 區塊序號（讀取順序）
+    GString *text;            // 原始位元組，以完整行結尾（檔案最後一行可能沒有換行）
+
+    TideDataRow *rows;        // 通過過濾的資料行
+    double *longitudes;       // 查詢用經度
+    double *latitudes;        // 查詢用緯度
+    double *adjustments;      // 查詢結果
+    SepMatchKind *kinds;      // 匹配類型
+    int row_count;            // 通過過濾的資料行數
+    int row_capacity;
+
+    GString *filtered;        // 過濾後檔案的內容（只在覆寫模式產生）
+    GString *converted;       // 轉換後檔案的內容
+    GByteArray *kept_bits;    // 區塊內每行一個位元，1 表示通過過濾（只在位元圖模式產生）
+    GArray *failed_lines;     // 解析失敗的行（ElevationFailedLine）
+    int line_count;           // 區塊內行數
+    int filtered_lines;
+    int processed_lines;
+    int matched_lines;
+    int interpolated_lines;
+    int raster_lines;
+    int tin_lines;
+    int fallback_lines;       // 網格或三角網範圍外退回逐點查詢的行數
+    int unmatched_lines;      // 找不到任何對照點的行數
+    ElevationStageTimes times; // 只使用解析、查詢、格式化三個階段
+} ElevationBlock;
+
+static ElevationBlock* elevation_block_new(int row_capacity) {
+    ElevationBlock *block = g_new0(ElevationBlock, 1);
+    block->text = g_string_sized_new(ELEVATION_PIPELINE_BLOCK_BYTES + ELEVATION_PIPELINE_READ_MIN);
+    block->row_capacity = row_capacity;
+    block->rows = g_new(TideDataRow, row_capacity);
+    block->longitudes = g_new(double, row_capacity);
+    block->latitudes = g_new(double, row_capacity);
+    block->adjustments = g_new(double, row_capacity);
+    block->kinds = g_new(SepMatchKind, row_capacity);
+    block->filtered = g_string_sized_new(ELEVATION_PIPELINE_BLOCK_BYTES);
+    block->converted = g_string_sized_new(ELEVATION_PIPELINE_BLOCK_BYTES);
+    block->failed_lines = g_array_new(FALSE, FALSE, sizeof(ElevationFailedLine));
+    block->kept_bits = g_byte_array_new();
+    return block;
+}
 
-    array->longitudes = g_new(double, array->capacity);
-    array->latitudes = g_new(double, array->capacity);
-    array->adjustments = g_new(double, array->capacity);
+static void elevation_block_free(ElevationBlock *block) {
+    if (!block) return;
+
+    g_string_free(block->text, TRUE);
+    g_free(block->rows);
+    g_free(block->longitudes);
+    g_free(block->latitudes);
+    g_free(block->adjustments);
+    g_free(block->kinds);
+    g_string_free(block->filtered, TRUE);
+    g_string_free(block->converted, TRUE);
+    g_array_free(block->failed_lines, TRUE);
+    g_byte_array_free(block->kept_bits, TRUE);
+    g_free(block);
+}
 
-    return array;
+static void elevation_block_reset(ElevationBlock *block) {
+    g_string_truncate(block->text, 0);
+    g_string_truncate(block->filtered, 0);
+    g_string_truncate(block->converted, 0);
+    g_array_set_size(block->failed_lines, 0);
+    g_byte_array_set_size(block->kept_bits, 0);
+    block->row_count = 0;
+    block->line_count = 0;
+    block->filtered_lines = 0;
+    block->processed_lines = 0;
+    block->matched_lines = 0;
+    block->interpolated_lines = 0;
+    block->raster_lines = 0;
+    block->tin_lines = 0;
+    block->fallback_lines = 0;
+    block->unmatched_lines = 0;
+    memset(&block->times, 0, sizeof(block->times));
 }
 
-// 釋放SEP點陣列
-static void sep_point_array_free(SepPointArray *array) {
-    if (!array) return;
+// 確保還能再放入一筆資料行
+static void elevation_block_reserve_row(ElevationBlock *block) {
+    if (block->row_count < block->row_capacity) return;
 
-    g_free(array->longitudes);
-    g_free(array->latitudes);
-    g_free(array->adjustments);
-    g_free(array);
+    block->row_capacity *= 2;
+    block->rows = g_renew(TideDataRow, block->rows, block->row_capacity);
+    block->longitudes = g_renew(double, block->longitudes, block->row_capacity);
+    block->latitudes = g_renew(double, block->latitudes, block->row_capacity);
+    block->adjustments = g_renew(double, block->adjustments, block->row_capacity);
+    block->kinds = g_renew(SepMatchKind, block->kinds, block->row_capacity);
 }
 
-// 初始化空間網格索引
-static SpatialGrid* spatial_grid_init(int lat_grid_size, int lon_grid_size) {
-    SpatialGrid *grid = g_new(SpatialGrid, 1);
-    grid->lat_grid_size = lat_grid_size;
-    grid->lon_grid_size = lon_grid_size;
+// 處理一個區塊：解析與過濾、批次查詢SEP對照值、格式化輸出內容
+// 過濾結果依 filtered_output 記錄為原始行（覆寫模式）、位元圖或不記錄
+// 只讀取 sep_data / sep_raster / sep_tin，lookup_ctx 由呼叫端確保同一時間只有一個執行緒使用
+static void elevation_block_process(ElevationBlock *block, const SepDataStructure *sep_data,
+                                    const SepRaster *sep_raster, const SepTin *sep_tin,
+                                    SepLookupContext *lookup_ctx,
+                                    const TideFormat *tide_format, ElevationFilteredOutput filtered_output) {
+    char line[ELEVATION_LINE_BUFFER];
+    const char *p = block->text->str;
+    const char *end = p + block->text->len;
+    gint64 stage_start = g_get_monotonic_time();
+
+    // 1. 解析與過濾，收集需要查詢的座標
+    while (p < end) {
+        // 與 fgets(line, sizeof(line), ...) 相同的切段：讀到換行或緩衝區滿為止
+        gsize limit = MIN((gsize)(end - p), sizeof(line) - 1);
+        const char *newline = memchr(p, '\n', limit);
+        gsize length = newline ? (gsize)(newline - p) + 1 : limit;
+
+        memcpy(line, p, length);
+        line[length] = '\0';
+        p += length;
+        int line_index = block->line_count++;
+        if (filtered_output == ELEVATION_FILTERED_BITMAP && (line_index & 7) == 0) {
+            guint8 zero = 0;
+            g_byte_array_append(block->kept_bits, &zero, 1);
+        }
+
+        elevation_block_reserve_row(block);
+        TideDataRow *row = &block->rows[block->row_count];
+        if (!tide_format_parse_row(tide_format, line, row)) {
+            ElevationFailedLine failed = { line_index, (int)tide_format_diagnose_row(tide_format, line),
+                                           (gsize)(p - length - block->text->str), (int)length };
+            g_array_append_val(block->failed_lines, failed);
+            continue;
+        }
+
+        // 過濾：檢查col6和col7是否其中一個為0
+        if (row->col6 == 0.0 || row->col7 == 0.0) {
+            block->filtered_lines++;
+            continue; // 不寫入輸出文件，直接跳過
+        }
+
+        // 記錄過濾結果：覆寫模式保留原始行（不進行轉換），位元圖模式只設定該行的位元
+        if (filtered_output == ELEVATION_FILTERED_REWRITE) {
+            g_string_append_len(block->filtered, line, (gssize)length);
+        } else if (filtered_output == ELEVATION_FILTERED_BITMAP) {
+            block->kept_bits->data[line_index >> 3] |= (guint8)(1u << (line_index & 7));
+        }
+
+        block->longitudes[block->row_count] = row->longitude;
+        block->latitudes[block->row_count] = row->latitude;
+        block->row_count++;
+    }
 
-    // 初始化經緯度範圍為極端值，會在加入點時更新
-    grid->min_lat = G_MAXDOUBLE;
-    grid->max_lat = -G_MAXDOUBLE;
-    grid->min_lon = G_MAXDOUBLE;
-    grid->max_lon = -G_MAXDOUBLE;
+    gint64 stage_end = g_get_monotonic_time();
+    block->times.us[ELEVATION_STAGE_PARSE] += stage_end - stage_start;
+    stage_start = stage_end;
 
-    // 配置2D網格陣列
-    grid->grids = g_new(SepPointArray**, lat_grid_size);
-    for (int lat = 0; lat < lat_grid_size; lat++) {
-        grid->grids[lat] = g_new0(SepPointArray*, lon_grid_size);
-        for (int lon = 0; lon < lon_grid_size; lon++) {
-            grid->grids[lat][lon] = sep_point_array_init(64); // 每個網格初始容量64
+    // 2. 批次查詢SEP對照值（精確匹配優先，否則距離加權插值）
+    if (sep_raster || sep_tin) {
+        // 網格模式為雙線性內插，三角網模式為三角形內線性內插；範圍外的少數點退回逐點查詢
+        if (sep_raster) {
+            sep_raster_lookup_batch(sep_raster, block->longitudes, block->latitudes, block->row_count,
+                                    block->adjustments, block->kinds);
+        } else {
+            sep_tin_lookup_batch(sep_tin, block->longitudes, block->latitudes, block->row_count,
+                                 block->adjustments, block->kinds);
+        }
+        for (int r = 0; r < block->row_count; r++) {
+            if (block->kinds[r] == SEP_MATCH_NONE) {
+                block->fallback_lines++;
+                block->adjustments[r] = sep_data_lookup(sep_data, block->longitudes[r], block->latitudes[r],
+                                                        &block->kinds[r]);
+            }
         }
+    } else {
+        sep_data_lookup_batch(sep_data, lookup_ctx, block->longitudes, block->latitudes, block->row_count,
+                              block->adjustments, block->kinds);
     }
 
-    return grid;
-}
+    stage_end = g_get_monotonic_time();
+    block->times.us[ELEVATION_STAGE_LOOKUP] += stage_end - stage_start;
+    stage_start = stage_end;
 
-// 釋放空間網格索引
-static void spatial_grid_free(SpatialGrid *grid) {
-    if (!grid) return;
+    // 3. 依原始行順序格式化轉換後內容
+    for (int r = 0; r < block->row_count; r++) {
+        TideDataRow *row = &block->rows[r];
+        char converted_line[1024];
 
-    for (int lat = 0; lat < grid->lat_grid_size; lat++) {
-        for (int lon = 0; lon < grid->lon_grid_size; lon++) {
-            sep_point_array_free(grid->grids[lat][lon]);
+        // 決定使用的調整值：總是嘗試插值，每次數據都要有調整！
+        double final_adjustment;
+        if (block->kinds[r] == SEP_MATCH_EXACT) {
+            final_adjustment = block->adjustments[r];
+            block->matched_lines++;  // 記錄精確匹配數量
+        } else if (block->kinds[r] == SEP_MATCH_INTERPOLATED) {
+            final_adjustment = block->adjustments[r];
+            block->interpolated_lines++;  // 記錄插值匹配數量
+        } else if (block->kinds[r] == SEP_MATCH_RASTER) {
+            final_adjustment = block->adjustments[r];
+            block->raster_lines++;  // 記錄網格內插數量
+        } else if (block->kinds[r] == SEP_MATCH_TIN) {
+            final_adjustment = block->adjustments[r];
+            block->tin_lines++;  // 記錄三角網內插數量
+        } else {
+            // 插值也找不到點時，設定預設值（極端情況）
+            final_adjustment = 0.0;
+            // 不統計在任何匹配類別中，因為這是無法處理的情況
+            block->unmatched_lines++;
         }
-        g_free(grid->grids[lat]);
+
+        // 應用調整值到數據行
+        row->tide += final_adjustment;
+        row->processed_depth -= final_adjustment;
+
+        // 格式化轉換後輸出行（保持原始格式，所有資料都處理）
+        int length = snprintf(converted_line, sizeof(converted_line),
+                              "%s/%.3f/%.7f/%.7f/%.3f/%.3f/%.3f\n",
+                              row->datetime, row->tide, row->longitude, row->latitude,
+                              row->processed_depth, row->col6, row->col7);
+        g_string_append_len(block->converted, converted_line, MIN(length, (int)sizeof(converted_line) - 1));
+        block->processed_lines++;
     }
-    g_free(grid->grids);
-    g_free(grid);
+
+    block->times.us[ELEVATION_STAGE_FORMAT] += g_get_monotonic_time() - stage_start;
 }
 
-// 將經緯度轉換為網格索引
-static void lat_lon_to_grid_indices(const SpatialGrid *grid, double latitude, double longitude,
-                                   int *lat_index, int *lon_index) {
-    if (grid->max_lat == grid->min_lat) {
-        *lat_index = 0;
-    } else {
-        *lat_index = (int)((latitude - grid->min_lat) / grid->lat_resolution);
-        *lat_index = CLAMP(*lat_index, 0, grid->lat_grid_size - 1);
+// 管線共用狀態
+typedef struct {
+    FILE *input_file;
+    const SepDataStructure *sep_data;   // 所有工作執行緒唯讀共用
+    const SepRaster *sep_raster;
+    const SepTin *sep_tin;
+    const TideFormat *tide_format;      // 輸入格式（已編譯）
+    ElevationFilteredOutput filtered_output;
+    GAsyncQueue *free_blocks;           // 可重複使用的區塊（限制同時在處理中的區塊數）
+    GAsyncQueue *done_blocks;           // 處理完成的區塊（完成順序不定）與讀取結束標記
+    GAsyncQueue *lookup_contexts;       // 查詢工作區，每個工作執行緒同時只取用一份
+    GThreadPool *workers;
+    ElevationBlock end_marker;          // 讀取結束標記
+    gint64 block_count;                 // 讀取執行緒送出的區塊數（送出結束標記前寫入）
+    gint64 read_us;                     // 讀取執行緒等待 fread 的時間（讀取執行緒結束後才讀取）
+    gboolean read_error;
+    gint cancelled;                     // 取消旗標（g_atomic_int）
+} ElevationPipeline;
+
+// 回傳最後一個換行之後的位置，沒有換行時回傳 0
+static gsize last_line_end(const char *text, gsize length) {
+    for (gsize i = length; i > 0; i--) {
+        if (text[i - 1] == '\n') return i;
     }
+    return 0;
+}
 
-    if (grid->max_lon == grid->min_lon) {
-        *lon_index = 0;
-    } else {
-        *lon_index = (int)((longitude - grid->min_lon) / grid->lon_resolution);
-        *lon_index = CLAMP(*lon_index, 0, grid->lon_grid_size - 1);
-    }
-}
-
-// 向陣列添加一個點
-static void sep_point_array_add(SepPointArray *array, double longitude, double latitude, double adjustment) {
-    // 動態擴容
-    if (array->count >= array->capacity) {
-        array->capacity *= 2;
-        array->longitudes = g_renew(double, array->longitudes, array->capacity);
-        array->latitudes = g_renew(double, array->latitudes, array->capacity);
-        array->adjustments = g_renew(double, array->adjustments, array->capacity);
-    }
-
-    array->longitudes[array->count] = longitude;
-    array->latitudes[array->count] = latitude;
-    array->adjustments[array->count] = adjustment;
-    array->count++;
-}
-
-// 向空間網格添加一個點
-static void spatial_grid_add_point(SpatialGrid *grid, double longitude, double latitude, double adjustment) {
-    // 更新經緯度範圍
-    grid->min_lat = MIN(grid->min_lat, latitude);
-    grid->max_lat = MAX(grid->max_lat, latitude);
-    grid->min_lon = MIN(grid->min_lon, longitude);
-    grid->max_lon = MAX(grid->max_lon, longitude);
-
-    // 計算並更新解析度
-    if (grid->max_lat > grid->min_lat) {
-        grid->lat_resolution = (grid->max_lat - grid->min_lat) / grid->lat_grid_size;
-    }
-    if (grid->max_lon > grid->min_lon) {
-        grid->lon_resolution = (grid->max_lon - grid->min_lon) / grid->lon_grid_size;
-    }
-
-    // 直接加到第一個網格，如果範圍還沒確定
-    if (grid->lat_resolution == 0 || grid->lon_resolution == 0) {
-        sep_point_array_add(grid->grids[0][0], longitude, latitude, adjustment);
-        return;
-    }
-
-    // 計算網格索引
-    int lat_index, lon_index;
-    lat_lon_to_grid_indices(grid, latitude, longitude, &lat_index, &lon_index);
-
-    // 添加到對應網格
-    sep_point_array_add(grid->grids[lat_index][lon_index], longitude, latitude, adjustment);
-}
-
-// 使用空間網格的全域插值查詢 (確保總是能找到最近點)
-// 以「鄰域擴圈 + 早停」實作的插值查詢：O(k)，k 為近鄰 cell 的點數，遠小於全域掃描
-// 保留你原本的函式簽名；若原本名字/參數不同，請只改第一行宣告。
-static double sep_grid_lookup_with_interpolation(const SpatialGrid *grid,
-                                                 double target_longitude,
-                                                 double target_latitude)
-{
-    if (!grid) return -99999.0;
-
-    // 找出目標點所在 cell
-    int ci = 0, cj = 0;
-    lat_lon_to_grid_indices(grid, target_latitude, target_longitude, &ci, &cj);
-    if (ci < 0) ci = 0;
-    if (cj < 0) cj = 0;
-    if (ci >= grid->lat_grid_size) ci = grid->lat_grid_size - 1;
-    if (cj >= grid->lon_grid_size) cj = grid->lon_grid_size - 1;
-
-    Neighbor2 best0 = { .distance = DBL_MAX, .adjustment = 0.0 };
-    Neighbor2 best1 = { .distance = DBL_MAX, .adjustment = 0.0 };
-    int found = 0;
-
-    // 最大擴圈半徑：覆蓋整個網格邊界即可
-    const int max_r = MAX(grid->lat_grid_size, grid->lon_grid_size);
-    for (int r = 0; r < max_r; ++r) {
-
-        int imin = MAX(0, ci - r);
-        int imax = MIN(grid->lat_grid_size - 1, ci + r);
-        int jmin = MAX(0, cj - r);
-        int jmax = MIN(grid->lon_grid_size - 1, cj + r);
-
-        // 掃「外圈」cell（避免重複掃描）
-        for (int i = imin; i <= imax; ++i) {
-            for (int j = jmin; j <= jmax; ++j) {
-                // 只掃外框
-                if (i != imin && i != imax && j != jmin && j != jmax) continue;
-
-                SepPointArray *arr = grid->grids[i][j];
-                if (!arr || arr->count <= 0) continue;
-
-                // 掃描 cell 內所有點，維護兩個最近鄰
-                for (int k = 0; k < arr->count; ++k) {
-                    double d = calculate_distance(
-                        target_latitude,  target_longitude,
-                        arr->latitudes[k], arr->longitudes[k]);
-
-                    if (d < best0.distance) {
-                        best1 = best0;
-                        best0.distance = d;
-                        best0.adjustment = arr->adjustments[k];
-                    } else if (d < best1.distance) {
-                        best1.distance = d;
-                        best1.adjustment = arr->adjustments[k];
-                    }
-                }
+// 讀取一個以完整行結尾的區塊（已重設），回傳是否已讀到結尾
+//
+// carry 為上一個區塊尾端不完整的行，讀取後更新為本區塊尾端不完整的行。remaining 為 NULL 時讀到
+// 檔案結尾；否則最多再讀取 *remaining 個位元組（分段轉換的範圍結尾），並扣除實際讀取的數量
+static gboolean elevation_read_block(FILE *input_file, gint64 *remaining, GString *carry, ElevationBlock *block,
+                                     gint64 *read_us, gboolean *read_error) {
+    g_string_append_len(block->text, carry->str, (gssize)carry->len);
+    g_string_truncate(carry, 0);
+
+    while (TRUE) {
+        if (block->text->len >= ELEVATION_PIPELINE_BLOCK_BYTES) {
+            gsize line_end = last_line_end(block->text->str, block->text->len);
+            if (line_end > 0) {
+                g_string_append_len(carry, block->text->str + line_end, (gssize)(block->text->len - line_end));
+                g_string_truncate(block->text, line_end);
+                return FALSE;
             }
         }
 
-        // 兩個最近點都找到了就「早停」
-        if (best1.distance < DBL_MAX) {
-            found = 2;
-            break;
+        gsize filled = block->text->len;
+        gsize want = filled < ELEVATION_PIPELINE_BLOCK_BYTES ?
+                     ELEVATION_PIPELINE_BLOCK_BYTES - filled : ELEVATION_PIPELINE_READ_MIN;
+        if (remaining) {
+            want = (gsize)MIN((gint64)want, *remaining);
+            if (want == 0) return TRUE;
+        }
+        g_string_set_size(block->text, filled + want);
+        gint64 read_start = g_get_monotonic_time();
+        size_t got = fread(block->text->str + filled, 1, want, input_file);
+        *read_us += g_get_monotonic_time() - read_start;
+        g_string_set_size(block->text, filled + got);
+        if (remaining) {
+            *remaining -= (gint64)got;
         }
-    }
 
-    if (found >= 2) {
-        // 兩近鄰距離反比權重
-        double d1 = best0.distance, d2 = best1.distance;
-        double a1 = best0.adjustment, a2 = best1.adjustment;
-        if (d1 + d2 == 0.0) return (a1 + a2) * 0.5; // 退化情況
-        return (a2 * d1 + a1 * d2) / (d1 + d2);
-    } else if (best0.distance < DBL_MAX) {
-        // 只有一個近鄰：直接回傳
-        return best0.adjustment;
+        if (got < want) {
+            *read_error = ferror(input_file) != 0;
+            return TRUE;
+        }
     }
-
-    // 找不到近鄰
-    return -99999.0;
 }
 
-// 簡易雜湊函數
-static unsigned int hash_double_double(double d1, double d2) {
-    // 將兩個double轉為雜湊值
-    union {
-        double d;
-        unsigned int u[2];
-    } conv1 = {d1}, conv2 = {d2};
+// 讀取執行緒：切出以完整行結尾的區塊並交給工作執行緒
+static gpointer elevation_reader_thread(gpointer user_data) {
+    ElevationPipeline *pipeline = (ElevationPipeline *)user_data;
+    GString *carry = g_string_new(NULL);   // 上一個區塊尾端不完整的行
+    gboolean eof = FALSE;
 
-    return (conv1.u[0] ^ conv1.u[1] ^ conv2.u[0] ^ conv2.u[1]) % SEP_HASH_SIZE;
-}
+    while (!eof && !g_atomic_int_get(&pipeline->cancelled)) {
+        ElevationBlock *block = g_async_queue_pop(pipeline->free_blocks);
+        elevation_block_reset(block);
+        eof = elevation_read_block(pipeline->input_file, NULL, carry, block, &pipeline->read_us, &pipeline->read_error);
+
+        if (block->text->len == 0) {
+            g_async_queue_push(pipeline->free_blocks, block);
+            break;
+        }
 
-// 初始化雜湊表
-static SepHashTable* sep_hash_init(int size) {
-    SepHashTable *table = g_new(SepHashTable, 1);
-    table->size = size;
-    table->count = 0;
-    table->buckets = g_new0(SepEntry*, size);
-    return table;
+        block->sequence = pipeline->block_count++;
+        g_thread_pool_push(pipeline->workers, block, NULL);
+    }
+
+    g_string_free(carry, TRUE);
+    g_async_queue_push(pipeline->done_blocks, &pipeline->end_marker);
+    return NULL;
 }
 
-// 釋放雜湊表
-static void sep_hash_free(SepHashTable *table) {
-    if (!table) return;
+// 工作執行緒：處理一個區塊後交給寫出端；取消後只回傳區塊不處理
+static void elevation_worker_func(gpointer data, gpointer user_data) {
+    ElevationBlock *block = (ElevationBlock *)data;
+    ElevationPipeline *pipeline = (ElevationPipeline *)user_data;
 
-    for (int i = 0; i < table->size; i++) {
-        g_free(table->buckets[i]);
+    if (!g_atomic_int_get(&pipeline->cancelled)) {
+        SepLookupContext *lookup_ctx = g_async_queue_pop(pipeline->lookup_contexts);
+        elevation_block_process(block, pipeline->sep_data, pipeline->sep_raster, pipeline->sep_tin, lookup_ctx,
+                                pipeline->tide_format, pipeline->filtered_output);
+        g_async_queue_push(pipeline->lookup_contexts, lookup_ctx);
     }
-    g_free(table->buckets);
-    g_free(table);
+    g_async_queue_push(pipeline->done_blocks, block);
 }
 
-// 插入條目到雜湊表
-static void sep_hash_insert(SepHashTable *table, double longitude, double latitude, double adjustment) {
-    unsigned int hash = hash_double_double(longitude, latitude);
-    int index = hash % table->size;
-
-    // 簡單的鏈式衝突解決 - 每次插入到頭部
-    SepEntry *entry = g_new(SepEntry, 1);
-    entry->longitude = longitude;
-    entry->latitude = latitude;
-    entry->adjustment = adjustment;
+// 決定工作執行緒數：0 表示依處理器數量
+static int elevation_worker_count(const ElevationOptions *options) {
+    int workers = options->worker_count > 0 ? options->worker_count : (int)g_get_num_processors();
+    return CLAMP(workers, 1, ELEVATION_PIPELINE_MAX_WORKERS);
+}
 
-    // 鏈式插入
-    entry->next = table->buckets[index];
-    table->buckets[index] = entry;
-    table->count++;
+// 取得輸入格式：未指定時使用預設格式
+static const TideFormat* elevation_tide_format(const ElevationOptions *options) {
+    return options->tide_format ? options->tide_format : tide_format_default();
 }
 
-// 查找對應的調整值
-static double sep_hash_lookup(SepHashTable *table, double longitude, double latitude) {
-    unsigned int hash = hash_double_double(longitude, latitude);
-    int index = hash % table->size;
+// 進度估計：以已讀取的位元組數對照輸入檔案大小，並依目前每位元組的行數推估總行數與剩餘時間
+typedef struct {
+    gint64 file_size;         // 輸入檔案大小（fstat），無法取得時為 0
+    gint64 start_time;        // 開始處理的時間（g_get_monotonic_time）
+    gint64 start_bytes;       // 開始時已處理的位元組數（從檢查點繼續時不為 0）
+} ElevationProgress;
+
+static void elevation_progress_init(ElevationProgress *progress, FILE *input_file, gint64 start_bytes) {
+    struct stat st;
+    progress->file_size = 0;
+    if (fstat(fileno(input_file), &st) == 0 && S_ISREG(st.st_mode)) {
+        progress->file_size = (gint64)st.st_size;
+    }
+    progress->start_time = g_get_monotonic_time();
+    progress->start_bytes = start_bytes;
+}
 
-    SepEntry *entry = table->buckets[index];
-    while (entry) {
-        // 精度比較（考慮浮點數精度問題）
-        if (fabs(entry->longitude - longitude) < 1e-10 && fabs(entry->latitude - latitude) < 1e-10) {
-            return entry->adjustment;
-        }
-        entry = entry->next;
+// 產生進度訊息，回傳百分比；無法取得檔案大小時回傳 -1
+static double elevation_progress_format(const ElevationProgress *progress, gint64 bytes_done, int lines_done,
+                                        char *message, gsize message_size) {
+    if (progress->file_size <= 0 || bytes_done <= 0) {
+        g_snprintf(message, message_size, "處理中: 已處理 %d 行", lines_done);
+        return -1.0;
     }
 
-    // 未找到
-    return -99999.0; // 特殊值表示未找到
+    // Windows 文字模式會把 CRLF 讀成 LF，讀到的位元組數可能略少於檔案大小
+    double fraction = MIN((double)bytes_done / progress->file_size, 1.0);
+    int estimated_lines = (int)MAX(lines_done, lines_done / fraction + 0.5);
+    // 剩餘時間只以本次處理的部分推估速度，從檢查點繼續時不把先前完成的部分算進來
+    gint64 run_bytes = progress->file_size - progress->start_bytes;
+    double run_fraction = run_bytes > 0 ?
+        CLAMP((double)(bytes_done - progress->start_bytes) / run_bytes, 1e-6, 1.0) : 1.0;
+    double elapsed_seconds = (g_get_monotonic_time() - progress->start_time) / 1e6;
+    int remaining_seconds = (int)(elapsed_seconds * (1.0 - run_fraction) / run_fraction + 0.5);
+
+    if (remaining_seconds >= 60) {
+        g_snprintf(message, message_size, "處理中: %d / 約 %d 行 (%.1f%%)，剩餘約 %d 分 %02d 秒",
+                   lines_done, estimated_lines, fraction * 100.0, remaining_seconds / 60, remaining_seconds % 60);
+    } else {
+        g_snprintf(message, message_size, "處理中: %d / 約 %d 行 (%.1f%%)，剩餘約 %d 秒",
+                   lines_done, estimated_lines, fraction * 100.0, remaining_seconds);
+    }
+    return fraction * 100.0;
 }
 
-// 初始化複合結構 (包含空間網格)
-static SepDataStructure* sep_data_init(void) {
-    SepDataStructure *data = g_new(SepDataStructure, 1);
-    data->hash_table = NULL;
-    data->point_array = NULL;
-    data->spatial_grid = NULL;
-    return data;
+// 將已寫入的資料確實寫入磁碟（Windows 以 _commit 代替 fsync）
+static gboolean elevation_sync_file(FILE *file) {
+    if (fflush(file) != 0) return FALSE;
+#ifdef G_OS_WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
 }
 
-// 釋放複合結構 (包含空間網格)
-static void sep_data_free(SepDataStructure *data) {
-    if (!data) return;
-
-    if (data->hash_table) {
-        sep_hash_free(data->hash_table);
-    }
-    if (data->point_array) {
-        sep_point_array_free(data->point_array);
+// rename 之後同步所在目錄，讓目錄項目的變更也寫入磁碟（Windows 不支援也不需要）
+static void elevation_sync_parent_dir(const char *path) {
+#ifndef G_OS_WIN32
+    char *dir = g_path_get_dirname(path);
+    int fd = g_open(dir, O_RDONLY, 0);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
     }
-    if (data->spatial_grid) {
-        spatial_grid_free(data->spatial_grid);
-    }
-    g_free(data);
+    g_free(dir);
+#else
+    (void)path;
+#endif
 }
 
-// 載入SEP文件到複合結構 (效能優化最終版本)
-static SepDataStructure* load_sep_file_optimized(const char *sep_path) {
-    FILE *file = fopen(sep_path, "r");
-    if (!file) {
-        return NULL;
+// 寫入整個緩衝區（處理部分寫入與 EINTR）
+static gboolean elevation_write_all(int fd, const char *buffer, gsize length) {
+    while (length > 0) {
+        gssize written = write(fd, buffer, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return FALSE;
+        }
+        buffer += written;
+        length -= (gsize)written;
     }
+    return TRUE;
+}
 
-    // 階段1: 同時初始化所有索引結構
-    SepDataStructure *data = sep_data_init();
-    data->hash_table = sep_hash_init(SEP_HASH_SIZE);
-    data->point_array = sep_point_array_init(1024); // 預估容量
-    data->spatial_grid = spatial_grid_init(50, 50); // 50x50網格
+// 把 src_fd 從目前位置到結尾的內容寫到 dst_fd 的目前位置（兩者的位置都會前進）
+// Linux 優先以 copy_file_range 在核心內複製，不支援時改以大緩衝區讀寫
+static gboolean elevation_copy_fd(int src_fd, int dst_fd) {
+    gboolean ok = TRUE;
+    gboolean done = FALSE;
+#if defined(__linux__) && defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+    gboolean copied_any = FALSE;
+    while (!done && ok) {
+        ssize_t copied = copy_file_range(src_fd, NULL, dst_fd, NULL, ELEVATION_COPY_CHUNK, 0);
+        if (copied > 0) {
+            copied_any = TRUE;
+        } else if (copied == 0) {
+            done = TRUE;
+        } else if (errno == EINTR) {
+            continue;
+        } else if (!copied_any && (errno == ENOSYS || errno == EXDEV || errno == EINVAL ||
+                                   errno == EOPNOTSUPP || errno == EPERM)) {
+            break;  // 檔案系統或核心不支援，改用一般讀寫
+        } else {
+            ok = FALSE;
+        }
+    }
+#endif
 
-    char line[512];
-    int line_number = 0;
+    if (ok && !done) {
+        char *buffer = g_malloc(ELEVATION_COPY_CHUNK);
+        while (ok) {
+            gssize got = read(src_fd, buffer, ELEVATION_COPY_CHUNK);
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) {
+                ok = got == 0;
+                break;
+            }
+            ok = elevation_write_all(dst_fd, buffer, (gsize)got);
+        }
+        g_free(buffer);
+    }
+    return ok;
+}
 
-    while (fgets(line, sizeof(line), file)) {
-        line_number++;
+// 以 src_path 的內容取代 dst_path 的內容並同步到磁碟（rename 失敗時的備用方案）
+static gboolean elevation_copy_file_contents(const char *src_path, const char *dst_path, GError **error) {
+    int src_fd = g_open(src_path, O_RDONLY | O_BINARY, 0);
+    if (src_fd < 0) {
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno),
+                    "無法開啟過濾結果檔案: %s (%s)", src_path, g_strerror(errno));
+        return FALSE;
+    }
+    int dst_fd = g_open(dst_path, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, 0666);
+    if (dst_fd < 0) {
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno),
+                    "無法開啟原始檔案進行覆寫: %s (%s)", dst_path, g_strerror(errno));
+        close(src_fd);
+        return FALSE;
+    }
 
-        // 移除注释和空白
-        char *comment_pos = strchr(line, ';');
-        if (comment_pos) *comment_pos = '\0';
+    gboolean ok = elevation_copy_fd(src_fd, dst_fd);
+    if (ok) {
+#ifdef G_OS_WIN32
+        ok = _commit(dst_fd) == 0;
+#else
+        ok = fsync(dst_fd) == 0;
+#endif
+    }
+    int saved_errno = errno;
+    close(src_fd);
+    if (close(dst_fd) != 0) ok = FALSE;
 
-        // 将制表符和多个空格转换为单个空格
-        char *ptr = line;
-        while (*ptr) {
-            if (*ptr == '\t') *ptr = ' ';
-            ptr++;
-        }
+    if (!ok) {
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(saved_errno),
+                    "無法複製過濾結果到原始檔案: %s (%s)", dst_path, g_strerror(saved_errno));
+    }
+    return ok;
+}
 
-        // 跳过空行
-        g_strstrip(line);
-        if (strlen(line) == 0) continue;
+// 列索引位元圖寫出：各區塊的位元依序串接，區塊行數不必是 8 的倍數
+typedef struct {
+    FILE *file;
+    guint32 accumulator;      // 尚未寫出的位元
+    int pending_bits;
+    guint64 line_count;
+    guint64 kept_count;
+} ElevationBitmapWriter;
+
+static gboolean elevation_bitmap_open(ElevationBitmapWriter *writer, const char *path) {
+    memset(writer, 0, sizeof(*writer));
+    writer->file = fopen(path, "wb");
+    if (!writer->file) return FALSE;
+
+    // 先寫入佔位標頭，結束時再回填行數
+    ElevationBitmapHeader header;
+    memset(&header, 0, sizeof(header));
+    if (fwrite(&header, sizeof(header), 1, writer->file) != 1) {
+        fclose(writer->file);
+        writer->file = NULL;
+        return FALSE;
+    }
+    return TRUE;
+}
 
-        // 解析经纬度和调整值
-        double longitude, latitude, adjustment;
-        if (sscanf(line, "%lf %lf %lf", &longitude, &latitude, &adjustment) == 3) {
-            // 同時插入所有索引結構
-            sep_hash_insert(data->hash_table, longitude, latitude, adjustment);
-            sep_point_array_add(data->point_array, longitude, latitude, adjustment);
-            spatial_grid_add_point(data->spatial_grid, longitude, latitude, adjustment);
+// 附加一個區塊的位元，回傳是否全部寫入成功
+static gboolean elevation_bitmap_append(ElevationBitmapWriter *writer, const guint8 *bits, int line_count,
+                                        int kept_count) {
+    gboolean ok = TRUE;
+    for (int i = 0; i < line_count; i += 8) {
+        int take = MIN(8, line_count - i);
+        writer->accumulator |= (guint32)(bits[i >> 3] & ((1u << take) - 1)) << writer->pending_bits;
+        writer->pending_bits += take;
+        if (writer->pending_bits >= 8) {
+            ok = fputc((int)(writer->accumulator & 0xFF), writer->file) != EOF && ok;
+            writer->accumulator >>= 8;
+            writer->pending_bits -= 8;
         }
-        // 忽略格式錯誤的行
     }
-
-    fclose(file);
-    return data;
+    writer->line_count += (guint64)line_count;
+    writer->kept_count += (guint64)kept_count;
+    return ok;
 }
 
-
+// 寫出剩餘位元並回填標頭，回傳是否全部寫入成功
+static gboolean elevation_bitmap_close(ElevationBitmapWriter *writer) {
+    gboolean ok = writer->pending_bits <= 0 || fputc((int)(writer->accumulator & 0xFF), writer->file) != EOF;
+
+    ElevationBitmapHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ELEVATION_BITMAP_MAGIC, sizeof(header.magic));
+    header.line_count = writer->line_count;
+    header.kept_count = writer->kept_count;
+
+    ok = ok && fseek(writer->file, 0, SEEK_SET) == 0 &&
+         fwrite(&header, sizeof(header), 1, writer->file) == 1 &&
+         !ferror(writer->file);
+    ok = (fclose(writer->file) == 0) && ok;
+    writer->file = NULL;
+    return ok;
+}
 
 // 生成轉換後文件名（完整處理）
 static char* generate_converted_filename(const char *input_path) {
@@ -510,17 +672,19 @@ static char* generate_converted_filename(const char *input_path) {
 
 // 使用共享的 TideDataRow 結構定義（在 include/callbacks.h 中定義）
 
-// 簡化的進度更新回調函數類型（避免與 angle_parser.h 衝突）
-typedef void (*ElevationProgressCallback)(double progress, const char *message);
-
-// 主處理函數 - 高程轉換處理
-gboolean process_elevation_conversion(const char *input_path, const char *sep_path,
-                                    GString *result_text, GError **error, GtkProgressBar *progress_bar);
-
-// 進度回調函數實現
-gboolean process_elevation_conversion_with_callback(const char *input_path, const char *sep_path,
-                                    GString *result_text, GError **error,
-                                    void (*progress_callback)(double, const char*));
+void elevation_options_init(ElevationOptions *options) {
+    options->use_raster = FALSE;
+    options->raster_resolution = SEP_RASTER_DEFAULT_RESOLUTION;
+    options->use_tin = FALSE;
+    options->use_tiles = FALSE;
+    options->tile_size = SEP_TILES_DEFAULT_SIZE;
+    options->worker_count = 0;
+    options->shard_count = 0;
+    options->filtered_output = ELEVATION_FILTERED_REWRITE;
+    options->checkpoint_interval = ELEVATION_CHECKPOINT_DEFAULT_INTERVAL;
+    options->model_cache = NULL;
+    options->tide_format = NULL;
+}
 
 // 進度回調通用的實現模式
 static void dummy_progress_callback(double progress, const char *message) {
@@ -540,365 +704,1812 @@ gboolean process_elevation_conversion(const char *input_path, const char *sep_pa
 // 主處理函數 - 高程轉換處理 (支援進度回調)
 gboolean process_elevation_conversion_with_callback(const char *input_path, const char *sep_path,
                                     GString *result_text, GError **error, void (*progress_callback)(double, const char*)) {
-    // 記錄開始時間
-    time_t start_time = time(NULL);
+    return process_elevation_conversion_ex(input_path, sep_path, NULL, result_text, error, progress_callback);
+}
 
-    g_string_append_printf(result_text, "開始處理高程轉換：\n");
-    g_string_append_printf(result_text, "===========================================\n");
-    g_string_append_printf(result_text, "輸入檔案: %s\n", input_path);
-    g_string_append_printf(result_text, "SEP檔案: %s\n\n", sep_path);
+// 單一檔案的轉換統計
+typedef struct {
+    int total_lines;
+    int filtered_lines;
+    int processed_lines;
+    int matched_lines;
+    int interpolated_lines;
+    int raster_lines;
+    int tin_lines;
+    int fallback_lines;
+    int unmatched_lines;
+    Diagnostics diagnostics;  // 解析失敗行的分類計數與範例
+    gint64 bytes_read;
+    gint64 bytes_written;     // 轉換後資料的位元組數
+    SepLookupStats lookup_stats;
+    ElevationStageTimes stage_times;
+    char *converted_path;     // 轉換後檔案（成功時由統計持有）
+    char *bitmap_path;        // 過濾結果位元圖，未使用時為 NULL
+} ElevationFileStats;
+
+static void elevation_file_stats_clear(ElevationFileStats *stats) {
+    g_free(stats->converted_path);
+    g_free(stats->bitmap_path);
+    memset(stats, 0, sizeof(*stats));
+}
 
-    // 1. 載入SEP對照數據 (使用效能優化版本)
-    SepDataStructure *sep_data = load_sep_file_optimized(sep_path);
-    if (!sep_data) {
-        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "無法載入SEP檔案: %s", sep_path);
-        return FALSE;
-    }
+// 累加另一個檔案的統計（批次合計用，不含檔案路徑）
+static void elevation_file_stats_add(ElevationFileStats *total, const ElevationFileStats *stats) {
+    total->total_lines += stats->total_lines;
+    total->filtered_lines += stats->filtered_lines;
+    total->processed_lines += stats->processed_lines;
+    total->matched_lines += stats->matched_lines;
+    total->interpolated_lines += stats->interpolated_lines;
+    total->raster_lines += stats->raster_lines;
+    total->tin_lines += stats->tin_lines;
+    total->fallback_lines += stats->fallback_lines;
+    total->unmatched_lines += stats->unmatched_lines;
+    total->bytes_read += stats->bytes_read;
+    total->bytes_written += stats->bytes_written;
+    total->lookup_stats.lookups += stats->lookup_stats.lookups;
+    total->lookup_stats.reuse_hits += stats->lookup_stats.reuse_hits;
+    total->lookup_stats.warm_starts += stats->lookup_stats.warm_starts;
+    total->lookup_stats.cold_starts += stats->lookup_stats.cold_starts;
+    total->lookup_stats.lattice_lookups += stats->lookup_stats.lattice_lookups;
+    total->lookup_stats.rings_scanned += stats->lookup_stats.rings_scanned;
+    diagnostics_merge_counts(&total->diagnostics, &stats->diagnostics);
+    elevation_stage_times_add(&total->stage_times, &stats->stage_times);
+}
 
-    g_string_append_printf(result_text, "已載入 %d 個SEP對照點 (空間網格索引最終版本)\n", sep_data->hash_table->count);
+// 檢查點檔案 "<輸入檔>.checkpoint" 的內容（以 g_file_set_contents 整個寫出，取代時為原子操作）
+// 只記錄已完整寫出的區塊：輸入位置必定在行尾，各輸出位置是同步到磁碟之後的檔案長度
+#define ELEVATION_CHECKPOINT_MAGIC "ELVCKPT1"
+#define ELEVATION_CHECKPOINT_TAIL_BYTES (64 * 1024)  // 驗證輸出檔案時比對雜湊的結尾長度
 
-    // 2. 生成輸出文件名
-    char *converted_path = generate_converted_filename(input_path);
-    char *temp_filtered_path = g_strdup_printf("%s.filtered_temp", input_path);
-    g_string_append_printf(result_text, "轉換後檔案: %s\n", converted_path);
-    g_string_append_printf(result_text, "原始檔案將被修改為過濾後版本\n\n");
+typedef struct {
+    char magic[8];                  // ELEVATION_CHECKPOINT_MAGIC（不含結尾 '\0'）
+    guint64 key;                    // SEP檔案與轉換選項的識別值（elevation_checkpoint_key）
+    gint64 filtered_output;         // ElevationFilteredOutput
+    gint64 input_size;              // 輸入檔案大小與修改時間，任一改變時檢查點失效
+    gint64 input_mtime;
+    gint64 input_offset;            // 已寫出區塊在輸入中的結尾位置（讀取的位元組數）
+    gint64 converted_offset;        // 轉換後檔案的長度
+    guint64 converted_hash;         // 轉換後檔案在 converted_offset 之前結尾內容的雜湊
+    gint64 filtered_offset;         // 過濾暫存檔或位元圖的長度，不保留過濾結果時為 0
+    guint64 filtered_hash;
+    guint64 bitmap_line_count;      // 位元圖寫出端的狀態（尚未寫出的位元與累計行數）
+    guint64 bitmap_kept_count;
+    guint32 bitmap_accumulator;
+    gint32 bitmap_pending_bits;
+    gint64 total_lines;             // 累計統計
+    gint64 filtered_lines;
+    gint64 processed_lines;
+    gint64 matched_lines;
+    gint64 interpolated_lines;
+    gint64 raster_lines;
+    gint64 tin_lines;
+    gint64 fallback_lines;
+    gint64 unmatched_lines;
+    gint64 bytes_written;
+    guint64 diagnostic_counts[DIAGNOSTICS_MAX_CATEGORIES];
+    guint64 diagnostic_total;
+    gint64 diagnostic_example_count;
+    DiagnosticsExample diagnostic_examples[DIAGNOSTICS_MAX_EXAMPLES];
+} ElevationCheckpoint;
+
+// 單一檔案轉換的檢查點：識別欄位由呼叫端填入，其餘欄位在每次寫出時更新
+typedef struct {
+    char *path;                     // 檢查點檔案路徑
+    const char *converted_path;
+    const char *filtered_path;      // 過濾暫存檔或位元圖，不保留過濾結果時為 NULL
+    gint64 interval_us;             // 寫出間隔
+    ElevationCheckpoint state;
+    gboolean resumed;               // state 為從檢查點檔案載入的起始狀態
+    gboolean written;               // 本次轉換已寫出檢查點
+} ElevationCheckpointWriter;
+
+// 管線的輸出目標：轉換結果必定寫出，過濾結果依模式寫入暫存檔或位元圖（不需要時為 NULL）
+// checkpoint 為 NULL 時不寫檢查點（串流模式）
+typedef struct {
+    FILE *converted_file;
+    FILE *filtered_file;
+    ElevationBitmapWriter *bitmap_writer;
+    ElevationCheckpointWriter *checkpoint;
+} ElevationPipelineOutput;
+
+// 寫出一個已處理的區塊並累計統計（行號與輸入位置接續 stats 目前的值），回傳過濾結果與轉換結果是否全部寫出
+// 解析失敗的行只計數並保留前幾筆範例，不逐行寫入報告
+static gboolean elevation_write_block(const ElevationPipelineOutput *output, const ElevationBlock *block,
+                                      ElevationFileStats *stats, ElevationStageTimes *stage_times) {
+    for (guint i = 0; i < block->failed_lines->len; i++) {
+        const ElevationFailedLine *failed = &g_array_index(block->failed_lines, ElevationFailedLine, i);
+        diagnostics_record(&stats->diagnostics, failed->error, (gint64)stats->total_lines + failed->line_index + 1,
+                           block->text->str + failed->offset, failed->length);
+    }
 
-    // 3. 打開輸入檔案和輸出檔案
-    FILE *input_file = fopen(input_path, "r");
-    if (!input_file) {
-        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "無法打開輸入檔案: %s", input_path);
-        sep_data_free(sep_data);
-        g_free(converted_path);
-        g_free(temp_filtered_path);
-        return FALSE;
+    gint64 write_start = g_get_monotonic_time();
+    gboolean ok = TRUE;
+    if (output->filtered_file) {
+        ok = fwrite(block->filtered->str, 1, block->filtered->len, output->filtered_file) == block->filtered->len;
+    } else if (output->bitmap_writer) {
+        ok = elevation_bitmap_append(output->bitmap_writer, block->kept_bits->data, block->line_count,
+                                     block->processed_lines);
     }
+    ok = ok && fwrite(block->converted->str, 1, block->converted->len, output->converted_file) ==
+               block->converted->len;
+    stage_times->us[ELEVATION_STAGE_WRITE] += g_get_monotonic_time() - write_start;
+    elevation_stage_times_add(stage_times, &block->times);
+
+    stats->bytes_read += (gint64)block->text->len;
+    stats->bytes_written += (gint64)block->converted->len;
+    stats->total_lines += block->line_count;  // 動態統計總行數
+    stats->filtered_lines += block->filtered_lines;
+    stats->processed_lines += block->processed_lines;
+    stats->matched_lines += block->matched_lines;
+    stats->interpolated_lines += block->interpolated_lines;
+    stats->raster_lines += block->raster_lines;
+    stats->tin_lines += block->tin_lines;
+    stats->fallback_lines += block->fallback_lines;
+    stats->unmatched_lines += block->unmatched_lines;
+    return ok;
+}
 
-    FILE *converted_file = fopen(converted_path, "w");
-    if (!converted_file) {
-        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "無法創建轉換檔案: %s", converted_path);
-        fclose(input_file);
-        sep_data_free(sep_data);
-        g_free(converted_path);
-        g_free(temp_filtered_path);
-        return FALSE;
+#define ELEVATION_FNV_OFFSET G_GUINT64_CONSTANT(14695981039346656037)
+
+// 以 FNV-1a 累加一段記憶體
+static guint64 elevation_fnv1a(guint64 hash, const void *data, gsize length) {
+    const guchar *bytes = (const guchar *)data;
+    for (gsize i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= G_GUINT64_CONSTANT(1099511628211);
     }
+    return hash;
+}
 
-    FILE *temp_filtered_file = fopen(temp_filtered_path, "w");
-    if (!temp_filtered_file) {
-        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "無法創建臨時過濾檔案: %s", temp_filtered_path);
-        fclose(input_file);
-        fclose(converted_file);
-        sep_data_free(sep_data);
-        g_free(converted_path);
-        g_free(temp_filtered_path);
-        return FALSE;
+// 檢查點的識別值：SEP檔案（路徑、大小、修改時間）、查詢方式（含實際使用的分塊模型與分塊大小）與
+// 輸入格式，任何一項改變都可能產生不同的轉換結果，不能接續。工作執行緒數不影響結果，不列入
+static guint64 elevation_checkpoint_key(const char *sep_path, const ElevationOptions *options) {
+    GString *identity = g_string_new(sep_path);
+    GStatBuf st;
+    if (g_stat(sep_path, &st) == 0) {
+        g_string_append_printf(identity, "|%" G_GINT64_FORMAT "|%" G_GINT64_FORMAT,
+                               (gint64)st.st_size, (gint64)st.st_mtime);
+    }
+    g_string_append_printf(identity, "|raster=%d:%.17g|tin=%d", options->use_raster,
+                           options->use_raster ? options->raster_resolution : 0.0,
+                           options->use_tin && !options->use_raster);
+    // 分塊模型只在沒有網格與三角網時使用（兩者都需要完整模型）
+    gboolean use_tiles = options->use_tiles && !options->use_raster && !options->use_tin;
+    g_string_append_printf(identity, "|tiles=%d:%.17g", use_tiles, use_tiles ? options->tile_size : 0.0);
+
+    const TideFormat *format = elevation_tide_format(options);
+    g_string_append_printf(identity, "|format=%d:%d:%s:", format->delimiter, format->datetime_fields,
+                           format->layout_name ? format->layout_name : "");
+    for (int i = 0; i < format->column_count; i++) {
+        g_string_append_printf(identity, "%d,", (int)format->columns[i]);
     }
 
-    // 4. 初始化計數器和非同步統計
-    int total_lines = 0;
-    int processed_lines = 0;
-    int filtered_lines = 0;
-    int matched_lines = 0;
-    int interpolated_lines = 0;
-
-    // 初始化非同步統計
-    gboolean counting_done = FALSE;
-    gboolean cancel_counting = FALSE;
-    GMutex counting_mutex;
-    GCond counting_cond;
-
-    g_mutex_init(&counting_mutex);
-    g_cond_init(&counting_cond);
-
-    // 使用更大的緩衝區來提高讀取效率
-    char temp_line[8192];  // 8KB緩衝區
-
-    g_string_append_printf(result_text, "開始處理數據（背景統計總行數）...\n");
-
-    // 5. 逐行處理 - 支援非同步統計和取消
-    int current_line = 0;
-    int lines_since_last_update = 0;
-    int known_total_lines = 0;  // 已知的總行數
-
-    CountingData counting_data = {
-        .input_path = input_path,
-        .total_lines_ptr = &total_lines,
-        .counting_done_ptr = &counting_done,
-        .cancel_counting_ptr = &cancel_counting,
-        .known_total_lines_ptr = &known_total_lines,  // 指向主線程的變數
-        .counting_mutex = &counting_mutex,
-        .counting_cond = &counting_cond
-    };
-
-    // 啟動背景統計線程
-    GThread *counting_thread = g_thread_new("counting-thread", counting_thread_func, &counting_data);
-
-    while (fgets(temp_line, sizeof(temp_line), input_file)) {
-        current_line++;
-        total_lines++;  // 動態統計總行數
-
-        // 🔥 **強力取消檢查：每一行開始就檢查** 🔥
-        lines_since_last_update++;
-        if (lines_since_last_update >= 10000 || current_line % 10000 == 0) {  // 檢查統計更新
-
-            // 檢查統計狀態（確保記憶體可見性）
-            if (known_total_lines == 0) {
-                g_mutex_lock(&counting_mutex);
-                // 統計線程已經在鎖內設定了 known_total_lines
-                // 這裡只需要確保可見性
-                g_mutex_unlock(&counting_mutex);
-            }
+    guint64 key = elevation_fnv1a(ELEVATION_FNV_OFFSET, identity->str, identity->len);
+    g_string_free(identity, TRUE);
+    return key;
+}
 
-            // 進行進度更新
-            if (progress_callback) {
-                char progress_message[150];
-                if (known_total_lines > 0) {
-                    // 統計已完成，顯示精確進度
-                    double progress = (double)current_line / known_total_lines;
-                    sprintf(progress_message, "處理中: %d/%d (%.1f%%)", current_line, known_total_lines, progress * 100.0);
-                    progress_callback(progress * 100.0, progress_message);
-                } else {
-                    // 統計尚未完成，顯示已處理行數
-                    sprintf(progress_message, "處理中: 已處理 %d 行 (統計總行數中...)", current_line);
-                    progress_callback(-1.0, progress_message);
-                }
+// 計算檔案 offset 之前最後 ELEVATION_CHECKPOINT_TAIL_BYTES 位元組（不足時為全部）的雜湊；
+// 檔案不存在或比 offset 短時回傳 FALSE
+static gboolean elevation_file_tail_hash(const char *path, gint64 offset, guint64 *hash) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return FALSE;
 
-                // 檢查取消請求
-                if (error && *error && g_error_matches(*error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
-                    g_print("[CANCEL] 檢測到取消請求，正在終止處理循環和統計線程\n");
-                    cancel_counting = TRUE;  // 取消統計線程
-
-                    // 清理臨時檔案，防止覆蓋原始檔案
-                    if (temp_filtered_file) {
-                        fclose(temp_filtered_file);
-                        temp_filtered_file = NULL;
-                        remove(temp_filtered_path);  // 刪除臨時檔案
-                    }
-                    if (converted_file) {
-                        fclose(converted_file);
-                        converted_file = NULL;
-                        remove(converted_path);  // 刪除轉換檔案
-                    }
-
-                    break;  // 立即跳出處理循環
-                }
-            }
+    gboolean ok = fseeko(file, 0, SEEK_END) == 0 && ftello(file) >= offset;
+    gint64 start = MAX(offset - ELEVATION_CHECKPOINT_TAIL_BYTES, 0);
+    ok = ok && fseeko(file, (off_t)start, SEEK_SET) == 0;
 
-            lines_since_last_update = 0;
+    guchar buffer[ELEVATION_CHECKPOINT_TAIL_BYTES];
+    gsize want = (gsize)(offset - start);
+    ok = ok && fread(buffer, 1, want, file) == want;
+    fclose(file);
 
-            // 允許GUI事件處理
-            while (gtk_events_pending()) {
-                gtk_main_iteration();
-            }
-        }
+    if (ok) {
+        *hash = elevation_fnv1a(ELEVATION_FNV_OFFSET, buffer, want);
+    }
+    return ok;
+}
 
+// 同步輸出檔案並取得長度與結尾雜湊
+static gboolean elevation_checkpoint_mark(FILE *file, const char *path, gint64 *offset, guint64 *hash) {
+    if (!elevation_sync_file(file)) return FALSE;
+    *offset = (gint64)ftello(file);
+    return *offset >= 0 && elevation_file_tail_hash(path, *offset, hash);
+}
 
+// 寫出檢查點：先把輸出檔案同步到磁碟，再記錄位置與累計統計，當機時檢查點不會超前於輸出內容
+static gboolean elevation_checkpoint_save(ElevationCheckpointWriter *checkpoint, const ElevationPipelineOutput *output,
+                                          const ElevationFileStats *stats) {
+    ElevationCheckpoint *state = &checkpoint->state;
+    state->input_offset = stats->bytes_read;
+    if (!elevation_checkpoint_mark(output->converted_file, checkpoint->converted_path,
+                                   &state->converted_offset, &state->converted_hash)) {
+        return FALSE;
+    }
 
-        // 解析數據行
-        TideDataRow row;
-        if (!parse_tide_data_row(temp_line, &row)) {
-            g_string_append_printf(result_text, "警告: 第%d行解析失敗，跳過\n", current_line);
-            continue;
-        }
+    FILE *filtered_file = output->filtered_file ? output->filtered_file :
+                          output->bitmap_writer ? output->bitmap_writer->file : NULL;
+    state->filtered_offset = 0;
+    state->filtered_hash = 0;
+    if (filtered_file && !elevation_checkpoint_mark(filtered_file, checkpoint->filtered_path,
+                                                    &state->filtered_offset, &state->filtered_hash)) {
+        return FALSE;
+    }
+    if (output->bitmap_writer) {
+        state->bitmap_line_count = output->bitmap_writer->line_count;
+        state->bitmap_kept_count = output->bitmap_writer->kept_count;
+        state->bitmap_accumulator = output->bitmap_writer->accumulator;
+        state->bitmap_pending_bits = output->bitmap_writer->pending_bits;
+    }
 
-        // 過濾：檢查col6和col7是否其中一個為0
-        if (row.col6 == 0.0 || row.col7 == 0.0) {
-            filtered_lines++;
-            continue; // 不寫入輸出文件，直接跳過
-        }
+    state->total_lines = stats->total_lines;
+    state->filtered_lines = stats->filtered_lines;
+    state->processed_lines = stats->processed_lines;
+    state->matched_lines = stats->matched_lines;
+    state->interpolated_lines = stats->interpolated_lines;
+    state->raster_lines = stats->raster_lines;
+    state->tin_lines = stats->tin_lines;
+    state->fallback_lines = stats->fallback_lines;
+    state->unmatched_lines = stats->unmatched_lines;
+    state->bytes_written = stats->bytes_written;
+    memcpy(state->diagnostic_counts, stats->diagnostics.counts, sizeof(state->diagnostic_counts));
+    state->diagnostic_total = stats->diagnostics.total;
+    state->diagnostic_example_count = stats->diagnostics.example_count;
+    memcpy(state->diagnostic_examples, stats->diagnostics.examples, sizeof(state->diagnostic_examples));
+
+    if (!g_file_set_contents(checkpoint->path, (const gchar *)state, sizeof(*state), NULL)) {
+        return FALSE;
+    }
+    checkpoint->written = TRUE;
+    return TRUE;
+}
 
-        // 寫入過濾後檔案（原始格式，不進行轉換）
-        fputs(temp_line, temp_filtered_file);
+// 讀取並驗證檢查點：識別值、輸入檔案與過濾模式必須相同，各輸出檔案至少與記錄的長度一樣長，
+// 且該長度之前的結尾內容雜湊相符。成功時 state 成為起始狀態；檢查點存在但不可用時設定 reason
+static gboolean elevation_checkpoint_load(ElevationCheckpointWriter *checkpoint, const char **reason) {
+    *reason = NULL;
+    gchar *contents = NULL;
+    gsize length = 0;
+    if (!g_file_get_contents(checkpoint->path, &contents, &length, NULL)) {
+        return FALSE;
+    }
 
-        // 使用距離加權插值查找SEP對照值 (總是都會進行插值處理)
-        double exact_adjustment = sep_hash_lookup(sep_data->hash_table, row.longitude, row.latitude);
-        double interpolated_adjustment = -99999.0;
+    ElevationCheckpoint saved;
+    gboolean ok = length == sizeof(saved);
+    if (ok) {
+        memcpy(&saved, contents, sizeof(saved));
+    }
+    g_free(contents);
+
+    const ElevationCheckpoint *expected = &checkpoint->state;
+    guint64 hash = 0;
+    if (!ok || memcmp(saved.magic, ELEVATION_CHECKPOINT_MAGIC, sizeof(saved.magic)) != 0) {
+        *reason = "檢查點格式不符";
+    } else if (saved.key != expected->key || saved.filtered_output != expected->filtered_output) {
+        *reason = "SEP檔案或轉換選項已變更";
+    } else if (saved.input_size != expected->input_size || saved.input_mtime != expected->input_mtime ||
+               saved.input_offset < 0 || saved.input_offset > saved.input_size) {
+        *reason = "輸入檔案已變更";
+    } else if (saved.total_lines < 0 || saved.total_lines > G_MAXINT ||
+               saved.diagnostic_example_count < 0 || saved.diagnostic_example_count > DIAGNOSTICS_MAX_EXAMPLES ||
+               saved.bitmap_pending_bits < 0 || saved.bitmap_pending_bits >= 8) {
+        *reason = "檢查點內容不正確";
+    } else if (!elevation_file_tail_hash(checkpoint->converted_path, saved.converted_offset, &hash) ||
+               hash != saved.converted_hash) {
+        *reason = "轉換後檔案與檢查點不符";
+    } else if (checkpoint->filtered_path &&
+               (!elevation_file_tail_hash(checkpoint->filtered_path, saved.filtered_offset, &hash) ||
+                hash != saved.filtered_hash)) {
+        *reason = "過濾結果檔案與檢查點不符";
+    }
+    if (*reason) {
+        return FALSE;
+    }
 
-        gboolean has_exact_match = (exact_adjustment > -99998.0);
-        gboolean has_interpolation = FALSE;
-        char converted_line[1024];
+    checkpoint->state = saved;
+    checkpoint->resumed = TRUE;
+    return TRUE;
+}
 
-        if (!has_exact_match) {
-            interpolated_adjustment = sep_grid_lookup_with_interpolation(sep_data->spatial_grid,
-                                                                        row.longitude, row.latitude);
-            has_interpolation = (interpolated_adjustment > -99998.0);
-        }
+// 從檢查點恢復累計統計（診斷只恢復計數與範例，來源名稱等欄位沿用 diagnostics_init 的設定）
+static void elevation_checkpoint_restore(const ElevationCheckpoint *state, ElevationFileStats *stats) {
+    stats->total_lines = (int)state->total_lines;
+    stats->filtered_lines = (int)state->filtered_lines;
+    stats->processed_lines = (int)state->processed_lines;
+    stats->matched_lines = (int)state->matched_lines;
+    stats->interpolated_lines = (int)state->interpolated_lines;
+    stats->raster_lines = (int)state->raster_lines;
+    stats->tin_lines = (int)state->tin_lines;
+    stats->fallback_lines = (int)state->fallback_lines;
+    stats->unmatched_lines = (int)state->unmatched_lines;
+    stats->bytes_read = state->input_offset;
+    stats->bytes_written = state->bytes_written;
+    memcpy(stats->diagnostics.counts, state->diagnostic_counts, sizeof(stats->diagnostics.counts));
+    stats->diagnostics.total = state->diagnostic_total;
+    stats->diagnostics.stderr_reported = state->diagnostic_total;
+    stats->diagnostics.example_count = (int)state->diagnostic_example_count;
+    memcpy(stats->diagnostics.examples, state->diagnostic_examples, sizeof(stats->diagnostics.examples));
+}
 
-        // 決定使用的調整值：總是嘗試插值，每次數據都要有調整！
-        double final_adjustment;
-        if (has_exact_match) {
-            final_adjustment = exact_adjustment;
-            matched_lines++;  // 記錄精確匹配數量
-        } else if (has_interpolation) {
-            final_adjustment = interpolated_adjustment;
-            interpolated_lines++;  // 記錄插值匹配數量
-        } else {
-            // 插值也找不到點時，設定預設值（極端情況）
-            final_adjustment = 0.0;
-            // 不統計在任何處理類別中，因為這是無法處理的情況
-        }
+// 開啟檢查點之前寫出的輸出檔案：截斷到檢查點記錄的長度（丟棄檢查點之後寫出的部分）並從該處繼續寫入
+static FILE* elevation_open_resumed(const char *path, const char *mode, gint64 offset) {
+    FILE *file = fopen(path, mode);
+    if (!file) return NULL;
+#ifdef G_OS_WIN32
+    gboolean ok = _chsize_s(_fileno(file), offset) == 0;
+#else
+    gboolean ok = ftruncate(fileno(file), (off_t)offset) == 0;
+#endif
+    if (!ok || fseeko(file, (off_t)offset, SEEK_SET) != 0) {
+        fclose(file);
+        return NULL;
+    }
+    return file;
+}
 
-        // 應用調整值到數據行
-        row.tide += final_adjustment;
-        row.processed_depth -= final_adjustment;
+// 從檢查點繼續寫出位元圖：恢復尚未寫出的位元與累計行數（標頭仍是佔位內容，結束時回填）
+static gboolean elevation_bitmap_reopen(ElevationBitmapWriter *writer, const char *path,
+                                        const ElevationCheckpoint *state) {
+    memset(writer, 0, sizeof(*writer));
+    writer->file = elevation_open_resumed(path, "r+b", state->filtered_offset);
+    if (!writer->file) return FALSE;
+
+    writer->accumulator = state->bitmap_accumulator;
+    writer->pending_bits = state->bitmap_pending_bits;
+    writer->line_count = state->bitmap_line_count;
+    writer->kept_count = state->bitmap_kept_count;
+    return TRUE;
+}
 
-        // 格式化轉換後輸出行（保持原始格式，所有資料都處理）
-        snprintf(converted_line, sizeof(converted_line),
-                "%s/%.3f/%.7f/%.7f/%.3f/%.3f/%.3f\n",
-                row.datetime, row.tide, row.longitude, row.latitude,
-                row.processed_depth, row.col6, row.col7);
+// 讓輸入從檢查點的位置繼續讀取。Windows 文字模式會把 CRLF 讀成 LF，讀取的位元組數與檔案位置
+// 不同，只能循序讀過；其他平台直接 seek
+static gboolean elevation_skip_input(FILE *input_file, gint64 offset) {
+#ifdef G_OS_WIN32
+    char *buffer = g_malloc(ELEVATION_COPY_CHUNK);
+    while (offset > 0) {
+        size_t want = (size_t)MIN(offset, (gint64)ELEVATION_COPY_CHUNK);
+        if (fread(buffer, 1, want, input_file) != want) break;
+        offset -= (gint64)want;
+    }
+    g_free(buffer);
+    return offset == 0;
+#else
+    return fseeko(input_file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
 
-        // 寫入轉換後檔案
-        fputs(converted_line, converted_file);
-        processed_lines++;
+// 以平行管線轉換一個輸入串流：只循序讀取與寫出，不做 seek，記憶體用量固定為區塊池大小
+//
+// 單檔模式由 progress_callback 回報進度並偵測取消；批次模式改由 batch_cancelled 通知取消，
+// 並把已讀取的 KB 數寫入 progress_kb。統計累計到 stats 的計數欄位（不含檔案路徑）。
+// 有檢查點時定期寫出，取消時也在停止前寫出；從檢查點繼續時統計與行號接續檢查點的狀態。
+// 取消、讀取或寫出錯誤時回傳 FALSE；取消時不設定 error（取消錯誤由進度回調設定）
+static gboolean elevation_run_pipeline(FILE *input_file, const char *input_name,
+                                       const ElevationPipelineOutput *output,
+                                       const SepDataStructure *sep_data, const SepRaster *sep_raster,
+                                       const SepTin *sep_tin, const TideFormat *tide_format, ElevationFilteredOutput filtered_output,
+                                       int worker_count,
+                                       GString *result_text, ElevationFileStats *stats, GError **error,
+                                       ElevationProgressCallback progress_callback,
+                                       gint *batch_cancelled, gint *progress_kb) {
+    // 1. 初始化計數器：從檢查點繼續時接續檢查點的累計統計
+    ElevationCheckpointWriter *checkpoint = output->checkpoint;
+    ElevationStageTimes stage_times;
+    memset(&stage_times, 0, sizeof(stage_times));
+    gboolean write_error = FALSE;
+    int write_errno = 0;
+    gboolean cancel_requested = FALSE;
+
+    g_string_append_printf(result_text, "開始處理數據...\n");
+    diagnostics_init(&stats->diagnostics, input_name, tide_format_row_error_names(), TIDE_ROW_ERROR_COUNT, TRUE);
+    if (checkpoint && checkpoint->resumed) {
+        elevation_checkpoint_restore(&checkpoint->state, stats);
     }
 
-    // 6. 清理資源並覆蓋原始檔案為過濾版本
-    fclose(input_file);
+    // 2. 分區塊處理：進度以已讀取的位元組數對照檔案大小估計，不需另外掃描整個檔案統計行數
+    gint64 last_checkpoint_time = g_get_monotonic_time();
+    ElevationProgress progress;
+    elevation_progress_init(&progress, input_file, stats->bytes_read);
+
+    // 平行管線：讀取執行緒 → 工作執行緒（解析、過濾、查詢、格式化）→ 本執行緒依序寫出
+    int block_pool_size = worker_count * 2 + 2;
+    g_string_append_printf(result_text, "平行處理: %d 個工作執行緒，每區塊約 %d KB\n",
+                           worker_count, ELEVATION_PIPELINE_BLOCK_BYTES / 1024);
+
+    ElevationPipeline pipeline;
+    memset(&pipeline, 0, sizeof(pipeline));
+    pipeline.input_file = input_file;
+    pipeline.sep_data = sep_data;
+    pipeline.sep_raster = sep_raster;
+    pipeline.sep_tin = sep_tin;
+    pipeline.tide_format = tide_format;
+    pipeline.filtered_output = filtered_output;
+    pipeline.free_blocks = g_async_queue_new();
+    pipeline.done_blocks = g_async_queue_new();
+    pipeline.lookup_contexts = g_async_queue_new();
+
+    ElevationBlock **pending_blocks = g_new0(ElevationBlock *, block_pool_size);
+    for (int i = 0; i < block_pool_size; i++) {
+        g_async_queue_push(pipeline.free_blocks, elevation_block_new(SEP_BATCH_BLOCK_ROWS));
+    }
+    SepLookupContext **lookup_contexts = g_new(SepLookupContext *, worker_count);
+    for (int i = 0; i < worker_count; i++) {
+        lookup_contexts[i] = sep_lookup_context_new();
+        g_async_queue_push(pipeline.lookup_contexts, lookup_contexts[i]);
+    }
 
-    // 檢查是否因為取消而提前退出
-    if (error && *error && g_error_matches(*error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
-        g_print("[CANCEL] 因為取消請求，跳過檔案覆蓋操作\n");
+    pipeline.workers = g_thread_pool_new(elevation_worker_func, &pipeline, worker_count, FALSE, NULL);
+    GThread *reader_thread = g_thread_new("elevation-reader", elevation_reader_thread, &pipeline);
 
-        // 清理臨時檔案
-        if (temp_filtered_file) {
-            fclose(temp_filtered_file);
-            remove(temp_filtered_path);
-        }
-        if (converted_file) {
-            fclose(converted_file);
-            remove(converted_path);
+    // 區塊完成順序不定，暫存在 pending_blocks[序號 % 區塊數]，依序號寫出
+    gint64 next_sequence = 0;
+    gint64 total_blocks = -1;
+    while (total_blocks < 0 || next_sequence < total_blocks) {
+        ElevationBlock *block = g_async_queue_pop(pipeline.done_blocks);
+        if (block == &pipeline.end_marker) {
+            total_blocks = pipeline.block_count;
+            continue;
         }
+        pending_blocks[block->sequence % block_pool_size] = block;
 
-        sep_data_free(sep_data);
-        g_free(converted_path);
-        g_free(temp_filtered_path);
+        while ((block = pending_blocks[next_sequence % block_pool_size]) != NULL &&
+               block->sequence == next_sequence) {
+            pending_blocks[next_sequence % block_pool_size] = NULL;
+            next_sequence++;
+
+            if (g_atomic_int_get(&pipeline.cancelled)) {
+                g_async_queue_push(pipeline.free_blocks, block);
+                continue;
+            }
 
-        // 等待統計線程完成並清理資源
-        g_thread_join(counting_thread);
-        g_mutex_clear(&counting_mutex);
-        g_cond_clear(&counting_cond);
+            // 2a. 依區塊順序寫出過濾結果與轉換後檔案並累計統計
+            if (!elevation_write_block(output, block, stats, &stage_times)) {
+                // 寫出失敗（磁碟已滿、串流的下游已關閉）時停止讀取，不再等到結尾才發現
+                write_error = TRUE;
+                write_errno = errno;
+                g_atomic_int_set(&pipeline.cancelled, 1);
+            }
+            g_async_queue_push(pipeline.free_blocks, block);
 
-        return FALSE;  // 返回失敗，因為操作被取消
-    }
+            // 2b. 定期寫出檢查點（寫出失敗只影響之後能否從中斷處繼續，不中止轉換）
+            gint64 now = g_get_monotonic_time();
+            if (checkpoint && !write_error && now - last_checkpoint_time >= checkpoint->interval_us) {
+                if (!elevation_checkpoint_save(checkpoint, output, stats)) {
+                    g_print("[WARNING] 無法寫出檢查點: %s\n", checkpoint->path);
+                }
+                last_checkpoint_time = g_get_monotonic_time();
+                stage_times.us[ELEVATION_STAGE_WRITE] += last_checkpoint_time - now;
+            }
+
+            // 2c. 每個區塊寫出後更新進度並檢查取消
+            if (progress_callback) {
+                char progress_message[200];
+                double percentage = elevation_progress_format(&progress, stats->bytes_read, stats->total_lines,
+                                                              progress_message, sizeof(progress_message));
+                progress_callback(percentage, progress_message);
 
-    // 關閉檔案
-    fclose(temp_filtered_file);
-    fclose(converted_file);
+                // 檢查取消請求：停止讀取，已送出的區塊只回收不寫出
+                if (error && *error && g_error_matches(*error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+                    g_print("[CANCEL] 檢測到取消請求，正在終止處理管線\n");
+                    g_atomic_int_set(&pipeline.cancelled, 1);
+                    cancel_requested = TRUE;
+                }
+            }
+            if (progress_kb) {
+                g_atomic_int_set(progress_kb, (gint)(stats->bytes_read / 1024));
+            }
+            if (batch_cancelled && g_atomic_int_get(batch_cancelled)) {
+                g_atomic_int_set(&pipeline.cancelled, 1);
+                cancel_requested = TRUE;
+            }
+        }
+    }
 
-    // 用過濾後的臨時檔案覆蓋原始檔案
-    if (rename(temp_filtered_path, input_path) != 0) {
-        // 顯示詳細的rename錯誤信息
-        g_print("[ERROR] rename() 失敗: %s -> %s\n", temp_filtered_path, input_path);
-        g_print("[ERROR] 錯誤代碼: %d, 錯誤訊息: %s\n", errno, strerror(errno));
+    g_thread_join(reader_thread);
+    g_thread_pool_free(pipeline.workers, FALSE, TRUE);
+    diagnostics_finish(&stats->diagnostics);
+
+    // 合併各工作執行緒的查詢游標統計
+    for (int i = 0; i < worker_count; i++) {
+        SepLookupStats lookup_stats;
+        sep_lookup_context_get_stats(lookup_contexts[i], &lookup_stats);
+        stats->lookup_stats.lookups += lookup_stats.lookups;
+        stats->lookup_stats.reuse_hits += lookup_stats.reuse_hits;
+        stats->lookup_stats.warm_starts += lookup_stats.warm_starts;
+        stats->lookup_stats.cold_starts += lookup_stats.cold_starts;
+        stats->lookup_stats.lattice_lookups += lookup_stats.lattice_lookups;
+        stats->lookup_stats.rings_scanned += lookup_stats.rings_scanned;
+        sep_lookup_context_free(lookup_contexts[i]);
+    }
+    g_free(lookup_contexts);
 
-        // 如果 rename 失敗，嘗試複製刪除的方法
-        g_print("[INFO] 嘗試備用方案：複製檔案內容...\n");
+    for (int i = 0; i < block_pool_size; i++) {
+        elevation_block_free(g_async_queue_pop(pipeline.free_blocks));
+    }
+    g_free(pending_blocks);
+    g_async_queue_unref(pipeline.free_blocks);
+    g_async_queue_unref(pipeline.done_blocks);
+    g_async_queue_unref(pipeline.lookup_contexts);
+
+    if (pipeline.read_error && !(error && *error)) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_IO, "讀取輸入檔案時發生錯誤: %s", input_name);
+    } else if (write_error && !(error && *error)) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_IO, "寫入輸出檔案時發生錯誤: %s", g_strerror(write_errno));
+    }
 
-        FILE *src = fopen(temp_filtered_path, "rb");
-        FILE *dst = fopen(input_path, "wb");
+    // 取消時已送出的區塊都已寫出或丟棄，記錄目前的位置，下次從這裡繼續
+    if (checkpoint && cancel_requested && !write_error && !pipeline.read_error &&
+        !elevation_checkpoint_save(checkpoint, output, stats)) {
+        g_print("[WARNING] 無法寫出檢查點: %s\n", checkpoint->path);
+    }
+    stage_times.us[ELEVATION_STAGE_READ] = pipeline.read_us;
+    elevation_stage_times_add(&stats->stage_times, &stage_times);
+    return !g_atomic_int_get(&pipeline.cancelled) && !pipeline.read_error;
 
-        g_print("[DEBUG] 開啟檔案: src=%s (%p), dst=%s (%p)\n", temp_filtered_path, src, input_path, dst);
+}
 
-        if (src && dst) {
-            char buffer[8192];
-            size_t bytes;
-            gboolean copy_success = TRUE;
-            size_t total_bytes = 0;
+#ifndef G_OS_WIN32
+// 多行程分段轉換：輸入依位元組切成以行尾為界的數段，每段以 posix_spawn 重新執行本程式的
+// ELEVATION_SHARD_WORKER_ARG 模式（工作行程），以單一執行緒轉換並寫出該段的輸出檔案。
+// GUI 行程有 GTK 與 GLib 的執行緒，fork 後子行程若碰到其他執行緒持有的鎖（malloc、stdio、GLib）
+// 可能永遠卡住，因此不在 fork 出的子行程中轉換；工作行程是全新的行程，自行以唯讀記憶體映射
+// 開啟父行程載入時已建立的SEP二進位快取（以及網格、三角網或分塊快取），各行程共用同一份頁快取。
+// 全部完成後父行程依段落順序串接各段輸出並合併統計，結果與不分段轉換完全相同
 
-            g_print("[DEBUG] 開始複製檔案內容...\n");
+// 本程式的執行檔路徑（elevation_set_shard_executable 設定），未設定時不使用分段轉換
+static char *elevation_shard_executable = NULL;
 
-            while ((bytes = fread(buffer, 1, sizeof(buffer), src)) > 0) {
-                total_bytes += bytes;
-                if (fwrite(buffer, 1, bytes, dst) != bytes) {
-                    copy_success = FALSE;
-                    g_print("[ERROR] fwrite() 失敗: 寫入 %zu 位元組失敗，錯誤: %s\n", bytes, strerror(errno));
+// 工作行程與父行程共用的狀態（"<轉換後檔案>.shards" 檔案的 MAP_SHARED 映射，每段一份）
+typedef struct {
+    gint progress_kb;               // 已讀取的 KB 數（g_atomic_int）
+    gint progress_lines;            // 已處理的行數（g_atomic_int）
+    gint success;                   // 工作行程已寫出並關閉該段的所有輸出
+    char error_message[256];        // 工作行程失敗的原因
+    ElevationFileStats stats;       // 該段的統計（不含檔案路徑；診斷的字串指標由工作行程清除，父行程只讀取數值）
+} ElevationShardSlot;
+
+// 以行尾為界把輸入切成最多 shard_count 段，第 i 段為 [bounds[i], bounds[i + 1])；回傳實際段數
+// （檔案太小或行數太少時較少）
+static int elevation_shard_bounds(FILE *input_file, gint64 file_size, int shard_count, gint64 *bounds) {
+    int count = 0;
+    bounds[0] = 0;
+    for (int i = 1; i < shard_count; i++) {
+        // 從目標位置的前一個位元組開始找換行，段落從換行之後開始
+        gint64 target = file_size * i / shard_count;
+        gint64 bound = file_size;
+        if (target > 0 && fseeko(input_file, (off_t)(target - 1), SEEK_SET) == 0) {
+            gint64 position = target - 1;
+            int c;
+            while ((c = getc(input_file)) != EOF) {
+                position++;
+                if (c == '\n') {
+                    bound = position;
                     break;
                 }
             }
+        }
+        if (bound >= file_size) break;
+        if (bound > bounds[count]) {
+            bounds[++count] = bound;
+        }
+    }
+    bounds[++count] = file_size;
+    return count;
+}
 
-            g_print("[DEBUG] 複製完成，共複製 %zu 位元組\n", total_bytes);
+// 工作行程：以單一執行緒循序轉換輸入的 [start, end)，寫出該段的輸出檔案，統計寫入 slot
+static gboolean elevation_shard_convert(const char *input_path, gint64 start, gint64 end,
+                                        const char *converted_path, const char *filtered_path,
+                                        const char *bitmap_path, const SepDataStructure *sep_data,
+                                        const SepRaster *sep_raster, const SepTin *sep_tin,
+                                        const TideFormat *tide_format, ElevationFilteredOutput filtered_output,
+                                        ElevationShardSlot *slot) {
+    ElevationFileStats *stats = &slot->stats;
+    FILE *input_file = fopen(input_path, "r");
+    FILE *converted_file = fopen(converted_path, "w");
+    FILE *filtered_file = filtered_path ? fopen(filtered_path, "w") : NULL;
+    ElevationBitmapWriter bitmap_writer;
+    memset(&bitmap_writer, 0, sizeof(bitmap_writer));
+    gboolean ok = input_file && converted_file && (!filtered_path || filtered_file) &&
+                  (!bitmap_path || elevation_bitmap_open(&bitmap_writer, bitmap_path)) &&
+                  fseeko(input_file, (off_t)start, SEEK_SET) == 0;
+    if (!ok) {
+        g_snprintf(slot->error_message, sizeof(slot->error_message), "無法開啟分段的輸入或輸出檔案 (%s)",
+                   g_strerror(errno));
+    }
 
-            fclose(src);
-            fclose(dst);
+    if (ok) {
+        setvbuf(converted_file, NULL, _IOFBF, ELEVATION_OUTPUT_BUFFER);
+        if (filtered_file) {
+            setvbuf(filtered_file, NULL, _IOFBF, ELEVATION_OUTPUT_BUFFER);
+        }
+        ElevationPipelineOutput output = { converted_file, filtered_file,
+                                           bitmap_path ? &bitmap_writer : NULL, NULL };
+        ElevationBlock *block = elevation_block_new(SEP_BATCH_BLOCK_ROWS);
+        SepLookupContext *lookup_ctx = sep_lookup_context_new();
+        GString *carry = g_string_new(NULL);
+        gint64 remaining = end - start;
+        gint64 read_us = 0;
+        gboolean read_error = FALSE;
+        gboolean eof = FALSE;
+
+        while (ok && !eof) {
+            elevation_block_reset(block);
+            eof = elevation_read_block(input_file, &remaining, carry, block, &read_us, &read_error);
+            if (block->text->len == 0) break;
+
+            elevation_block_process(block, sep_data, sep_raster, sep_tin, lookup_ctx, tide_format, filtered_output);
+            ok = elevation_write_block(&output, block, stats, &stats->stage_times);
+            g_atomic_int_set(&slot->progress_kb, (gint)(stats->bytes_read / 1024));
+            g_atomic_int_set(&slot->progress_lines, stats->total_lines);
+        }
+        if (!ok || read_error) {
+            g_snprintf(slot->error_message, sizeof(slot->error_message), "%s時發生錯誤 (%s)",
+                       read_error ? "讀取輸入" : "寫出分段結果", g_strerror(errno));
+            ok = FALSE;
+        }
+        stats->stage_times.us[ELEVATION_STAGE_READ] += read_us;
+        sep_lookup_context_get_stats(lookup_ctx, &stats->lookup_stats);
+
+        g_string_free(carry, TRUE);
+        sep_lookup_context_free(lookup_ctx);
+        elevation_block_free(block);
+    }
+
+    if (input_file) fclose(input_file);
+    if (converted_file) {
+        gboolean write_ok = fflush(converted_file) == 0 && !ferror(converted_file);
+        ok = (fclose(converted_file) == 0) && write_ok && ok;
+    }
+    if (filtered_file) {
+        gboolean write_ok = fflush(filtered_file) == 0 && !ferror(filtered_file);
+        ok = (fclose(filtered_file) == 0) && write_ok && ok;
+    }
+    if (bitmap_writer.file) {
+        ok = elevation_bitmap_close(&bitmap_writer) && ok;
+    }
+    if (!ok && slot->error_message[0] == '\0') {
+        g_snprintf(slot->error_message, sizeof(slot->error_message), "關閉分段輸出檔案時發生錯誤 (%s)",
+                   g_strerror(errno));
+    }
+    return ok;
+}
+
+// 把分段輸出檔案的內容附加到已開啟的輸出檔案結尾（先送出 stdio 緩衝區，再以檔案描述符複製）
+static gboolean elevation_shard_append_file(FILE *file, const char *path) {
+    int src_fd = g_open(path, O_RDONLY | O_BINARY, 0);
+    if (src_fd < 0) return FALSE;
+    gboolean ok = fflush(file) == 0 && elevation_copy_fd(src_fd, fileno(file));
+    close(src_fd);
+    return ok;
+}
+
+// 把分段位元圖的位元依序附加到位元圖寫出端
+static gboolean elevation_shard_append_bitmap(ElevationBitmapWriter *writer, const char *path) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return FALSE;
+
+    ElevationBitmapHeader header;
+    gboolean ok = fread(&header, sizeof(header), 1, file) == 1 &&
+                  memcmp(header.magic, ELEVATION_BITMAP_MAGIC, sizeof(header.magic)) == 0;
+    guint8 bits[64 * 1024];
+    guint64 lines_left = ok ? header.line_count : 0;
+    while (ok && lines_left > 0) {
+        guint64 lines = MIN(lines_left, (guint64)sizeof(bits) * 8);
+        size_t bytes = (size_t)((lines + 7) / 8);
+        ok = fread(bits, 1, bytes, file) == bytes && elevation_bitmap_append(writer, bits, (int)lines, 0);
+        lines_left -= lines;
+    }
+    if (ok) {
+        writer->kept_count += header.kept_count;
+    }
+    fclose(file);
+    return ok;
+}
 
-            if (copy_success) {
-                // 刪除臨時檔案
-                if (remove(temp_filtered_path) == 0) {
-                    g_print("[SUCCESS] 檔案覆蓋成功，使用備用方案\n");
+// 建立第 index 段工作行程的命令列（格式見 elevation_shard_worker_main），以 g_ptr_array_free(args, TRUE) 釋放
+static GPtrArray* elevation_shard_args(const char *slots_path, int index, const char *input_path, gint64 start,
+                                       gint64 end, const char *sep_path, const char *converted_path,
+                                       const char *filtered_path, const char *bitmap_path,
+                                       const ElevationOptions *options) {
+    char number[G_ASCII_DTOSTR_BUF_SIZE];
+    GPtrArray *args = g_ptr_array_new_with_free_func(g_free);
+    g_ptr_array_add(args, g_strdup(elevation_shard_executable));
+    g_ptr_array_add(args, g_strdup(ELEVATION_SHARD_WORKER_ARG));
+    g_ptr_array_add(args, g_strdup(slots_path));
+    g_ptr_array_add(args, g_strdup_printf("%d", index));
+    g_ptr_array_add(args, g_strdup(input_path));
+    g_ptr_array_add(args, g_strdup_printf("%" G_GINT64_FORMAT, start));
+    g_ptr_array_add(args, g_strdup_printf("%" G_GINT64_FORMAT, end));
+    g_ptr_array_add(args, g_strdup(sep_path));
+    g_ptr_array_add(args, g_strdup(converted_path));
+    g_ptr_array_add(args, g_strdup(filtered_path ? filtered_path : "-"));
+    g_ptr_array_add(args, g_strdup(bitmap_path ? bitmap_path : "-"));
+    g_ptr_array_add(args, g_strdup_printf("%d", (int)options->filtered_output));
+    // 解析度與分塊大小以可完整還原的格式傳遞，工作行程才會找到父行程建立的同一份快取
+    if (options->use_raster) {
+        g_ptr_array_add(args, g_strdup("--raster"));
+        g_ptr_array_add(args, g_strdup(g_ascii_dtostr(number, sizeof(number), options->raster_resolution)));
+    }
+    if (options->use_tin) {
+        g_ptr_array_add(args, g_strdup("--tin"));
+    }
+    if (options->use_tiles) {
+        g_ptr_array_add(args, g_strdup("--tiles"));
+        g_ptr_array_add(args, g_strdup(g_ascii_dtostr(number, sizeof(number), options->tile_size)));
+    }
+    g_ptr_array_add(args, g_strdup("--format"));
+    g_ptr_array_add(args, tide_format_to_spec(elevation_tide_format(options)));
+    g_ptr_array_add(args, NULL);
+    return args;
+}
+
+// 以 shard_count 個工作行程分段轉換，各段輸出依序串接到 output，統計合併到 stats
+//
+// 呼叫前SEP必須已以相同的選項載入過（二進位、網格、三角網與分塊快取都已寫出），工作行程直接映射快取。
+// 進度與取消和單檔管線相同，由 progress_callback 處理；取消時終止所有工作行程。
+// 取消或任一段失敗時回傳 FALSE；取消時不設定 error（取消錯誤由進度回調設定）
+static gboolean elevation_run_shards(FILE *input_file, const char *input_path, const char *sep_path,
+                                     const ElevationOptions *options, const ElevationPipelineOutput *output,
+                                     const char *converted_path, const char *filtered_path, const char *bitmap_path,
+                                     int shard_count, GString *result_text, ElevationFileStats *stats,
+                                     GError **error, ElevationProgressCallback progress_callback) {
+    // 1. 以行尾為界切段
+    struct stat st;
+    if (fstat(fileno(input_file), &st) != 0) {
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno), "無法取得輸入檔案大小: %s", input_path);
+        return FALSE;
+    }
+    gint64 *bounds = g_new(gint64, shard_count + 1);
+    shard_count = elevation_shard_bounds(input_file, (gint64)st.st_size, shard_count, bounds);
+    g_string_append_printf(result_text, "開始處理數據...\n");
+    g_string_append_printf(result_text, "多行程分段轉換: %d 段，每段由一個工作行程以單一執行緒轉換\n", shard_count);
+    diagnostics_init(&stats->diagnostics, input_path, tide_format_row_error_names(), TIDE_ROW_ERROR_COUNT, TRUE);
+
+    // 2. 工作行程與父行程共用的狀態（檔案以 ftruncate 補零）與各段的輸出路徑
+    gsize slots_size = sizeof(ElevationShardSlot) * (gsize)shard_count;
+    char *slots_path = g_strdup_printf("%s.shards", converted_path);
+    ElevationShardSlot *slots = MAP_FAILED;
+    int slots_fd = g_open(slots_path, O_RDWR | O_CREAT | O_TRUNC | O_BINARY, 0600);
+    if (slots_fd >= 0 && ftruncate(slots_fd, (off_t)slots_size) == 0) {
+        slots = mmap(NULL, slots_size, PROT_READ | PROT_WRITE, MAP_SHARED, slots_fd, 0);
+    }
+    if (slots == MAP_FAILED) {
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno), "無法建立分段轉換的共用狀態檔 %s (%s)",
+                    slots_path, g_strerror(errno));
+        if (slots_fd >= 0) {
+            close(slots_fd);
+            remove(slots_path);
+        }
+        g_free(slots_path);
+        g_free(bounds);
+        return FALSE;
+    }
+    close(slots_fd);
+
+    char **shard_converted = g_new0(char *, shard_count);
+    char **shard_filtered = g_new0(char *, shard_count);
+    char **shard_bitmap = g_new0(char *, shard_count);
+    pid_t *pids = g_new0(pid_t, shard_count);
+    for (int i = 0; i < shard_count; i++) {
+        shard_converted[i] = g_strdup_printf("%s.shard%d", converted_path, i);
+        shard_filtered[i] = filtered_path ? g_strdup_printf("%s.shard%d", filtered_path, i) : NULL;
+        shard_bitmap[i] = bitmap_path ? g_strdup_printf("%s.shard%d", bitmap_path, i) : NULL;
+    }
+
+    // 3. 啟動工作行程：posix_spawn 在子行程中只執行 exec，在多執行緒的行程中也可以安全使用
+    gboolean failed = FALSE;
+    int running = 0;
+    for (int i = 0; i < shard_count; i++) {
+        GPtrArray *args = elevation_shard_args(slots_path, i, input_path, bounds[i], bounds[i + 1], sep_path,
+                                               shard_converted[i], shard_filtered[i], shard_bitmap[i], options);
+        pid_t pid = 0;
+        int spawn_error = posix_spawn(&pid, elevation_shard_executable, NULL, NULL,
+                                      (char * const *)args->pdata, environ);
+        g_ptr_array_free(args, TRUE);
+        if (spawn_error != 0) {
+            g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(spawn_error),
+                        "無法啟動分段轉換的工作行程 %s (%s)", elevation_shard_executable, g_strerror(spawn_error));
+            failed = TRUE;
+            break;
+        }
+        pids[i] = pid;
+        running++;
+    }
+
+    // 4. 等待工作行程結束：定期彙總各段進度並檢查取消，取消或任一段失敗時終止其餘工作行程
+    ElevationProgress progress;
+    elevation_progress_init(&progress, input_file, 0);
+    gboolean cancelled = FALSE;
+    while (running > 0) {
+        for (int i = 0; i < shard_count; i++) {
+            int status = 0;
+            if (pids[i] <= 0 || waitpid(pids[i], &status, WNOHANG) != pids[i]) continue;
+
+            pids[i] = 0;
+            running--;
+            gboolean exited_ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+                                 g_atomic_int_get(&slots[i].success);
+            if (!exited_ok && !failed && !cancelled) {
+                if (slots[i].error_message[0]) {
+                    g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "第 %d 段轉換失敗: %s",
+                                i + 1, slots[i].error_message);
                 } else {
-                    g_print("[WARNING] 無法刪除臨時檔案: %s (錯誤: %s)\n", temp_filtered_path, strerror(errno));
+                    g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "第 %d 段的工作行程異常結束（狀態 %d）",
+                                i + 1, status);
                 }
-            } else {
-                g_print("[ERROR] 檔案複製失敗，設定錯誤並返回\n");
-                g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
-                           "無法複製過濾結果到原始檔案: %s", input_path);
-                sep_data_free(sep_data);
-                g_free(converted_path);
-                g_free(temp_filtered_path);
-                return FALSE;
+                failed = TRUE;
             }
-        } else {
-            if (src) fclose(src);
-            if (dst) fclose(dst);
-            g_print("[ERROR] 無法開啟檔案進行複製: src=%p, dst=%p\n", src, dst);
-            if (!src) g_print("[ERROR] 無法開啟來源檔案: %s (錯誤: %s)\n", temp_filtered_path, strerror(errno));
-            if (!dst) g_print("[ERROR] 無法開啟目標檔案: %s (錯誤: %s)\n", input_path, strerror(errno));
-            g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED,
-                       "無法開啟檔案進行複製: %s", input_path);
-            sep_data_free(sep_data);
+        }
+
+        if (failed || cancelled) {
+            for (int i = 0; i < shard_count; i++) {
+                if (pids[i] > 0) kill(pids[i], SIGKILL);
+            }
+        } else if (progress_callback) {
+            gint64 done_kb = 0;
+            int done_lines = 0;
+            for (int i = 0; i < shard_count; i++) {
+                done_kb += g_atomic_int_get(&slots[i].progress_kb);
+                done_lines += g_atomic_int_get(&slots[i].progress_lines);
+            }
+            char progress_message[200];
+            double percentage = elevation_progress_format(&progress, done_kb * 1024, done_lines,
+                                                          progress_message, sizeof(progress_message));
+            progress_callback(percentage, progress_message);
+
+            if (error && *error && g_error_matches(*error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+                g_print("[CANCEL] 檢測到取消請求，正在終止分段轉換的工作行程\n");
+                cancelled = TRUE;
+                continue;
+            }
+        }
+        if (running > 0) {
+            g_usleep(ELEVATION_BATCH_PROGRESS_INTERVAL_US);
+        }
+    }
+
+    // 5. 依段落順序串接各段輸出，合併統計（診斷範例的行號加上前面各段的總行數）
+    gboolean ok = !failed && !cancelled;
+    gint64 concat_start = g_get_monotonic_time();
+    for (int i = 0; i < shard_count && ok; i++) {
+        ok = elevation_shard_append_file(output->converted_file, shard_converted[i]);
+        if (ok && output->filtered_file) {
+            ok = elevation_shard_append_file(output->filtered_file, shard_filtered[i]);
+        } else if (ok && output->bitmap_writer) {
+            ok = elevation_shard_append_bitmap(output->bitmap_writer, shard_bitmap[i]);
+        }
+        if (!ok) {
+            g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_IO, "串接第 %d 段的轉換結果時發生錯誤 (%s)",
+                        i + 1, g_strerror(errno));
+            break;
+        }
+
+        gint64 line_offset = stats->total_lines;
+        elevation_file_stats_add(stats, &slots[i].stats);
+        diagnostics_merge_examples(&stats->diagnostics, &slots[i].stats.diagnostics, line_offset);
+    }
+    stats->stage_times.us[ELEVATION_STAGE_WRITE] += g_get_monotonic_time() - concat_start;
+    diagnostics_finish(&stats->diagnostics);
+
+    for (int i = 0; i < shard_count; i++) {
+        remove(shard_converted[i]);
+        if (shard_filtered[i]) remove(shard_filtered[i]);
+        if (shard_bitmap[i]) remove(shard_bitmap[i]);
+        g_free(shard_converted[i]);
+        g_free(shard_filtered[i]);
+        g_free(shard_bitmap[i]);
+    }
+    g_free(shard_converted);
+    g_free(shard_filtered);
+    g_free(shard_bitmap);
+    g_free(pids);
+    g_free(bounds);
+    munmap(slots, slots_size);
+    remove(slots_path);
+    g_free(slots_path);
+    return ok;
+}
+#endif
+
+// 轉換單一檔案（SEP 已載入）：寫出轉換後檔案，並依選項處理過濾結果
+//
+// 單檔模式由 progress_callback 回報進度並偵測取消；批次模式不回報進度，
+// 改由 batch_cancelled 通知取消，並把已讀取的 KB 數寫入 progress_kb 供批次協調端彙總。
+// options->checkpoint_interval > 0 時定期寫出檢查點（checkpoint_key 為 elevation_checkpoint_key 的結果），
+// 有相符的檢查點時從中斷處繼續；失敗時若已有檢查點則保留部分輸出，否則刪除。
+// 取消時回傳 FALSE 但不設定 error（取消錯誤由進度回調設定）。sep_path 供分段轉換的工作行程重新開啟SEP
+static gboolean elevation_convert_file(const char *input_path, const char *sep_path, const SepDataStructure *sep_data,
+                                       const SepRaster *sep_raster, const SepTin *sep_tin,
+                                       const ElevationOptions *options, guint64 checkpoint_key,
+                                       int worker_count, GString *result_text, ElevationFileStats *stats,
+                                       GError **error, ElevationProgressCallback progress_callback,
+                                       gint *batch_cancelled, gint *progress_kb) {
+    memset(stats, 0, sizeof(*stats));
+
+    // 1. 生成輸出文件名：覆寫模式先寫入暫存檔，完成後再取代原始檔案
+    ElevationFilteredOutput filtered_output = options->filtered_output;
+    char *converted_path = generate_converted_filename(input_path);
+    char *temp_filtered_path = NULL;
+    char *bitmap_path = NULL;
+    g_string_append_printf(result_text, "轉換後檔案: %s\n", converted_path);
+    if (filtered_output == ELEVATION_FILTERED_REWRITE) {
+        temp_filtered_path = g_strdup_printf("%s.filtered_temp", input_path);
+        g_string_append_printf(result_text, "原始檔案將被修改為過濾後版本\n\n");
+    } else if (filtered_output == ELEVATION_FILTERED_BITMAP) {
+        bitmap_path = g_strdup_printf("%s.filtered.bitmap", input_path);
+        g_string_append_printf(result_text, "原始檔案保持不變，過濾結果記錄於: %s\n\n", bitmap_path);
+    } else {
+        g_string_append_printf(result_text, "原始檔案保持不變，不保留過濾結果\n\n");
+    }
+
+    // 多行程分段轉換只支援 POSIX 平台（需要 posix_spawn），且主程式須設定工作行程的執行檔；各段同時進行，不寫檢查點
+    int shard_count = MIN(options->shard_count, ELEVATION_MAX_SHARDS);
+#ifdef G_OS_WIN32
+    if (shard_count > 1) {
+        g_string_append_printf(result_text, "此平台不支援多行程分段轉換，改用單一行程的平行管線\n\n");
+        shard_count = 0;
+    }
+#else
+    if (shard_count > 1 && !elevation_shard_executable) {
+        g_string_append_printf(result_text, "未設定分段轉換工作行程的執行檔，改用單一行程的平行管線\n\n");
+        shard_count = 0;
+    }
+#endif
+
+    // 2. 檢查點：有與目前的輸入檔案、SEP與選項相符的檢查點時，從檢查點的位置繼續
+    ElevationCheckpointWriter checkpoint;
+    memset(&checkpoint, 0, sizeof(checkpoint));
+    GStatBuf input_stat;
+    gboolean use_checkpoint = options->checkpoint_interval > 0 && shard_count <= 1 &&
+                              g_stat(input_path, &input_stat) == 0;
+    if (use_checkpoint) {
+        checkpoint.path = g_strdup_printf("%s.checkpoint", input_path);
+        checkpoint.converted_path = converted_path;
+        checkpoint.filtered_path = temp_filtered_path ? temp_filtered_path : bitmap_path;
+        checkpoint.interval_us = (gint64)(options->checkpoint_interval * G_USEC_PER_SEC);
+        memcpy(checkpoint.state.magic, ELEVATION_CHECKPOINT_MAGIC, sizeof(checkpoint.state.magic));
+        checkpoint.state.key = checkpoint_key;
+        checkpoint.state.filtered_output = filtered_output;
+        checkpoint.state.input_size = (gint64)input_stat.st_size;
+        checkpoint.state.input_mtime = (gint64)input_stat.st_mtime;
+
+        const char *reason = NULL;
+        if (elevation_checkpoint_load(&checkpoint, &reason)) {
+            g_string_append_printf(result_text, "從檢查點繼續: 已完成 %d 行 (%.1f%%)，%s\n\n",
+                                   (int)checkpoint.state.total_lines,
+                                   input_stat.st_size > 0 ? checkpoint.state.input_offset * 100.0 / input_stat.st_size : 100.0,
+                                   checkpoint.path);
+        } else if (reason) {
+            g_string_append_printf(result_text, "檢查點無法使用（%s），從頭開始轉換\n\n", reason);
+            remove(checkpoint.path);
+        }
+    }
+    const ElevationCheckpoint *resume = checkpoint.resumed ? &checkpoint.state : NULL;
+
+    // 3. 打開輸入檔案和輸出檔案：從檢查點繼續時輸入移到檢查點的位置，輸出截斷到檢查點記錄的長度
+    FILE *input_file = fopen(input_path, "r");
+    if (input_file && resume && !elevation_skip_input(input_file, resume->input_offset)) {
+        fclose(input_file);
+        input_file = NULL;
+    }
+    if (!input_file) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "無法打開輸入檔案: %s", input_path);
+        g_free(converted_path);
+        g_free(temp_filtered_path);
+        g_free(bitmap_path);
+        g_free(checkpoint.path);
+        return FALSE;
+    }
+
+    FILE *converted_file = resume ? elevation_open_resumed(converted_path, "r+", resume->converted_offset)
+                                  : fopen(converted_path, "w");
+    if (!converted_file) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "無法創建轉換檔案: %s", converted_path);
+        fclose(input_file);
+        g_free(converted_path);
+        g_free(temp_filtered_path);
+        g_free(bitmap_path);
+        g_free(checkpoint.path);
+        return FALSE;
+    }
+    setvbuf(converted_file, NULL, _IOFBF, ELEVATION_OUTPUT_BUFFER);
+
+    FILE *temp_filtered_file = NULL;
+    if (temp_filtered_path) {
+        temp_filtered_file = resume ? elevation_open_resumed(temp_filtered_path, "r+", resume->filtered_offset)
+                                    : fopen(temp_filtered_path, "w");
+        if (!temp_filtered_file) {
+            g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "無法創建臨時過濾檔案: %s", temp_filtered_path);
+            fclose(input_file);
+            fclose(converted_file);
             g_free(converted_path);
             g_free(temp_filtered_path);
+            g_free(checkpoint.path);
             return FALSE;
         }
-    } else {
-        g_print("[SUCCESS] 檔案覆蓋成功，使用 rename()\n");
+        setvbuf(temp_filtered_file, NULL, _IOFBF, ELEVATION_OUTPUT_BUFFER);
+    }
+
+    ElevationBitmapWriter bitmap_writer;
+    memset(&bitmap_writer, 0, sizeof(bitmap_writer));
+    if (bitmap_path && !(resume ? elevation_bitmap_reopen(&bitmap_writer, bitmap_path, resume)
+                                : elevation_bitmap_open(&bitmap_writer, bitmap_path))) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "無法創建過濾結果位元圖: %s", bitmap_path);
+        fclose(input_file);
+        fclose(converted_file);
+        g_free(converted_path);
+        g_free(bitmap_path);
+        g_free(checkpoint.path);
+        return FALSE;
+    }
+
+    // 4. 執行平行管線（或多行程分段轉換）
+    ElevationPipelineOutput output = { converted_file, temp_filtered_file,
+                                       bitmap_path ? &bitmap_writer : NULL,
+                                       use_checkpoint ? &checkpoint : NULL };
+    gboolean pipeline_ok;
+#ifndef G_OS_WIN32
+    if (shard_count > 1) {
+        pipeline_ok = elevation_run_shards(input_file, input_path, sep_path, options, &output, converted_path,
+                                           temp_filtered_path, bitmap_path, shard_count, result_text, stats,
+                                           error, progress_callback);
+    } else
+#endif
+    {
+        pipeline_ok = elevation_run_pipeline(input_file, input_path, &output, sep_data, sep_raster, sep_tin,
+                                             elevation_tide_format(options), filtered_output, worker_count,
+                                             result_text, stats, error,
+                                             progress_callback, batch_cancelled, progress_kb);
+    }
+
+    // 5. 清理資源並寫出過濾結果
+    fclose(input_file);
+
+    // 檢查是否因為取消或讀寫錯誤而提前退出
+    if (!pipeline_ok) {
+        g_print("[CANCEL] 因為取消請求或讀取錯誤，跳過檔案覆蓋操作\n");
+
+        // 已有檢查點時保留輸出檔案與檢查點，下次從檢查點繼續（檢查點之後寫出的部分屆時會被截斷）；
+        // 否則清理臨時檔案
+        gboolean keep_outputs = checkpoint.resumed || checkpoint.written;
+        if (temp_filtered_file) {
+            fclose(temp_filtered_file);
+            if (!keep_outputs) remove(temp_filtered_path);
+        }
+        if (bitmap_writer.file) {
+            fclose(bitmap_writer.file);
+            if (!keep_outputs) remove(bitmap_path);
+        }
+        if (converted_file) {
+            fclose(converted_file);
+            if (!keep_outputs) remove(converted_path);
+        }
+        if (keep_outputs) {
+            g_string_append_printf(result_text, "已保留檢查點: %s\n"
+                                   "以相同的SEP與選項重新轉換此檔案時，將從第 %d 行之後繼續\n",
+                                   checkpoint.path, (int)checkpoint.state.total_lines);
+        }
+
+        g_free(converted_path);
+        g_free(temp_filtered_path);
+        g_free(bitmap_path);
+        g_free(checkpoint.path);
+
+        return FALSE;  // 返回失敗，因為操作被取消
+    }
+
+    // 關閉檔案並檢查寫入錯誤（例如磁碟已滿），避免以不完整的結果取代原始檔案
+    // 覆寫模式在取代原始檔案前先同步暫存檔，當機時不會留下內容不完整的原始檔案
+    gint64 finish_start = g_get_monotonic_time();
+    gboolean write_ok = fflush(converted_file) == 0 && !ferror(converted_file);
+    write_ok = (fclose(converted_file) == 0) && write_ok;
+    if (temp_filtered_file) {
+        gboolean temp_ok = !ferror(temp_filtered_file) && elevation_sync_file(temp_filtered_file);
+        write_ok = (fclose(temp_filtered_file) == 0) && temp_ok && write_ok;
+    }
+    if (bitmap_writer.file) {
+        write_ok = elevation_bitmap_close(&bitmap_writer) && write_ok;
+    }
+
+    // 輸出已全部寫出（或寫入失敗而將被刪除），檢查點不再需要
+    if (checkpoint.path) {
+        remove(checkpoint.path);
+        g_free(checkpoint.path);
+    }
+
+    if (!write_ok) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_IO, "寫入輸出檔案時發生錯誤: %s", converted_path);
+        remove(converted_path);
+        if (temp_filtered_path) remove(temp_filtered_path);
+        if (bitmap_path) remove(bitmap_path);
+        g_free(converted_path);
+        g_free(temp_filtered_path);
+        g_free(bitmap_path);
+        return FALSE;
     }
 
-    sep_data_free(sep_data);
-    g_free(converted_path);
+    // 用過濾後的臨時檔案覆蓋原始檔案：rename 為原子操作；失敗時（例如 Windows 上目標已存在）
+    // 改為複製內容，複製並同步完成後才刪除臨時檔案，中途當機時臨時檔案仍保有完整的過濾結果
+    if (temp_filtered_path) {
+        if (rename(temp_filtered_path, input_path) == 0) {
+            elevation_sync_parent_dir(input_path);
+            g_print("[SUCCESS] 檔案覆蓋成功，使用 rename()\n");
+        } else {
+            int rename_errno = errno;
+            g_print("[ERROR] rename() 失敗: %s -> %s (%s)，改為複製檔案內容\n",
+                    temp_filtered_path, input_path, strerror(rename_errno));
+
+            if (!elevation_copy_file_contents(temp_filtered_path, input_path, error)) {
+                g_free(converted_path);
+                g_free(temp_filtered_path);
+                return FALSE;
+            }
+
+            if (remove(temp_filtered_path) == 0) {
+                g_print("[SUCCESS] 檔案覆蓋成功，使用備用方案\n");
+            } else {
+                g_print("[WARNING] 無法刪除臨時檔案: %s (錯誤: %s)\n", temp_filtered_path, strerror(errno));
+            }
+        }
+    }
     g_free(temp_filtered_path);
+    stats->stage_times.us[ELEVATION_STAGE_WRITE] += g_get_monotonic_time() - finish_start;
 
-    // 記錄結束時間並計算處理時間
-    time_t end_time = time(NULL);
-    double processing_time = difftime(end_time, start_time);
+    stats->converted_path = converted_path;
+    stats->bitmap_path = bitmap_path;
+    return TRUE;
+}
+
+// 附加轉換統計、匹配率與查詢游標統計到報告
+static void elevation_append_statistics(GString *result_text, const ElevationFileStats *stats,
+                                        const ElevationOptions *options) {
+    int total_lines = stats->total_lines;
+    int filtered_lines = stats->filtered_lines;
+    int processed_lines = stats->processed_lines;
+    int matched_lines = stats->matched_lines;
+    int interpolated_lines = stats->interpolated_lines;
+    int raster_lines = stats->raster_lines;
+    int tin_lines = stats->tin_lines;
+    int surface_lines = raster_lines + tin_lines;  // 網格或三角網內插
+    const SepLookupStats *lookup_stats = &stats->lookup_stats;
 
-    // 7. 最終報告
-    g_string_append_printf(result_text, "\n轉換完成統計:\n");
-    g_string_append_printf(result_text, "===========================================\n");
     g_string_append_printf(result_text, "總行數: %d\n", total_lines);
     g_string_append_printf(result_text, "過濾行數 (col6/col7=0): %d\n", filtered_lines);
     g_string_append_printf(result_text, "有效處理行數: %d\n", processed_lines);
     g_string_append_printf(result_text, "SEP精確匹配行數: %d\n", matched_lines);
     g_string_append_printf(result_text, "SEP插值匹配行數: %d\n", interpolated_lines);
-    g_string_append_printf(result_text, "SEP總匹配行數: %d\n", matched_lines + interpolated_lines);
+    if (options->use_raster) {
+        g_string_append_printf(result_text, "SEP網格內插行數: %d\n", raster_lines);
+    } else if (options->use_tin) {
+        g_string_append_printf(result_text, "SEP三角網內插行數: %d\n", tin_lines);
+    }
+    g_string_append_printf(result_text, "SEP總匹配行數: %d\n", matched_lines + interpolated_lines + surface_lines);
+    if (options->use_raster) {
+        g_string_append_printf(result_text, "網格範圍外退回逐點查詢行數: %d\n", stats->fallback_lines);
+    } else if (options->use_tin) {
+        g_string_append_printf(result_text, "三角網範圍外退回逐點查詢行數: %d\n", stats->fallback_lines);
+    }
+    g_string_append_printf(result_text, "找不到對照點行數（調整值以 0 計）: %d\n", stats->unmatched_lines);
+    diagnostics_append_report(&stats->diagnostics, "解析失敗行數（已跳過）", result_text);
 
     int total_searched_lines = processed_lines; // 已處理的有效行數
     double exact_match_rate = total_searched_lines > 0 ? (double)matched_lines / total_searched_lines * 100 : 0;
     double interpolation_rate = total_searched_lines > 0 ? (double)interpolated_lines / total_searched_lines * 100 : 0;
-    double total_match_rate = total_searched_lines > 0 ? (double)(matched_lines + interpolated_lines) / total_searched_lines * 100 : 0;
+    double raster_rate = total_searched_lines > 0 ? (double)raster_lines / total_searched_lines * 100 : 0;
+    double tin_rate = total_searched_lines > 0 ? (double)tin_lines / total_searched_lines * 100 : 0;
+    double total_match_rate = total_searched_lines > 0 ? (double)(matched_lines + interpolated_lines + surface_lines) / total_searched_lines * 100 : 0;
 
     g_string_append_printf(result_text, "\n匹配率統計:\n");
     g_string_append_printf(result_text, "精確匹配率: %.1f%%\n", exact_match_rate);
     g_string_append_printf(result_text, "插值匹配率: %.1f%%\n", interpolation_rate);
+    if (raster_lines > 0) {
+        g_string_append_printf(result_text, "網格內插率: %.1f%%\n", raster_rate);
+    }
+    if (tin_lines > 0) {
+        g_string_append_printf(result_text, "三角網內插率: %.1f%%\n", tin_rate);
+    }
     g_string_append_printf(result_text, "總匹配率: %.1f%%\n", total_match_rate);
 
+    if (!options->use_raster && !options->use_tin) {
+        double lookup_total = lookup_stats->lookups > 0 ? (double)lookup_stats->lookups : 1.0;
+        g_string_append_printf(result_text, "\n查詢游標統計:\n");
+        g_string_append_printf(result_text, "查詢次數: %" G_GUINT64_FORMAT "\n", lookup_stats->lookups);
+        g_string_append_printf(result_text, "位置未變沿用結果: %" G_GUINT64_FORMAT " (%.1f%%)\n",
+                               lookup_stats->reuse_hits, lookup_stats->reuse_hits / lookup_total * 100.0);
+        if (lookup_stats->lattice_lookups > 0) {
+            g_string_append_printf(result_text, "規則格網直接查詢: %" G_GUINT64_FORMAT " (%.1f%%)\n",
+                                   lookup_stats->lattice_lookups, lookup_stats->lattice_lookups / lookup_total * 100.0);
+        } else {
+            g_string_append_printf(result_text, "同網格暖啟動: %" G_GUINT64_FORMAT " (%.1f%%)\n",
+                                   lookup_stats->warm_starts, lookup_stats->warm_starts / lookup_total * 100.0);
+            g_string_append_printf(result_text, "重建候選清單: %" G_GUINT64_FORMAT " (%.1f%%)\n",
+                                   lookup_stats->cold_starts, lookup_stats->cold_starts / lookup_total * 100.0);
+        }
+        g_string_append_printf(result_text, "平均擴圈掃描: %.2f 圈/次查詢（共 %" G_GUINT64_FORMAT " 圈）\n",
+                               lookup_stats->rings_scanned / lookup_total, lookup_stats->rings_scanned);
+    }
+}
+
+// 附加一個階段的耗時與處理速度；count 為該階段處理的數量，unit 為速度單位
+static void elevation_append_stage(GString *result_text, const char *name, gint64 us, double count, const char *unit) {
+    g_string_append_printf(result_text, "%s: %.1f 毫秒", name, us / 1000.0);
+    if (unit && us > 0) {
+        g_string_append_printf(result_text, "（%.1f %s）", count / (us / 1e6), unit);
+    }
+    g_string_append_printf(result_text, "\n");
+}
+
+// 附加各處理階段的耗時與處理速度到報告；elapsed_us 為整體經過的牆鐘時間
+static void elevation_append_stage_times(GString *result_text, const ElevationFileStats *stats, gint64 elapsed_us) {
+    const gint64 *us = stats->stage_times.us;
+    const double mb = 1024.0 * 1024.0;
+
     g_string_append_printf(result_text, "\n處理時間統計:\n");
-    g_string_append_printf(result_text, "處理時間: %.2f 秒\n", processing_time);
+    g_string_append_printf(result_text, "處理時間: %.3f 秒\n", elapsed_us / 1e6);
+    if (elapsed_us > 0) {
+        g_string_append_printf(result_text, "平均處理速度: %.1f MB/秒，%.0f 行/秒\n",
+                               stats->bytes_read / mb / (elapsed_us / 1e6), stats->total_lines / (elapsed_us / 1e6));
+    }
+
+    g_string_append_printf(result_text, "\n處理階段時間（解析、查詢、格式化為各工作執行緒的合計）:\n");
+    elevation_append_stage(result_text, "SEP載入", us[ELEVATION_STAGE_SEP_LOAD], 0.0, NULL);
+    elevation_append_stage(result_text, "讀取輸入", us[ELEVATION_STAGE_READ], stats->bytes_read / mb, "MB/秒");
+    elevation_append_stage(result_text, "解析與過濾", us[ELEVATION_STAGE_PARSE], stats->total_lines, "行/秒");
+    elevation_append_stage(result_text, "SEP查詢", us[ELEVATION_STAGE_LOOKUP], stats->processed_lines, "行/秒");
+    elevation_append_stage(result_text, "格式化", us[ELEVATION_STAGE_FORMAT], stats->processed_lines, "行/秒");
+    elevation_append_stage(result_text, "寫出", us[ELEVATION_STAGE_WRITE], stats->bytes_written / mb, "MB/秒");
+}
+
+// 載入SEP資料與（可選的）預計算調整值網格或三角網，並附加說明到報告
+// 網格與三角網只能擇一（同時設定時以網格為準），兩者都需要完整模型；分塊模型直接開啟（分塊依查詢需要載入，不放進常駐快取）；有常駐快取時從快取取得模型參考，
+// 否則直接載入；各種情況都以 sep_model_unref 釋放
+static gboolean elevation_load_sep(const char *sep_path, const ElevationOptions *options, GString *result_text,
+                                   SepModel **sep_model_out, SepRaster **sep_raster_out, SepTin **sep_tin_out,
+                                   GError **error) {
+    SepModel *sep_model = NULL;
+    gboolean use_tin = options->use_tin && !options->use_raster;
+    if (options->use_tin && options->use_raster) {
+        g_string_append_printf(result_text, "SEP模型: 三角網與預計算調整值網格只能擇一，使用網格\n");
+    }
+    if (options->use_tiles && options->use_raster) {
+        g_string_append_printf(result_text, "SEP模型: 預計算調整值網格需要完整模型，不使用分塊模型\n");
+    } else if (options->use_tiles && use_tin) {
+        g_string_append_printf(result_text, "SEP模型: 三角網需要完整模型，不使用分塊模型\n");
+    } else if (options->use_tiles) {
+        sep_model = sep_model_new(load_sep_file_tiled(sep_path, options->tile_size));
+        if (!sep_model) {
+            g_string_append_printf(result_text, "SEP模型: 無法建立分塊檔，改為載入完整模型\n");
+        }
+    }
+
+    if (!sep_model && options->model_cache) {
+        SepModelCacheResult cache_result = SEP_MODEL_CACHE_LOADED;
+        sep_model = sep_model_cache_acquire(options->model_cache, sep_path, &cache_result, error);
+        if (!sep_model) {
+            return FALSE;
+        }
+        if (cache_result == SEP_MODEL_CACHE_HIT) {
+            g_string_append_printf(result_text, "SEP模型: 沿用常駐快取中的模型，略過載入與建立索引\n");
+        } else if (cache_result == SEP_MODEL_CACHE_PREFETCHED) {
+            g_string_append_printf(result_text, "SEP模型: 已於選擇SEP檔案時在背景載入\n");
+        }
+        sep_model_cache_describe(options->model_cache, result_text);
+    } else if (!sep_model) {
+        sep_model = sep_model_new(load_sep_file_optimized(sep_path));
+        if (!sep_model) {
+            g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "無法載入SEP檔案: %s", sep_path);
+            return FALSE;
+        }
+    }
+
+    const SepDataStructure *sep_data = sep_model_get_data(sep_model);
+    g_string_append_printf(result_text, "已載入 %d 個SEP對照點\n", sep_data_point_count(sep_data));
+    sep_data_describe(sep_data, result_text);
+    tide_format_describe(elevation_tide_format(options), result_text);
+
+    SepRaster *sep_raster = NULL;
+    if (options->use_raster) {
+        sep_raster = sep_raster_load_or_build(sep_path, sep_data, options->raster_resolution, result_text, error);
+        if (!sep_raster) {
+            sep_model_unref(sep_model);
+            return FALSE;
+        }
+    }
+
+    SepTin *sep_tin = NULL;
+    if (use_tin) {
+        sep_tin = sep_tin_load_or_build(sep_path, sep_data, result_text, error);
+        if (!sep_tin) {
+            sep_model_unref(sep_model);
+            return FALSE;
+        }
+    }
+
+    *sep_model_out = sep_model;
+    *sep_raster_out = sep_raster;
+    *sep_tin_out = sep_tin;
+    return TRUE;
+}
+
+// 主處理函數 - 高程轉換處理 (支援轉換選項與進度回調)
+gboolean process_elevation_conversion_ex(const char *input_path, const char *sep_path, const ElevationOptions *options,
+                                    GString *result_text, GError **error, void (*progress_callback)(double, const char*)) {
+    ElevationOptions default_options;
+    if (!options) {
+        elevation_options_init(&default_options);
+        options = &default_options;
+    }
+
+    // 記錄開始時間（單調時鐘，不受系統時間調整影響）
+    gint64 start_time = g_get_monotonic_time();
+
+    g_string_append_printf(result_text, "開始處理高程轉換：\n");
+    g_string_append_printf(result_text, "===========================================\n");
+    g_string_append_printf(result_text, "輸入檔案: %s\n", input_path);
+    g_string_append_printf(result_text, "SEP檔案: %s\n\n", sep_path);
+
+    // 1. 載入SEP對照數據與可選的預計算調整值網格或三角網
+    SepModel *sep_model = NULL;
+    SepRaster *sep_raster = NULL;
+    SepTin *sep_tin = NULL;
+    if (!elevation_load_sep(sep_path, options, result_text, &sep_model, &sep_raster, &sep_tin, error)) {
+        return FALSE;
+    }
+    const SepDataStructure *sep_data = sep_model_get_data(sep_model);
+    gint64 sep_load_us = g_get_monotonic_time() - start_time;
+
+    // 2. 轉換檔案
+    ElevationFileStats stats;
+    gboolean success = elevation_convert_file(input_path, sep_path, sep_data, sep_raster, sep_tin, options,
+                                              elevation_checkpoint_key(sep_path, options),
+                                              elevation_worker_count(options), result_text, &stats,
+                                              error, progress_callback, NULL, NULL);
+    sep_data_describe_tiles_loaded(sep_data, result_text);
+    sep_model_unref(sep_model);
+    sep_raster_free(sep_raster);
+    sep_tin_free(sep_tin);
+    if (!success) {
+        return FALSE;
+    }
+
+    stats.stage_times.us[ELEVATION_STAGE_SEP_LOAD] = sep_load_us;
+
+    // 3. 最終報告
+    g_string_append_printf(result_text, "\n轉換完成統計:\n");
+    g_string_append_printf(result_text, "===========================================\n");
+    elevation_append_statistics(result_text, &stats, options);
+    elevation_append_stage_times(result_text, &stats, g_get_monotonic_time() - start_time);
 
     g_string_append_printf(result_text, "\n高程轉換完成！✅\n");
     g_string_append_printf(result_text, "📊 資料處理統計：\n");
-    g_string_append_printf(result_text, "   • 移除了 %d 筆無效資料 (col6或col7為0)\n", filtered_lines);
-    g_string_append_printf(result_text, "   • 保留了 %d 筆有效資料\n", processed_lines);
+    g_string_append_printf(result_text, "   • 移除了 %d 筆無效資料 (col6或col7為0)\n", stats.filtered_lines);
+    g_string_append_printf(result_text, "   • 保留了 %d 筆有效資料\n", stats.processed_lines);
     g_string_append_printf(result_text, "📄 輸出檔案：\n");
-    g_string_append_printf(result_text, "   • 過濾後檔案：原始檔案已被修改為過濾版本\n");
-    g_string_append_printf(result_text, "   • 轉換後檔案：%s\n", converted_path);
+    if (options->filtered_output == ELEVATION_FILTERED_REWRITE) {
+        g_string_append_printf(result_text, "   • 過濾後檔案：原始檔案已被修改為過濾版本\n");
+    } else if (options->filtered_output == ELEVATION_FILTERED_BITMAP) {
+        g_string_append_printf(result_text, "   • 過濾結果位元圖：%s\n", stats.bitmap_path);
+    } else {
+        g_string_append_printf(result_text, "   • 過濾後檔案：未保留（原始檔案保持不變）\n");
+    }
+    g_string_append_printf(result_text, "   • 轉換後檔案：%s\n", stats.converted_path);
     g_string_append_printf(result_text, "🎯 地理空間插值功能成功啟用\n");
 
-    // 等待統計線程完成並清理資源
-    g_thread_join(counting_thread);
-    g_mutex_clear(&counting_mutex);
-    g_cond_clear(&counting_cond);
+    elevation_file_stats_clear(&stats);
+
+    return TRUE;
+}
+
+// 複製檔案描述符後以 stdio 包裝：關閉 FILE 時只關閉複本，呼叫端的描述符保持開啟
+static FILE* elevation_fdopen_dup(int fd, const char *mode) {
+#ifdef G_OS_WIN32
+    int copy = _dup(fd);
+    FILE *file = copy >= 0 ? _fdopen(copy, mode) : NULL;
+    if (copy >= 0 && !file) _close(copy);
+#else
+    int copy = dup(fd);
+    FILE *file = copy >= 0 ? fdopen(copy, mode) : NULL;
+    if (copy >= 0 && !file) close(copy);
+#endif
+    return file;
+}
+
+// 串流模式：從檔案描述符讀取潮位資料，轉換後的資料行寫到另一個檔案描述符
+gboolean process_elevation_stream(int input_fd, int output_fd, const char *sep_path, const ElevationOptions *options,
+                                  GString *result_text, GError **error, ElevationProgressCallback progress_callback) {
+    ElevationOptions stream_options;
+    if (options) {
+        stream_options = *options;
+    } else {
+        elevation_options_init(&stream_options);
+    }
+    // 串流無法回頭覆寫輸入，也沒有可放置位元圖的檔名：一律不保留過濾結果
+    stream_options.filtered_output = ELEVATION_FILTERED_NONE;
+
+    gint64 start_time = g_get_monotonic_time();
+
+    g_string_append_printf(result_text, "開始串流高程轉換：\n");
+    g_string_append_printf(result_text, "===========================================\n");
+    g_string_append_printf(result_text, "輸入: 檔案描述符 %d\n", input_fd);
+    g_string_append_printf(result_text, "輸出: 檔案描述符 %d\n", output_fd);
+    g_string_append_printf(result_text, "SEP檔案: %s\n\n", sep_path);
+
+    // 1. 載入SEP對照數據與可選的預計算調整值網格或三角網
+    SepModel *sep_model = NULL;
+    SepRaster *sep_raster = NULL;
+    SepTin *sep_tin = NULL;
+    if (!elevation_load_sep(sep_path, &stream_options, result_text, &sep_model, &sep_raster, &sep_tin, error)) {
+        return FALSE;
+    }
+    gint64 sep_load_us = g_get_monotonic_time() - start_time;
+
+    // 2. 包裝輸入與輸出，兩端都使用大區塊緩衝
+    FILE *input_file = elevation_fdopen_dup(input_fd, "r");
+    FILE *output_file = input_file ? elevation_fdopen_dup(output_fd, "w") : NULL;
+    if (!input_file || !output_file) {
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno),
+                    "無法開啟串流的檔案描述符 %d: %s", input_file ? output_fd : input_fd, g_strerror(errno));
+        if (input_file) fclose(input_file);
+        sep_model_unref(sep_model);
+        sep_raster_free(sep_raster);
+        sep_tin_free(sep_tin);
+        return FALSE;
+    }
+    setvbuf(input_file, NULL, _IOFBF, ELEVATION_OUTPUT_BUFFER);
+    setvbuf(output_file, NULL, _IOFBF, ELEVATION_OUTPUT_BUFFER);
+
+    // 3. 執行平行管線：只循序讀寫，不做 seek，可直接接在管線中
+    char input_name[64];
+    g_snprintf(input_name, sizeof(input_name), "檔案描述符 %d", input_fd);
+    ElevationPipelineOutput output = { output_file, NULL, NULL, NULL };
+    ElevationFileStats stats;
+    memset(&stats, 0, sizeof(stats));
+    gboolean success = elevation_run_pipeline(input_file, input_name, &output, sep_model_get_data(sep_model),
+                                              sep_raster, sep_tin, elevation_tide_format(&stream_options),
+                                              stream_options.filtered_output,
+                                              elevation_worker_count(&stream_options), result_text, &stats,
+                                              error, progress_callback, NULL, NULL);
+    fclose(input_file);
+    sep_data_describe_tiles_loaded(sep_model_get_data(sep_model), result_text);
+    sep_model_unref(sep_model);
+    sep_raster_free(sep_raster);
+    sep_tin_free(sep_tin);
+
+    gint64 finish_start = g_get_monotonic_time();
+    gboolean write_ok = fflush(output_file) == 0 && !ferror(output_file);
+    write_ok = (fclose(output_file) == 0) && write_ok;
+    stats.stage_times.us[ELEVATION_STAGE_WRITE] += g_get_monotonic_time() - finish_start;
+    stats.stage_times.us[ELEVATION_STAGE_SEP_LOAD] = sep_load_us;
+    if (success && !write_ok) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_IO, "寫入轉換結果時發生錯誤: 檔案描述符 %d", output_fd);
+        success = FALSE;
+    }
+    if (!success) {
+        return FALSE;
+    }
+
+    // 4. 最終報告
+    g_string_append_printf(result_text, "\n轉換完成統計:\n");
+    g_string_append_printf(result_text, "===========================================\n");
+    elevation_append_statistics(result_text, &stats, &stream_options);
+    elevation_append_stage_times(result_text, &stats, g_get_monotonic_time() - start_time);
+
+    return TRUE;
+}
+
+// 批次轉換中的單一檔案
+typedef struct {
+    const char *path;
+    gint64 size_kb;           // 檔案大小（KB），進度的分母
+    gint progress_kb;         // 已讀取的 KB 數（g_atomic_int，由處理該檔案的執行緒寫入）
+    GString *report;          // 該檔案的處理訊息
+    ElevationFileStats stats;
+    GError *error;
+    gboolean attempted;       // 取消前已開始處理
+    gboolean success;
+} ElevationBatchFile;
+
+// 批次轉換共用狀態
+typedef struct {
+    const char *sep_path;
+    const SepDataStructure *sep_data;
+    const SepRaster *sep_raster;
+    const SepTin *sep_tin;
+    const ElevationOptions *options;
+    guint64 checkpoint_key;   // 各檔案檢查點的識別值（SEP與選項相同，整批共用）
+    int pipeline_workers;     // 每個檔案的管線工作執行緒數
+    GAsyncQueue *done_files;  // 處理完成（或因取消而略過）的檔案
+    gint cancelled;           // 取消旗標（g_atomic_int）
+} ElevationBatch;
+
+// 檔案層級的工作執行緒：以獨立的管線轉換一個檔案
+static void elevation_batch_file_func(gpointer data, gpointer user_data) {
+    ElevationBatchFile *file = (ElevationBatchFile *)data;
+    ElevationBatch *batch = (ElevationBatch *)user_data;
+
+    if (!g_atomic_int_get(&batch->cancelled)) {
+        file->attempted = TRUE;
+        file->success = elevation_convert_file(file->path, batch->sep_path, batch->sep_data, batch->sep_raster,
+                                               batch->sep_tin, batch->options, batch->checkpoint_key,
+                                               batch->pipeline_workers, file->report, &file->stats,
+                                               &file->error, NULL, &batch->cancelled, &file->progress_kb);
+    }
+    g_async_queue_push(batch->done_files, file);
+}
+
+// 依檔案大小由大到小排序，讓大檔案先開始，減少最後只剩一個檔案在處理的時間
+static gint elevation_batch_compare_size(gconstpointer a, gconstpointer b) {
+    const ElevationBatchFile *fa = *(ElevationBatchFile * const *)a;
+    const ElevationBatchFile *fb = *(ElevationBatchFile * const *)b;
+    return (fa->size_kb < fb->size_kb) - (fa->size_kb > fb->size_kb);
+}
+
+// 批次高程轉換
+gboolean process_elevation_batch(const char * const *input_paths, int file_count, const char *sep_path,
+                                 const ElevationOptions *options, GString *result_text, GError **error,
+                                 ElevationProgressCallback progress_callback) {
+    ElevationOptions default_options;
+    if (!options) {
+        elevation_options_init(&default_options);
+        options = &default_options;
+    }
+    if (file_count <= 0) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "批次轉換沒有任何輸入檔案");
+        return FALSE;
+    }
+
+    gint64 start_time = g_get_monotonic_time();
+
+    g_string_append_printf(result_text, "開始批次高程轉換：\n");
+    g_string_append_printf(result_text, "===========================================\n");
+    g_string_append_printf(result_text, "輸入檔案數: %d\n", file_count);
+    g_string_append_printf(result_text, "SEP檔案: %s\n\n", sep_path);
+
+    // 1. SEP 只載入並建立索引一次，所有檔案唯讀共用
+    SepModel *sep_model = NULL;
+    SepRaster *sep_raster = NULL;
+    SepTin *sep_tin = NULL;
+    if (!elevation_load_sep(sep_path, options, result_text, &sep_model, &sep_raster, &sep_tin, error)) {
+        return FALSE;
+    }
+    const SepDataStructure *sep_data = sep_model_get_data(sep_model);
+    gint64 sep_load_us = g_get_monotonic_time() - start_time;
+
+    // 2. 以檔案大小總和作為進度的分母
+    ElevationBatchFile *files = g_new0(ElevationBatchFile, file_count);
+    GPtrArray *queue_order = g_ptr_array_sized_new((guint)file_count);
+    gint64 total_kb = 0;
+    for (int i = 0; i < file_count; i++) {
+        GStatBuf st;
+        files[i].path = input_paths[i];
+        files[i].size_kb = g_stat(input_paths[i], &st) == 0 ? MAX((gint64)st.st_size / 1024, 1) : 1;
+        files[i].report = g_string_new(NULL);
+        total_kb += files[i].size_kb;
+        g_ptr_array_add(queue_order, &files[i]);
+    }
+    g_ptr_array_sort(queue_order, elevation_batch_compare_size);
+
+    // 3. 檔案層級的執行緒池：同時處理的檔案數 × 每個檔案的管線執行緒數約等於總工作執行緒數
+    // 批次轉換已以檔案為單位平行處理，再分段只會讓行程數倍增：各檔案一律不分段
+    ElevationOptions file_options = *options;
+    if (file_options.shard_count > 1) {
+        g_string_append_printf(result_text, "批次轉換不使用多行程分段，改以檔案層級平行處理\n");
+        file_options.shard_count = 0;
+    }
+    int worker_count = elevation_worker_count(options);
+    int file_workers = MIN(file_count, worker_count);
+    ElevationBatch batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.sep_path = sep_path;
+    batch.sep_data = sep_data;
+    batch.sep_raster = sep_raster;
+    batch.sep_tin = sep_tin;
+    batch.options = &file_options;
+    batch.checkpoint_key = elevation_checkpoint_key(sep_path, options);
+    batch.pipeline_workers = MAX(1, worker_count / file_workers);
+    batch.done_files = g_async_queue_new();
+    g_string_append_printf(result_text, "批次平行處理: 同時轉換 %d 個檔案，每個檔案 %d 個工作執行緒\n\n",
+                           file_workers, batch.pipeline_workers);
+
+    GThreadPool *pool = g_thread_pool_new(elevation_batch_file_func, &batch, file_workers, FALSE, NULL);
+    for (guint i = 0; i < queue_order->len; i++) {
+        g_thread_pool_push(pool, g_ptr_array_index(queue_order, i), NULL);
+    }
+    g_ptr_array_free(queue_order, TRUE);
+
+    // 4. 本執行緒定期彙總各檔案已讀取的位元組數回報進度，並偵測取消
+    int finished_files = 0;
+    while (finished_files < file_count) {
+        if (g_async_queue_timeout_pop(batch.done_files, ELEVATION_BATCH_PROGRESS_INTERVAL_US)) {
+            finished_files++;
+        }
+
+        if (progress_callback && !g_atomic_int_get(&batch.cancelled)) {
+            gint64 done_kb = 0;
+            for (int i = 0; i < file_count; i++) {
+                done_kb += MIN((gint64)g_atomic_int_get(&files[i].progress_kb), files[i].size_kb);
+            }
+            double fraction = MIN((double)done_kb / total_kb, 1.0);
+            char progress_message[200];
+            g_snprintf(progress_message, sizeof(progress_message), "批次處理: 已完成 %d / %d 個檔案，%.1f / %.1f MB (%.1f%%)",
+                       finished_files, file_count, done_kb / 1024.0, total_kb / 1024.0, fraction * 100.0);
+            progress_callback(fraction * 100.0, progress_message);
+
+            if (error && *error && g_error_matches(*error, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+                g_print("[CANCEL] 檢測到取消請求，正在終止批次轉換\n");
+                g_atomic_int_set(&batch.cancelled, 1);
+            }
+        }
+    }
+    g_thread_pool_free(pool, FALSE, TRUE);
+    g_async_queue_unref(batch.done_files);
+    sep_data_describe_tiles_loaded(sep_data, result_text);
+    sep_model_unref(sep_model);
+    sep_raster_free(sep_raster);
+    sep_tin_free(sep_tin);
+
+    gboolean cancelled = g_atomic_int_get(&batch.cancelled);
+
+    // 5. 依輸入順序列出各檔案結果，並累計合計統計
+    ElevationFileStats total_stats;
+    memset(&total_stats, 0, sizeof(total_stats));
+    diagnostics_init(&total_stats.diagnostics, sep_path, tide_format_row_error_names(), TIDE_ROW_ERROR_COUNT, FALSE);
+    int succeeded_files = 0;
+    int failed_files = 0;
+    for (int i = 0; i < file_count; i++) {
+        ElevationBatchFile *file = &files[i];
+        g_string_append_printf(result_text, "[%d/%d] %s\n", i + 1, file_count, file->path);
+        g_string_append_printf(result_text, "-------------------------------------------\n");
+        g_string_append(result_text, file->report->str);
+
+        if (file->success) {
+            g_string_append_printf(result_text, "\n");
+            elevation_append_statistics(result_text, &file->stats, options);
+            elevation_file_stats_add(&total_stats, &file->stats);
+            succeeded_files++;
+        } else if (file->error) {
+            g_string_append_printf(result_text, "❌ 處理失敗: %s\n", file->error->message);
+            failed_files++;
+        } else {
+            g_string_append_printf(result_text, "⚠️ %s\n", file->attempted ? "處理已取消" : "未處理（已取消）");
+        }
+        g_string_append_printf(result_text, "\n");
+
+        elevation_file_stats_clear(&file->stats);
+        g_string_free(file->report, TRUE);
+        if (file->error) {
+            g_error_free(file->error);
+        }
+    }
+    g_free(files);
+
+    if (cancelled) {
+        return FALSE;  // 取消錯誤已由進度回調設定
+    }
 
+    // 6. 合計統計（工作執行緒的階段時間為所有檔案的合計）
+    total_stats.stage_times.us[ELEVATION_STAGE_SEP_LOAD] = sep_load_us;
+    g_string_append_printf(result_text, "批次轉換合計統計:\n");
+    g_string_append_printf(result_text, "===========================================\n");
+    g_string_append_printf(result_text, "成功檔案數: %d / %d\n", succeeded_files, file_count);
+    if (failed_files > 0) {
+        g_string_append_printf(result_text, "失敗檔案數: %d\n", failed_files);
+    }
+    elevation_append_statistics(result_text, &total_stats, options);
+    elevation_append_stage_times(result_text, &total_stats, g_get_monotonic_time() - start_time);
+
+    g_string_append_printf(result_text, "\n批次高程轉換完成！✅\n");
     return TRUE;
 }
+
+#ifndef G_OS_WIN32
+void elevation_set_shard_executable(const char *argv0) {
+    g_free(elevation_shard_executable);
+    // Linux 以 /proc/self/exe 取得實際的執行檔，不受 argv[0] 的寫法影響；其他平台依 PATH 尋找 argv[0]
+    elevation_shard_executable = g_file_read_link("/proc/self/exe", NULL);
+    if (!elevation_shard_executable && argv0) {
+        elevation_shard_executable = g_find_program_in_path(argv0);
+    }
+}
+
+// 工作行程的命令列：
+// <程式> ELEVATION_SHARD_WORKER_ARG <共用狀態檔> <段號> <輸入檔> <起點> <終點> <SEP檔案>
+//        <轉換輸出> <過濾輸出|-> <位元圖|-> <過濾方式> [--raster 解析度] [--tin] [--tiles 分塊大小] [--format 格式]
+int elevation_shard_worker_main(int argc, char **argv) {
+    if (argc < 12) {
+        fprintf(stderr, "用法: %s %s <共用狀態檔> <段號> <輸入檔> <起點> <終點> <SEP檔案> <轉換輸出> <過濾輸出|-> <位元圖|-> <過濾方式> [選項]\n",
+                argv[0], ELEVATION_SHARD_WORKER_ARG);
+        return 2;
+    }
+
+    ElevationOptions options;
+    TideFormat tide_format;
+    elevation_options_init(&options);
+    options.filtered_output = (ElevationFilteredOutput)atoi(argv[11]);
+    for (int i = 12; i < argc; i++) {
+        if (strcmp(argv[i], "--raster") == 0 && i + 1 < argc) {
+            options.use_raster = TRUE;
+            options.raster_resolution = g_ascii_strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--tin") == 0) {
+            options.use_tin = TRUE;
+        } else if (strcmp(argv[i], "--tiles") == 0 && i + 1 < argc) {
+            options.use_tiles = TRUE;
+            options.tile_size = g_ascii_strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            GError *format_error = NULL;
+            if (!tide_format_from_spec(&tide_format, argv[++i], &format_error)) {
+                fprintf(stderr, "輸入格式設定錯誤: %s\n", format_error->message);
+                g_error_free(format_error);
+                return 2;
+            }
+            options.tide_format = &tide_format;
+        } else {
+            fprintf(stderr, "未知的參數: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    // 1. 映射與父行程共用的狀態檔，取得本段的 slot
+    int index = atoi(argv[3]);
+    int slots_fd = g_open(argv[2], O_RDWR | O_BINARY, 0);
+    struct stat st;
+    if (slots_fd < 0 || fstat(slots_fd, &st) != 0 || index < 0 ||
+        (gint64)st.st_size < (gint64)sizeof(ElevationShardSlot) * (index + 1)) {
+        fprintf(stderr, "無法開啟分段轉換的共用狀態檔: %s\n", argv[2]);
+        if (slots_fd >= 0) close(slots_fd);
+        return 2;
+    }
+    gsize slots_size = (gsize)st.st_size;
+    ElevationShardSlot *slots = mmap(NULL, slots_size, PROT_READ | PROT_WRITE, MAP_SHARED, slots_fd, 0);
+    close(slots_fd);
+    if (slots == MAP_FAILED) {
+        fprintf(stderr, "無法映射分段轉換的共用狀態檔: %s (%s)\n", argv[2], g_strerror(errno));
+        return 2;
+    }
+    ElevationShardSlot *slot = &slots[index];
+    const char *input_path = argv[4];
+    diagnostics_init(&slot->stats.diagnostics, input_path, tide_format_row_error_names(), TIDE_ROW_ERROR_COUNT, FALSE);
+
+    // 2. 重新開啟SEP（父行程已建立快取，這裡以記憶體映射載入），轉換本段
+    GString *report = g_string_new(NULL);
+    GError *error = NULL;
+    SepModel *sep_model = NULL;
+    SepRaster *sep_raster = NULL;
+    SepTin *sep_tin = NULL;
+    gboolean ok = elevation_load_sep(argv[7], &options, report, &sep_model, &sep_raster, &sep_tin, &error);
+    if (ok) {
+        ok = elevation_shard_convert(input_path, g_ascii_strtoll(argv[5], NULL, 10), g_ascii_strtoll(argv[6], NULL, 10),
+                                     argv[8], strcmp(argv[9], "-") != 0 ? argv[9] : NULL,
+                                     strcmp(argv[10], "-") != 0 ? argv[10] : NULL, sep_model_get_data(sep_model),
+                                     sep_raster, sep_tin, elevation_tide_format(&options), options.filtered_output,
+                                     slot);
+        sep_model_unref(sep_model);
+        sep_raster_free(sep_raster);
+        sep_tin_free(sep_tin);
+    } else {
+        g_snprintf(slot->error_message, sizeof(slot->error_message), "%s",
+                   error ? error->message : "無法載入SEP檔案");
+        g_clear_error(&error);
+    }
+
+    // 3. 診斷的字串指標只在本行程有效，交給父行程前清除
+    slot->stats.diagnostics.source = NULL;
+    slot->stats.diagnostics.category_names = NULL;
+    g_atomic_int_set(&slot->success, ok);
+    munmap(slots, slots_size);
+    g_string_free(report, TRUE);
+    return ok ? 0 : 1;
+}
+#else
+void elevation_set_shard_executable(const char *argv0) {
+    (void)argv0;
+}
+
+int elevation_shard_worker_main(int argc, char **argv) {
+    (void)argc;
+    (void)argv;
+    fprintf(stderr, "此平台不支援多行程分段轉換\n");
+    return 2;
+}
+#endif
@@ -0,0 +1,2354 @@
+// SEP 對照資料模組
+// 負責SEP對照文件的載入、二進位模型快取、分塊模型、hash table 精確匹配與空間網格插值查詢
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>   // DBL_MAX
+#include "sep_data.h"
+
+#ifndef MIN
+#define MIN(a,b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a,b) ((a) > (b) ? (a) : (b))
+#endif
+
+typedef struct {
+    double distance;
+    double adjustment;
+    double longitude;    // 近鄰的座標（分塊模型合併各分塊的近鄰時比對同一點）
+    double latitude;
+} Neighbor2;
+
+// 精確匹配表配置：開放定址（線性探測），容量為 2 的冪次，超過負載因子時加倍
+#define SEP_HASH_MIN_CAPACITY 16
+#define SEP_HASH_MAX_LOAD 0.7
+
+// 座標量化：以 1e-9 度（約 0.1 毫米）為單位的整數作為鍵，取代浮點數容差比較
+#define SEP_HASH_QUANTUM 1e9
+#define SEP_HASH_KEY_LIMIT 1e15          // 量化後超過此值（非經緯度）的座標不建立鍵
+#define SEP_HASH_EMPTY G_MAXUINT32       // 空槽標記
+
+// 最近鄰資料結構，用於儲存到目標點的距離和調整值
+typedef struct {
+    double distance;     // 到目標點的距離
+    double adjustment;   // SEP調整值
+    double latitude;     // 緯度
+    double longitude;    // 經度
+} NeighborPoint;
+
+// 大圓距離公式 (Haversine formula) 計算兩點間的距離
+static double calculate_distance(double lat1, double lon1, double lat2, double lon2) {
+    const double R = 6371000.0; // 地球半徑（公尺）
+    double dlat = (lat2 - lat1) * G_PI / 180.0;
+    double dlon = (lon2 - lon1) * G_PI / 180.0;
+
+    double a = sin(dlat/2) * sin(dlat/2) +
+               cos(lat1 * G_PI / 180.0) * cos(lat2 * G_PI / 180.0) *
+               sin(dlon/2) * sin(dlon/2);
+    double c = 2 * atan2(sqrt(a), sqrt(1-a));
+
+    return R * c; // 返回距離（公尺）
+}
+
+// 精確匹配表：槽只存點儲存區的索引，鍵由儲存區座標量化而得
+// 所有槽位於同一塊配置中；載入後指向模型資料（唯讀）
+typedef struct {
+    guint32 *slots;              // 點索引，SEP_HASH_EMPTY 表示空槽
+    guint32 capacity;            // 容量（2 的冪次）
+    guint32 count;               // 項目總數
+    const double *longitudes;    // 點儲存區
+    const double *latitudes;
+    const double *adjustments;
+} SepHashTable;
+
+// 效能優化：連續陣列儲存SEP點，用於快速最近鄰搜索
+typedef struct {
+    double *longitudes;
+    double *latitudes;
+    double *adjustments;
+    int count;
+    int capacity;
+} SepPointArray;
+
+// 空間網格大小（經緯度方向各 50 格）
+#define SEP_GRID_SIZE 50
+
+// 地理空間網格索引：所有點依 cell 排列（CSR），cell_start[c] 到 cell_start[c + 1] 為第 c 個 cell 的點
+// cell 編號為 lat_index * lon_grid_size + lon_index
+typedef struct {
+    int lat_grid_size, lon_grid_size; // 網格尺寸
+    double min_lat, max_lat;         // 經緯度範圍
+    double min_lon, max_lon;
+    double lat_resolution, lon_resolution; // 每個網格的經緯度解析度
+    const gint32 *cell_start;        // [cell 數 + 1]
+    const double *longitudes;        // 點儲存區（依 cell 排列）
+    const double *latitudes;
+    const double *adjustments;
+    double min_cos_lat;              // 網格緯度範圍內 cos(緯度) 的最小值，供距離下界使用
+} SpatialGrid;
+
+// 規則格網偵測參數
+#define SEP_LATTICE_MIN_POINTS 4             // 點數過少時不值得偵測
+#define SEP_LATTICE_MIN_FILL 0.25            // 最低填滿率，過低時密集陣列浪費記憶體
+#define SEP_LATTICE_MAX_NODES (64 * 1024 * 1024)
+#define SEP_LATTICE_STEP_TOLERANCE 1e-3      // 座標偏離理論格點的容許值（相對於步距）
+
+// 規則格網：SEP點位於固定步距的經緯度格點上時，以密集二維陣列儲存
+// 精確匹配與近鄰搜尋都改為索引運算
+typedef struct {
+    int nx, ny;                 // 經度、緯度方向節點數
+    double origin_lon, origin_lat;
+    double step_lon, step_lat;  // 格點步距（度）
+    const double *node_longitudes; // 每欄的經度（實際觀測值；整欄缺點時為理論值）[nx]
+    const double *node_latitudes;  // 每列的緯度 [ny]
+    const double *values;       // 調整值 [j * nx + i]，NAN 表示缺點
+    const gint32 *point_nodes;  // 每個SEP點所在節點 j * nx + i（載入順序）[point_count]
+    double min_cos_lat;         // 格網緯度範圍內 cos(緯度) 的最小值，供距離下界使用
+} SepLattice;
+
+// 簡易複合結構：點儲存區與索引都指向同一塊模型資料（二進位快取的記憶體映射，或載入時建立的緩衝區）
+// 一般索引時每個點只存一份（依 cell 排列的 SoA），精確匹配表只存索引；規則格網時密集陣列即為儲存區
+struct SepDataStructure {
+    int point_count;
+    const double *longitudes;   // 點儲存區（一般索引；規則格網時為 NULL）
+    const double *latitudes;
+    const double *adjustments;
+    SepHashTable *hash_table;   // 精確匹配（規則格網時為 NULL）
+    SpatialGrid *spatial_grid;  // 空間網格索引（規則格網時為 NULL）
+    SepLattice *lattice;        // 規則格網，偵測失敗時為 NULL
+    struct SepTileSet *tiles;   // 分塊模型（此時上面的索引皆為 NULL，查詢轉給各分塊）
+    double min_lon, max_lon;    // 所有點的經緯度範圍
+    double min_lat, max_lat;
+
+    GMappedFile *mapped;        // 二進位快取的唯讀映射
+    gchar *owned_buffer;        // 由文字檔建立的模型資料
+    char *cache_path;           // 二進位快取路徑
+    gboolean from_cache;        // 是否由二進位快取載入
+    gboolean cache_written;     // 由文字檔建立時，快取是否寫入成功
+    double load_milliseconds;   // 載入耗時
+    int load_threads;           // 解析文字檔使用的執行緒數（由快取載入時為 0）
+    gsize model_bytes;          // 模型資料大小
+    gsize peak_bytes;           // 載入過程的尖峰記憶體（估計值）
+};
+
+// 初始化效能優化的SEP點陣列
+static SepPointArray* sep_point_array_init(int initial_capacity) {
+    SepPointArray *array = g_new(SepPointArray, 1);
+    array->capacity = initial_capacity > 0 ? initial_capacity : 1024;
+    array->count = 0;
+
+    array->longitudes = g_new(double, array->capacity);
+    array->latitudes = g_new(double, array->capacity);
+    array->adjustments = g_new(double, array->capacity);
+
+    return array;
+}
+
+// 釋放SEP點陣列
+static void sep_point_array_free(SepPointArray *array) {
+    if (!array) return;
+
+    g_free(array->longitudes);
+    g_free(array->latitudes);
+    g_free(array->adjustments);
+    g_free(array);
+}
+
+// ===========================================
+// 平行載入：文字檔依行界切成區塊平行解析，空間網格的計數排序依點範圍平行進行
+// ===========================================
+
+#define SEP_LOAD_MAX_THREADS 16
+#define SEP_PARSE_MIN_CHUNK (1024 * 1024)       // 每個解析執行緒至少處理的位元組數
+#define SEP_INDEX_MIN_POINTS (64 * 1024)        // 每個建立索引的執行緒至少處理的點數
+#define SEP_LINE_BUFFER 512                     // 與原本 fgets 的行緩衝區相同，超長行以相同方式切段
+
+// 依工作量決定執行緒數：每個執行緒至少分到 min_work，最多為處理器數量
+static int sep_load_thread_count(gint64 work, gint64 min_work) {
+    gint64 threads = MIN((gint64)g_get_num_processors(), SEP_LOAD_MAX_THREADS);
+    threads = MIN(threads, work / min_work);
+    return (int)MAX(threads, 1);
+}
+
+typedef void (*SepParallelFunc)(int part, gpointer user_data);
+
+typedef struct {
+    SepParallelFunc func;
+    int part;
+    gpointer user_data;
+} SepParallelTask;
+
+static gpointer sep_parallel_thread(gpointer user_data) {
+    SepParallelTask *task = (SepParallelTask *)user_data;
+    task->func(task->part, task->user_data);
+    return NULL;
+}
+
+// 以 part_count 個執行緒分別執行 func(0 .. part_count - 1)，第 0 份由呼叫端執行緒處理，全部完成後返回
+static void sep_parallel_run(int part_count, SepParallelFunc func, gpointer user_data) {
+    if (part_count <= 1) {
+        func(0, user_data);
+        return;
+    }
+
+    SepParallelTask *tasks = g_new(SepParallelTask, part_count);
+    GThread **threads = g_new(GThread *, part_count);
+    for (int i = 1; i < part_count; i++) {
+        tasks[i].func = func;
+        tasks[i].part = i;
+        tasks[i].user_data = user_data;
+        threads[i] = g_thread_new("sep-load", sep_parallel_thread, &tasks[i]);
+    }
+    func(0, user_data);
+    for (int i = 1; i < part_count; i++) {
+        g_thread_join(threads[i]);
+    }
+    g_free(threads);
+    g_free(tasks);
+}
+
+// 將經緯度轉換為網格索引
+static void lat_lon_to_grid_indices(const SpatialGrid *grid, double latitude, double longitude,
+                                   int *lat_index, int *lon_index) {
+    if (grid->max_lat == grid->min_lat) {
+        *lat_index = 0;
+    } else {
+        *lat_index = (int)((latitude - grid->min_lat) / grid->lat_resolution);
+        *lat_index = CLAMP(*lat_index, 0, grid->lat_grid_size - 1);
+    }
+
+    if (grid->max_lon == grid->min_lon) {
+        *lon_index = 0;
+    } else {
+        *lon_index = (int)((longitude - grid->min_lon) / grid->lon_resolution);
+        *lon_index = CLAMP(*lon_index, 0, grid->lon_grid_size - 1);
+    }
+}
+
+// 向陣列添加一個點
+static void sep_point_array_add(SepPointArray *array, double longitude, double latitude, double adjustment) {
+    // 動態擴容
+    if (array->count >= array->capacity) {
+        array->capacity *= 2;
+        array->longitudes = g_renew(double, array->longitudes, array->capacity);
+        array->latitudes = g_renew(double, array->latitudes, array->capacity);
+        array->adjustments = g_renew(double, array->adjustments, array->capacity);
+    }
+
+    array->longitudes[array->count] = longitude;
+    array->latitudes[array->count] = latitude;
+    array->adjustments[array->count] = adjustment;
+    array->count++;
+}
+
+// 緯度差、經度差（度，DBL_MAX 表示該方向沒有點）至少如此的點到目標點的距離下界（公尺）
+// 緯度方向：大圓距離不小於緯度差的弧長；經度方向：由 haversine 公式
+// a >= cos(lat1) * cos(lat2) * sin^2(dlon / 2) 推得，min_cos_lat 為點所在範圍內 cos(緯度) 的最小值
+static double gap_distance_bound(double lat_gap, double lon_gap, double latitude, double min_cos_lat) {
+    const double R = 6371000.0;
+    const double slack = 1.0 - 1e-9;
+    double bound = DBL_MAX;
+
+    if (lat_gap < DBL_MAX) {
+        bound = MIN(bound, R * lat_gap * G_PI / 180.0 * slack);
+    }
+    if (lon_gap < DBL_MAX) {
+        double cos_product = cos(latitude * G_PI / 180.0) * min_cos_lat;
+        double lon_bound = 0.0;
+        if (cos_product > 0.0 && lon_gap < 180.0) {
+            double h = sqrt(cos_product) * sin(lon_gap * G_PI / 360.0);
+            lon_bound = 2.0 * R * asin(MIN(h, 1.0)) * slack;
+        }
+        bound = MIN(bound, lon_bound);
+    }
+    return bound;
+}
+
+// 列出第 r 圈的 cell（依列優先順序），只包含與中心的 Chebyshev 距離恰為 r 者
+// 靠近邊界時不會重複列出內圈已掃過的 cell；回傳 cell 數
+static int grid_ring_cells(const SpatialGrid *grid, int ci, int cj, int r, int *cells) {
+    int count = 0;
+    int imin = MAX(0, ci - r), imax = MIN(grid->lat_grid_size - 1, ci + r);
+    int jmin = MAX(0, cj - r), jmax = MIN(grid->lon_grid_size - 1, cj + r);
+
+    for (int i = imin; i <= imax; ++i) {
+        if (i == ci - r || i == ci + r) {
+            for (int j = jmin; j <= jmax; ++j) cells[count++] = i * grid->lon_grid_size + j;
+        } else {
+            if (cj - r >= 0) cells[count++] = i * grid->lon_grid_size + (cj - r);
+            if (r > 0 && cj + r < grid->lon_grid_size) cells[count++] = i * grid->lon_grid_size + (cj + r);
+        }
+    }
+    return count;
+}
+
+// 第 r 圈以外所有 cell 中的點到目標點的距離下界（公尺）
+// cell 邊界以網格解析度計算，保留少許餘裕涵蓋點在 cell 邊界上的捨入；沒有點的方向（範圍退化）不列入
+static double grid_outside_ring_bound(const SpatialGrid *grid, int ci, int cj, int r,
+                                      double longitude, double latitude) {
+    double lat_gap = DBL_MAX;
+    if (grid->lat_resolution > 0.0) {
+        if (ci - r - 1 >= 0) lat_gap = MIN(lat_gap, latitude - (grid->min_lat + (ci - r) * grid->lat_resolution));
+        if (ci + r + 1 < grid->lat_grid_size) {
+            lat_gap = MIN(lat_gap, grid->min_lat + (ci + r + 1) * grid->lat_resolution - latitude);
+        }
+    }
+    if (lat_gap < DBL_MAX) lat_gap = MAX(0.0, lat_gap - grid->lat_resolution * 1e-9);
+
+    double lon_gap = DBL_MAX;
+    if (grid->lon_resolution > 0.0) {
+        if (cj - r - 1 >= 0) lon_gap = MIN(lon_gap, longitude - (grid->min_lon + (cj - r) * grid->lon_resolution));
+        if (cj + r + 1 < grid->lon_grid_size) {
+            lon_gap = MIN(lon_gap, grid->min_lon + (cj + r + 1) * grid->lon_resolution - longitude);
+        }
+    }
+    if (lon_gap < DBL_MAX) lon_gap = MAX(0.0, lon_gap - grid->lon_resolution * 1e-9);
+
+    return gap_distance_bound(lat_gap, lon_gap, latitude, grid->min_cos_lat);
+}
+
+// 兩近鄰距離反比權重插值；只有一個近鄰時直接回傳，沒有近鄰時回傳 SEP_NOT_FOUND
+static double interpolate_two_nearest(Neighbor2 best0, Neighbor2 best1) {
+    if (best1.distance < DBL_MAX) {
+        // 兩近鄰距離反比權重
+        double d1 = best0.distance, d2 = best1.distance;
+        double a1 = best0.adjustment, a2 = best1.adjustment;
+        if (d1 + d2 == 0.0) return (a1 + a2) * 0.5; // 退化情況
+        return (a2 * d1 + a1 * d2) / (d1 + d2);
+    } else if (best0.distance < DBL_MAX) {
+        // 只有一個近鄰：直接回傳
+        return best0.adjustment;
+    }
+
+    // 找不到近鄰
+    return SEP_NOT_FOUND;
+}
+
+// 在空間網格中找兩個最近鄰（不足兩點時距離為 DBL_MAX）
+// 由近而遠逐圈掃描，已找到兩點且其餘 cell 的距離下界超過第二近鄰時停止，結果為真正的兩個最近鄰
+static void sep_grid_two_nearest(const SpatialGrid *grid, double target_longitude, double target_latitude,
+                                 Neighbor2 *best0, Neighbor2 *best1) {
+    best0->distance = best1->distance = DBL_MAX;
+    best0->adjustment = best1->adjustment = 0.0;
+
+    // 找出目標點所在 cell
+    int ci = 0, cj = 0;
+    lat_lon_to_grid_indices(grid, target_latitude, target_longitude, &ci, &cj);
+
+    // 最大擴圈半徑：覆蓋整個網格邊界即可
+    int cells[8 * SEP_GRID_SIZE + 1];
+    const int max_r = MAX(grid->lat_grid_size, grid->lon_grid_size);
+    for (int r = 0; r < max_r; ++r) {
+        int cell_count = grid_ring_cells(grid, ci, cj, r, cells);
+
+        for (int c = 0; c < cell_count; ++c) {
+            // 掃描 cell 內所有點，維護兩個最近鄰
+            for (gint32 k = grid->cell_start[cells[c]]; k < grid->cell_start[cells[c] + 1]; ++k) {
+                double d = calculate_distance(
+                    target_latitude,  target_longitude,
+                    grid->latitudes[k], grid->longitudes[k]);
+
+                Neighbor2 candidate = { .distance = d, .adjustment = grid->adjustments[k],
+                                        .longitude = grid->longitudes[k], .latitude = grid->latitudes[k] };
+                if (d < best0->distance) {
+                    *best1 = *best0;
+                    *best0 = candidate;
+                } else if (d < best1->distance) {
+                    *best1 = candidate;
+                }
+            }
+        }
+
+        if (best1->distance < DBL_MAX &&
+            grid_outside_ring_bound(grid, ci, cj, r, target_longitude, target_latitude) > best1->distance) {
+            break;
+        }
+    }
+}
+
+// 使用空間網格的全域插值查詢 (確保總是能找到最近點)；second_distance 不為 NULL 時回傳第二近鄰的距離
+static double sep_grid_lookup_with_interpolation(const SpatialGrid *grid,
+                                                 double target_longitude,
+                                                 double target_latitude,
+                                                 double *second_distance)
+{
+    if (!grid) return -99999.0;
+
+    Neighbor2 best0, best1;
+    sep_grid_two_nearest(grid, target_longitude, target_latitude, &best0, &best1);
+    if (second_distance) *second_distance = best1.distance;
+    return interpolate_two_nearest(best0, best1);
+}
+
+// ===========================================
+// 規則格網：偵測與索引運算查詢
+// ===========================================
+
+static int compare_doubles(const void *a, const void *b) {
+    double da = *(const double *)a;
+    double db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+// 排序並去除完全相同的值，回傳不重複值個數
+static int sorted_unique_values(const double *values, int count, double *out) {
+    memcpy(out, values, sizeof(double) * count);
+    qsort(out, count, sizeof(double), compare_doubles);
+
+    int unique = 0;
+    for (int k = 0; k < count; k++) {
+        if (unique == 0 || out[k] != out[unique - 1]) {
+            out[unique++] = out[k];
+        }
+    }
+    return unique;
+}
+
+// 檢查一個軸上的不重複座標是否落在固定步距的格點上（允許整欄/整列缺點）
+static gboolean lattice_fit_axis(const double *unique, int count, double *origin, double *step, int *nodes) {
+    if (count < 2) return FALSE;
+
+    double min_diff = DBL_MAX;
+    for (int k = 0; k + 1 < count; k++) {
+        min_diff = MIN(min_diff, unique[k + 1] - unique[k]);
+    }
+
+    double span = unique[count - 1] - unique[0];
+    double last_index = floor(span / min_diff + 0.5);
+    if (last_index + 1.0 > SEP_LATTICE_MAX_NODES) return FALSE;
+
+    // 以首尾兩點推算步距，避免以最小間距推算時誤差隨索引累積
+    *origin = unique[0];
+    *step = span / last_index;
+    *nodes = (int)last_index + 1;
+
+    // 同一欄/列只記錄一個觀測座標，精確匹配以 1e-10 比較；落在同一格點線上的座標彼此不一致時
+    // 部分點會查不到自己的值，結果與一般索引不同，因此不採用規則格網
+    double tolerance = *step * SEP_LATTICE_STEP_TOLERANCE;
+    double previous_index = -1.0, group_first = 0.0;
+    for (int k = 0; k < count; k++) {
+        double index = floor((unique[k] - *origin) / *step + 0.5);
+        if (fabs(unique[k] - (*origin + index * *step)) > tolerance) {
+            return FALSE;
+        }
+        if (index == previous_index) {
+            if (unique[k] - group_first >= 1e-10) return FALSE;
+        } else {
+            previous_index = index;
+            group_first = unique[k];
+        }
+    }
+    return TRUE;
+}
+
+static int lattice_index(double value, double origin, double step) {
+    return (int)floor((value - origin) / step + 0.5);
+}
+
+// 偵測SEP點是否構成規則格網的幾何條件（步距固定、填滿率足夠），成功時填入格網尺寸、原點與步距
+// 重複點在填入調整值時才能發現，由呼叫端處理
+static gboolean sep_lattice_fit(const SepPointArray *points, SepLattice *geometry) {
+    int n = points->count;
+    if (n < SEP_LATTICE_MIN_POINTS) return FALSE;
+
+    double *unique_lon = g_new(double, n);
+    double *unique_lat = g_new(double, n);
+    int nux = sorted_unique_values(points->longitudes, n, unique_lon);
+    int nuy = sorted_unique_values(points->latitudes, n, unique_lat);
+
+    gboolean fits = lattice_fit_axis(unique_lon, nux, &geometry->origin_lon, &geometry->step_lon, &geometry->nx) &&
+                    lattice_fit_axis(unique_lat, nuy, &geometry->origin_lat, &geometry->step_lat, &geometry->ny) &&
+                    (double)geometry->nx * geometry->ny <= SEP_LATTICE_MAX_NODES &&
+                    n >= (double)geometry->nx * geometry->ny * SEP_LATTICE_MIN_FILL;
+
+    g_free(unique_lon);
+    g_free(unique_lat);
+    return fits;
+}
+
+// 在格點 (i, j) 上提供近鄰候選
+static void lattice_offer_node(const SepLattice *lattice, int i, int j, double longitude, double latitude,
+                               Neighbor2 *best0, Neighbor2 *best1) {
+    double value = lattice->values[(gsize)j * lattice->nx + i];
+    if (isnan(value)) return;
+
+    double d = calculate_distance(latitude, longitude, lattice->node_latitudes[j], lattice->node_longitudes[i]);
+    Neighbor2 candidate = { .distance = d, .adjustment = value,
+                            .longitude = lattice->node_longitudes[i], .latitude = lattice->node_latitudes[j] };
+    if (d < best0->distance) {
+        *best1 = *best0;
+        *best0 = candidate;
+    } else if (d < best1->distance) {
+        *best1 = candidate;
+    }
+}
+
+// 第 r 圈以外所有格點到目標點的距離下界（公尺），格點座標以步距容差放寬
+static double lattice_outside_ring_bound(const SepLattice *lattice, int ci, int cj, int r,
+                                         double longitude, double latitude) {
+    double lat_gap = DBL_MAX;
+    if (cj - r - 1 >= 0) lat_gap = MIN(lat_gap, latitude - lattice->node_latitudes[cj - r - 1]);
+    if (cj + r + 1 < lattice->ny) lat_gap = MIN(lat_gap, lattice->node_latitudes[cj + r + 1] - latitude);
+    if (lat_gap < DBL_MAX) lat_gap = MAX(0.0, lat_gap - lattice->step_lat * SEP_LATTICE_STEP_TOLERANCE);
+
+    double lon_gap = DBL_MAX;
+    if (ci - r - 1 >= 0) lon_gap = MIN(lon_gap, longitude - lattice->node_longitudes[ci - r - 1]);
+    if (ci + r + 1 < lattice->nx) lon_gap = MIN(lon_gap, lattice->node_longitudes[ci + r + 1] - longitude);
+    if (lon_gap < DBL_MAX) lon_gap = MAX(0.0, lon_gap - lattice->step_lon * SEP_LATTICE_STEP_TOLERANCE);
+
+    return gap_distance_bound(lat_gap, lon_gap, latitude, lattice->min_cos_lat);
+}
+
+// 規則格網中以 (ci, cj) 為中心找兩個最近鄰（不足兩點時距離為 DBL_MAX），由近而遠逐圈搜尋，
+// 已找到兩點且其餘格點的距離下界超過第二近鄰時停止；rings 不為 NULL 時累加掃描的圈數
+static void sep_lattice_two_nearest(const SepLattice *lattice, int ci, int cj, double longitude, double latitude,
+                                    Neighbor2 *best0, Neighbor2 *best1, guint64 *rings) {
+    best0->distance = best1->distance = DBL_MAX;
+    best0->adjustment = best1->adjustment = 0.0;
+
+    const int max_r = MAX(lattice->nx, lattice->ny);
+    int r;
+    for (r = 0; r < max_r; ++r) {
+        int imin = MAX(0, ci - r), imax = MIN(lattice->nx - 1, ci + r);
+
+        // 上下兩列
+        if (cj - r >= 0) {
+            for (int i = imin; i <= imax; ++i) lattice_offer_node(lattice, i, cj - r, longitude, latitude, best0, best1);
+        }
+        if (r > 0 && cj + r < lattice->ny) {
+            for (int i = imin; i <= imax; ++i) lattice_offer_node(lattice, i, cj + r, longitude, latitude, best0, best1);
+        }
+
+        // 左右兩欄（不含已掃過的上下兩列）
+        int jmin = MAX(0, cj - r + 1), jmax = MIN(lattice->ny - 1, cj + r - 1);
+        for (int j = jmin; j <= jmax; ++j) {
+            if (ci - r >= 0) lattice_offer_node(lattice, ci - r, j, longitude, latitude, best0, best1);
+            if (r > 0 && ci + r < lattice->nx) lattice_offer_node(lattice, ci + r, j, longitude, latitude, best0, best1);
+        }
+
+        if (best1->distance < DBL_MAX &&
+            lattice_outside_ring_bound(lattice, ci, cj, r, longitude, latitude) > best1->distance) {
+            break;
+        }
+    }
+    if (rings) *rings += (guint64)MIN(r + 1, max_r);
+}
+
+// 目標點最近的格點（範圍外夾擠到邊緣）
+static void lattice_cell_of(const SepLattice *lattice, double longitude, double latitude, int *ci, int *cj) {
+    *ci = CLAMP(lattice_index(longitude, lattice->origin_lon, lattice->step_lon), 0, lattice->nx - 1);
+    *cj = CLAMP(lattice_index(latitude, lattice->origin_lat, lattice->step_lat), 0, lattice->ny - 1);
+}
+
+// 規則格網查詢：四捨五入取得最近格點做精確匹配，否則以兩個最近鄰插值；
+// rings 不為 NULL 時累加掃描的圈數，second_distance 不為 NULL 時回傳第二近鄰的距離（精確匹配為 0）
+static double sep_lattice_lookup(const SepLattice *lattice, double longitude, double latitude, SepMatchKind *kind,
+                                 guint64 *rings, double *second_distance) {
+    int ci, cj;
+    lattice_cell_of(lattice, longitude, latitude, &ci, &cj);
+
+    double center = lattice->values[(gsize)cj * lattice->nx + ci];
+    if (!isnan(center) &&
+        fabs(lattice->node_longitudes[ci] - longitude) < 1e-10 &&
+        fabs(lattice->node_latitudes[cj] - latitude) < 1e-10) {
+        *kind = SEP_MATCH_EXACT;
+        if (second_distance) *second_distance = 0.0;
+        return center;
+    }
+
+    Neighbor2 best0, best1;
+    sep_lattice_two_nearest(lattice, ci, cj, longitude, latitude, &best0, &best1, rings);
+    if (second_distance) *second_distance = best1.distance;
+
+    double adjustment = interpolate_two_nearest(best0, best1);
+    *kind = adjustment > -99998.0 ? SEP_MATCH_INTERPOLATED : SEP_MATCH_NONE;
+    return adjustment;
+}
+
+// 座標量化為整數鍵；非有限值或超出範圍時回傳 FALSE
+static gboolean sep_hash_key(double value, gint64 *key) {
+    double scaled = value * SEP_HASH_QUANTUM;
+    if (!isfinite(scaled) || fabs(scaled) > SEP_HASH_KEY_LIMIT) return FALSE;
+
+    *key = llround(scaled);
+    return TRUE;
+}
+
+// 混合兩個量化鍵（splitmix64 收尾），讓相鄰格點分散到不同槽
+static guint32 sep_hash_mix(gint64 key_lon, gint64 key_lat) {
+    guint64 h = (guint64)key_lon * G_GUINT64_CONSTANT(0x9E3779B97F4A7C15) ^ (guint64)key_lat;
+    h ^= h >> 30;
+    h *= G_GUINT64_CONSTANT(0xBF58476D1CE4E5B9);
+    h ^= h >> 27;
+    h *= G_GUINT64_CONSTANT(0x94D049BB133111EB);
+    h ^= h >> 31;
+    return (guint32)h;
+}
+
+// 儲存區第 index 個點的座標是否等於量化鍵
+static gboolean sep_hash_point_matches(const SepHashTable *table, guint32 index, gint64 key_lon, gint64 key_lat) {
+    gint64 point_lon, point_lat;
+    return sep_hash_key(table->longitudes[index], &point_lon) && point_lon == key_lon &&
+           sep_hash_key(table->latitudes[index], &point_lat) && point_lat == key_lat;
+}
+
+// 線性探測：回傳鍵相同的槽，或探測序列上的第一個空槽
+static guint32* sep_hash_probe(const SepHashTable *table, guint32 *slots, guint32 capacity,
+                               gint64 key_lon, gint64 key_lat) {
+    guint32 mask = capacity - 1;
+    guint32 index = sep_hash_mix(key_lon, key_lat) & mask;
+
+    while (slots[index] != SEP_HASH_EMPTY && !sep_hash_point_matches(table, slots[index], key_lon, key_lat)) {
+        index = (index + 1) & mask;
+    }
+    return &slots[index];
+}
+
+static guint32* sep_hash_alloc_slots(guint32 capacity) {
+    guint32 *slots = g_new(guint32, capacity);
+    for (guint32 i = 0; i < capacity; i++) {
+        slots[i] = SEP_HASH_EMPTY;
+    }
+    return slots;
+}
+
+// 取得足以容納 expected 筆而不超過負載因子的 2 的冪次容量
+static guint32 sep_hash_capacity_for(int expected) {
+    guint32 capacity = SEP_HASH_MIN_CAPACITY;
+    while (capacity < G_MAXUINT32 / 2 && expected > capacity * SEP_HASH_MAX_LOAD) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+// 容量加倍並重新放置所有項目
+static void sep_hash_grow(SepHashTable *table) {
+    guint32 capacity = table->capacity * 2;
+    guint32 *slots = sep_hash_alloc_slots(capacity);
+
+    for (guint32 i = 0; i < table->capacity; i++) {
+        guint32 index = table->slots[i];
+        if (index == SEP_HASH_EMPTY) continue;
+
+        // 已在表中的點鍵必定有效（插入時已檢查）
+        gint64 key_lon = 0, key_lat = 0;
+        sep_hash_key(table->longitudes[index], &key_lon);
+        sep_hash_key(table->latitudes[index], &key_lat);
+        *sep_hash_probe(table, slots, capacity, key_lon, key_lat) = index;
+    }
+
+    g_free(table->slots);
+    table->slots = slots;
+    table->capacity = capacity;
+}
+
+// 插入儲存區第 index 個點（重複座標以最後插入者為準）
+static void sep_hash_insert(SepHashTable *table, guint32 index) {
+    gint64 key_lon, key_lat;
+    if (!sep_hash_key(table->longitudes[index], &key_lon) || !sep_hash_key(table->latitudes[index], &key_lat)) return;
+
+    if (table->count + 1 > table->capacity * SEP_HASH_MAX_LOAD) {
+        sep_hash_grow(table);
+    }
+
+    guint32 *slot = sep_hash_probe(table, table->slots, table->capacity, key_lon, key_lat);
+    if (*slot == SEP_HASH_EMPTY) {
+        table->count++;
+    }
+    *slot = index;
+}
+
+// 查找對應的調整值
+static double sep_hash_lookup(const SepHashTable *table, double longitude, double latitude) {
+    gint64 key_lon, key_lat;
+    if (!sep_hash_key(longitude, &key_lon) || !sep_hash_key(latitude, &key_lat)) return -99999.0;
+
+    // 探測次數以容量為上限，避免損毀的快取造成無窮迴圈
+    guint32 mask = table->capacity - 1;
+    guint32 slot = sep_hash_mix(key_lon, key_lat) & mask;
+    for (guint32 probe = 0; probe < table->capacity; probe++) {
+        guint32 index = table->slots[slot];
+        if (index == SEP_HASH_EMPTY) break;
+        if (sep_hash_point_matches(table, index, key_lon, key_lat)) {
+            return table->adjustments[index];
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    // 未找到
+    return -99999.0; // 特殊值表示未找到
+}
+
+// 初始化複合結構
+static SepDataStructure* sep_data_init(void) {
+    return g_new0(SepDataStructure, 1);
+}
+
+static void sep_tile_set_free(struct SepTileSet *tiles);
+static double sep_model_lookup(const SepDataStructure *data, double longitude, double latitude, SepMatchKind *kind,
+                               double *second_distance);
+static void sep_model_lookup_batch(const SepDataStructure *data, SepLookupContext *ctx,
+                                   const double *longitudes, const double *latitudes, int count,
+                                   double *adjustments, SepMatchKind *kinds, double *second_distances);
+
+// 釋放複合結構（記憶體映射與模型緩衝區一併釋放）
+void sep_data_free(SepDataStructure *data) {
+    if (!data) return;
+
+    sep_tile_set_free(data->tiles);   // 各分塊指向同一個映射，須先於映射釋放
+    g_free(data->hash_table);    // 槽陣列屬於模型資料
+    g_free(data->spatial_grid);
+    g_free(data->lattice);
+    if (data->mapped) {
+        g_mapped_file_unref(data->mapped);
+    }
+    g_free(data->owned_buffer);
+    g_free(data->cache_path);
+    g_free(data);
+}
+
+// ===========================================
+// 二進位模型：標頭 + 點儲存區 + 預先建立的索引，快取檔可直接唯讀映射使用
+// ===========================================
+
+#define SEP_MODEL_MAGIC "SEPMODEL"
+#define SEP_MODEL_VERSION 4
+#define SEP_MODEL_HASH_SAMPLE (1024 * 1024)  // 來源檔案雜湊取樣：開頭與結尾各 1 MiB
+
+enum {
+    SEP_INDEX_GENERAL = 0,   // hash table + 空間網格
+    SEP_INDEX_LATTICE = 1    // 規則格網
+};
+
+// 模型標頭（所有欄位皆為 8 位元組對齊，直接以記憶體格式寫出）
+typedef struct {
+    char magic[8];              // SEP_MODEL_MAGIC
+    guint32 version;            // SEP_MODEL_VERSION
+    guint32 index_kind;         // SEP_INDEX_*
+    gint64 source_size;         // 來源SEP文字檔大小
+    gint64 source_mtime;        // 來源SEP文字檔修改時間
+    guint64 source_hash;        // 來源SEP文字檔取樣雜湊
+    gint64 point_count;
+    double min_lon, max_lon, min_lat, max_lat;
+    gint32 grid_lat_size, grid_lon_size;        // 一般索引
+    double grid_lat_resolution, grid_lon_resolution;
+    guint32 hash_capacity, hash_count;          // 一般索引的精確匹配表
+    gint32 lattice_nx, lattice_ny;              // 規則格網
+    double lattice_origin_lon, lattice_origin_lat;
+    double lattice_step_lon, lattice_step_lat;
+    double lattice_min_cos_lat;
+} SepModelHeader;
+
+// 各區段在模型資料中的位移
+typedef struct {
+    guint64 points;             // 一般索引：點儲存區，依 cell 排列的經度、緯度、調整值各 point_count 個 double
+    guint64 cell_start;         // 一般索引：gint32[cell 數 + 1]
+    guint64 hash_slots;         // 一般索引：精確匹配表 guint32[hash_capacity]
+    guint64 node_longitudes;    // 規則格網
+    guint64 node_latitudes;
+    guint64 values;
+    guint64 point_nodes;        // 規則格網：gint32[point_count]
+    guint64 total;              // 模型資料總長度
+} SepModelLayout;
+
+static guint64 align8(guint64 value) {
+    return (value + 7) & ~(guint64)7;
+}
+
+static void sep_model_layout(const SepModelHeader *header, SepModelLayout *layout) {
+    guint64 n = (guint64)header->point_count;
+    guint64 offset = sizeof(SepModelHeader);
+
+    memset(layout, 0, sizeof(*layout));
+    if (header->index_kind == SEP_INDEX_LATTICE) {
+        layout->node_longitudes = offset;
+        offset += (guint64)header->lattice_nx * sizeof(double);
+        layout->node_latitudes = offset;
+        offset += (guint64)header->lattice_ny * sizeof(double);
+        layout->values = offset;
+        offset += (guint64)header->lattice_nx * header->lattice_ny * sizeof(double);
+        layout->point_nodes = offset;
+        offset += align8(n * sizeof(gint32));
+    } else {
+        guint64 cells = (guint64)header->grid_lat_size * header->grid_lon_size;
+        layout->points = offset;
+        offset += 3 * n * sizeof(double);
+        layout->cell_start = offset;
+        offset += align8((cells + 1) * sizeof(gint32));
+        layout->hash_slots = offset;
+        offset += align8((guint64)header->hash_capacity * sizeof(guint32));
+    }
+    layout->total = offset;
+}
+
+// 建立規則格網模型；同一格點出現兩次時回傳 NULL（一般索引會把兩點都當成近鄰候選，無法以單一值表示）
+static gchar* sep_model_build_lattice(const SepPointArray *points, SepModelHeader *header, gsize *length) {
+    SepModelLayout layout;
+    sep_model_layout(header, &layout);
+    gchar *buffer = g_malloc0((gsize)layout.total);
+
+    int nx = header->lattice_nx, ny = header->lattice_ny;
+    double *node_longitudes = (double *)(buffer + layout.node_longitudes);
+    double *node_latitudes = (double *)(buffer + layout.node_latitudes);
+    double *values = (double *)(buffer + layout.values);
+    gint32 *point_nodes = (gint32 *)(buffer + layout.point_nodes);
+
+    // 每欄/每列座標：先填理論值，再以實際觀測值覆蓋，精確匹配比較的是觀測值
+    for (int i = 0; i < nx; i++) node_longitudes[i] = header->lattice_origin_lon + i * header->lattice_step_lon;
+    for (int j = 0; j < ny; j++) node_latitudes[j] = header->lattice_origin_lat + j * header->lattice_step_lat;
+    for (gsize k = 0; k < (gsize)nx * ny; k++) values[k] = NAN;
+
+    for (int k = 0; k < points->count; k++) {
+        int i = lattice_index(points->longitudes[k], header->lattice_origin_lon, header->lattice_step_lon);
+        int j = lattice_index(points->latitudes[k], header->lattice_origin_lat, header->lattice_step_lat);
+        double *slot = &values[(gsize)j * nx + i];
+
+        if (!isnan(*slot)) {
+            g_free(buffer);
+            return NULL;
+        }
+        *slot = points->adjustments[k];
+        point_nodes[k] = j * nx + i;
+        node_longitudes[i] = points->longitudes[k];
+        node_latitudes[j] = points->latitudes[k];
+    }
+
+    header->lattice_min_cos_lat = MIN(cos(node_latitudes[0] * G_PI / 180.0),
+                                      cos(node_latitudes[ny - 1] * G_PI / 180.0));
+    memcpy(buffer, header, sizeof(*header));
+    *length = (gsize)layout.total;
+    return buffer;
+}
+
+// 平行建立空間網格的工作：每段處理連續的一段點（依載入順序）
+typedef struct {
+    const SepPointArray *points;
+    const SpatialGrid *geometry;
+    int part_count;
+    int cells;
+    gint32 *position;           // 每點先存 cell 編號，再改為儲存區位置
+    gint32 *cursors;            // [part_count * cells]：先是各段每個 cell 的點數，再改為各段在該 cell 的下一個位置
+    double *store_longitudes;   // 點儲存區
+    double *store_latitudes;
+    double *store_adjustments;
+} SepGridBuildJob;
+
+static void sep_grid_part_range(const SepGridBuildJob *job, int part, int *begin, int *end) {
+    *begin = (int)((gint64)job->points->count * part / job->part_count);
+    *end = (int)((gint64)job->points->count * (part + 1) / job->part_count);
+}
+
+static void sep_grid_count_part(int part, gpointer user_data) {
+    SepGridBuildJob *job = (SepGridBuildJob *)user_data;
+    gint32 *counts = &job->cursors[(gsize)part * job->cells];
+    int begin, end;
+    sep_grid_part_range(job, part, &begin, &end);
+
+    for (int k = begin; k < end; k++) {
+        int lat_index, lon_index;
+        lat_lon_to_grid_indices(job->geometry, job->points->latitudes[k], job->points->longitudes[k],
+                                &lat_index, &lon_index);
+        job->position[k] = lat_index * SEP_GRID_SIZE + lon_index;
+        counts[job->position[k]]++;
+    }
+}
+
+static void sep_grid_scatter_part(int part, gpointer user_data) {
+    SepGridBuildJob *job = (SepGridBuildJob *)user_data;
+    gint32 *cursor = &job->cursors[(gsize)part * job->cells];
+    int begin, end;
+    sep_grid_part_range(job, part, &begin, &end);
+
+    for (int k = begin; k < end; k++) {
+        gint32 slot = cursor[job->position[k]]++;
+        job->store_longitudes[slot] = job->points->longitudes[k];
+        job->store_latitudes[slot] = job->points->latitudes[k];
+        job->store_adjustments[slot] = job->points->adjustments[k];
+        job->position[k] = slot;
+    }
+}
+
+// 建立一般索引模型：以最終經緯度範圍計算每點所在 cell，再以計數排序將點依 cell 排列成點儲存區（cell 內維持載入順序），
+// 精確匹配表依載入順序插入各點在儲存區中的索引；temp_bytes 回傳建立過程的暫存空間
+static gchar* sep_model_build_grid(const SepPointArray *points, SepModelHeader *header, gsize *length,
+                                   gsize *temp_bytes) {
+    header->grid_lat_size = SEP_GRID_SIZE;
+    header->grid_lon_size = SEP_GRID_SIZE;
+    header->grid_lat_resolution = (header->max_lat - header->min_lat) / SEP_GRID_SIZE;
+    header->grid_lon_resolution = (header->max_lon - header->min_lon) / SEP_GRID_SIZE;
+    header->hash_capacity = sep_hash_capacity_for(points->count);
+
+    SepModelLayout layout;
+    sep_model_layout(header, &layout);
+    gchar *buffer = g_malloc0((gsize)layout.total);
+
+    SpatialGrid geometry = {
+        .lat_grid_size = SEP_GRID_SIZE, .lon_grid_size = SEP_GRID_SIZE,
+        .min_lat = header->min_lat, .max_lat = header->max_lat,
+        .min_lon = header->min_lon, .max_lon = header->max_lon,
+        .lat_resolution = header->grid_lat_resolution, .lon_resolution = header->grid_lon_resolution
+    };
+
+    int n = points->count;
+    int cells = SEP_GRID_SIZE * SEP_GRID_SIZE;
+    gint32 *cell_start = (gint32 *)(buffer + layout.cell_start);
+    double *store_longitudes = (double *)(buffer + layout.points);
+
+    // 計數排序依點範圍平行：各段分別統計每個 cell 的點數，依（cell, 段）順序累加出各段在每個 cell 的起始位置，
+    // 每段再把自己的點放到各自的位置；cell 內的順序與逐點處理時相同（載入順序）
+    SepGridBuildJob job = {
+        .points = points, .geometry = &geometry,
+        .part_count = sep_load_thread_count(n, SEP_INDEX_MIN_POINTS), .cells = cells,
+        .position = g_new(gint32, MAX(n, 1)),
+        .store_longitudes = store_longitudes,
+        .store_latitudes = store_longitudes + n,
+        .store_adjustments = store_longitudes + 2 * (gsize)n
+    };
+    job.cursors = g_new0(gint32, (gsize)job.part_count * cells);
+
+    sep_parallel_run(job.part_count, sep_grid_count_part, &job);
+    gint32 running = 0;
+    for (int c = 0; c < cells; c++) {
+        cell_start[c] = running;
+        for (int part = 0; part < job.part_count; part++) {
+            gint32 *cursor = &job.cursors[(gsize)part * cells + c];
+            gint32 count = *cursor;
+            *cursor = running;
+            running += count;
+        }
+    }
+    cell_start[cells] = running;
+    sep_parallel_run(job.part_count, sep_grid_scatter_part, &job);
+
+    gint32 *position = job.position;
+    double *store_latitudes = job.store_latitudes;
+    double *store_adjustments = job.store_adjustments;
+    g_free(job.cursors);
+
+    // 依載入順序插入，重複座標時後出現的點覆蓋先前的點
+    SepHashTable table = {
+        .slots = (guint32 *)(buffer + layout.hash_slots), .capacity = header->hash_capacity, .count = 0,
+        .longitudes = store_longitudes, .latitudes = store_latitudes, .adjustments = store_adjustments
+    };
+    for (guint32 i = 0; i < table.capacity; i++) {
+        table.slots[i] = SEP_HASH_EMPTY;
+    }
+    for (int k = 0; k < n; k++) {
+        sep_hash_insert(&table, (guint32)position[k]);
+    }
+    header->hash_count = table.count;
+    g_free(position);
+
+    *temp_bytes = sizeof(gint32) * ((gsize)MAX(n, 1) + (gsize)job.part_count * cells);
+    memcpy(buffer, header, sizeof(*header));
+    *length = (gsize)layout.total;
+    return buffer;
+}
+
+// 由解析後的SEP點建立模型資料：符合規則格網時使用密集陣列，否則建立空間網格
+// peak_bytes 回傳建立過程的尖峰記憶體估計值（解析陣列 + 偵測或建立時的暫存 + 模型資料）
+static gchar* sep_model_build(const SepPointArray *points, const SepModelHeader *source, gsize *length,
+                              gsize *peak_bytes) {
+    SepModelHeader header = *source;
+    memcpy(header.magic, SEP_MODEL_MAGIC, sizeof(header.magic));
+    header.version = SEP_MODEL_VERSION;
+    header.point_count = points->count;
+
+    header.min_lon = header.min_lat = G_MAXDOUBLE;
+    header.max_lon = header.max_lat = -G_MAXDOUBLE;
+    for (int k = 0; k < points->count; k++) {
+        header.min_lon = MIN(header.min_lon, points->longitudes[k]);
+        header.max_lon = MAX(header.max_lon, points->longitudes[k]);
+        header.min_lat = MIN(header.min_lat, points->latitudes[k]);
+        header.max_lat = MAX(header.max_lat, points->latitudes[k]);
+    }
+    if (points->count == 0) {
+        header.min_lon = header.max_lon = header.min_lat = header.max_lat = 0.0;
+    }
+
+    gsize parsed_bytes = 3 * sizeof(double) * (gsize)points->capacity;
+    gsize fit_bytes = 2 * sizeof(double) * (gsize)points->count;
+    *peak_bytes = parsed_bytes + fit_bytes;
+
+    SepLattice geometry;
+    if (sep_lattice_fit(points, &geometry)) {
+        header.index_kind = SEP_INDEX_LATTICE;
+        header.lattice_nx = geometry.nx;
+        header.lattice_ny = geometry.ny;
+        header.lattice_origin_lon = geometry.origin_lon;
+        header.lattice_origin_lat = geometry.origin_lat;
+        header.lattice_step_lon = geometry.step_lon;
+        header.lattice_step_lat = geometry.step_lat;
+
+        gchar *buffer = sep_model_build_lattice(points, &header, length);
+        if (buffer) {
+            *peak_bytes = MAX(*peak_bytes, parsed_bytes + *length);
+            return buffer;
+        }
+
+        header.lattice_nx = header.lattice_ny = 0;
+    }
+
+    gsize temp_bytes = 0;
+    header.index_kind = SEP_INDEX_GENERAL;
+    gchar *buffer = sep_model_build_grid(points, &header, length, &temp_bytes);
+    *peak_bytes = MAX(*peak_bytes, parsed_bytes + *length + temp_bytes);
+    return buffer;
+}
+
+// 檢查模型資料的標頭與長度，通過時把標頭複製到 header
+static gboolean sep_model_check(const gchar *contents, gsize length, SepModelHeader *header) {
+    if (!contents || length < sizeof(*header)) return FALSE;
+    memcpy(header, contents, sizeof(*header));
+
+    if (memcmp(header->magic, SEP_MODEL_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != SEP_MODEL_VERSION ||
+        header->point_count < 0 || header->point_count > G_MAXINT) {
+        return FALSE;
+    }
+    if (header->index_kind == SEP_INDEX_LATTICE) {
+        if (header->lattice_nx < 2 || header->lattice_ny < 2 ||
+            (double)header->lattice_nx * header->lattice_ny > SEP_LATTICE_MAX_NODES) {
+            return FALSE;
+        }
+    } else if (header->index_kind != SEP_INDEX_GENERAL ||
+               header->grid_lat_size != SEP_GRID_SIZE || header->grid_lon_size != SEP_GRID_SIZE ||
+               header->hash_capacity < SEP_HASH_MIN_CAPACITY ||
+               (header->hash_capacity & (header->hash_capacity - 1)) != 0 ||
+               header->hash_count >= header->hash_capacity) {
+        return FALSE;
+    }
+
+    SepModelLayout layout;
+    sep_model_layout(header, &layout);
+    return layout.total == (guint64)length;
+}
+
+// 將資料結構指向已通過 sep_model_check 的模型資料（不會失敗）
+static void sep_model_bind(SepDataStructure *data, const gchar *contents, gsize length,
+                           const SepModelHeader *source_header) {
+    SepModelHeader header = *source_header;
+    SepModelLayout layout;
+    sep_model_layout(&header, &layout);
+
+    int n = (int)header.point_count;
+    data->point_count = n;
+    data->model_bytes = length;
+    data->min_lon = header.min_lon;
+    data->max_lon = header.max_lon;
+    data->min_lat = header.min_lat;
+    data->max_lat = header.max_lat;
+
+    if (header.index_kind == SEP_INDEX_LATTICE) {
+        SepLattice *lattice = g_new0(SepLattice, 1);
+        lattice->nx = header.lattice_nx;
+        lattice->ny = header.lattice_ny;
+        lattice->origin_lon = header.lattice_origin_lon;
+        lattice->origin_lat = header.lattice_origin_lat;
+        lattice->step_lon = header.lattice_step_lon;
+        lattice->step_lat = header.lattice_step_lat;
+        lattice->min_cos_lat = header.lattice_min_cos_lat;
+        lattice->node_longitudes = (const double *)(contents + layout.node_longitudes);
+        lattice->node_latitudes = (const double *)(contents + layout.node_latitudes);
+        lattice->values = (const double *)(contents + layout.values);
+        lattice->point_nodes = (const gint32 *)(contents + layout.point_nodes);
+        data->lattice = lattice;
+        return;
+    }
+
+    data->longitudes = (const double *)(contents + layout.points);
+    data->latitudes = data->longitudes + n;
+    data->adjustments = data->latitudes + n;
+
+    SpatialGrid *grid = g_new0(SpatialGrid, 1);
+    grid->lat_grid_size = header.grid_lat_size;
+    grid->lon_grid_size = header.grid_lon_size;
+    grid->min_lat = header.min_lat;
+    grid->max_lat = header.max_lat;
+    grid->min_lon = header.min_lon;
+    grid->max_lon = header.max_lon;
+    grid->lat_resolution = header.grid_lat_resolution;
+    grid->lon_resolution = header.grid_lon_resolution;
+    grid->cell_start = (const gint32 *)(contents + layout.cell_start);
+    grid->longitudes = data->longitudes;
+    grid->latitudes = data->latitudes;
+    grid->adjustments = data->adjustments;
+    grid->min_cos_lat = MIN(cos(header.min_lat * G_PI / 180.0), cos(header.max_lat * G_PI / 180.0));
+    data->spatial_grid = grid;
+
+    // 精確匹配表直接使用模型資料中的槽陣列（只讀取，不插入）
+    SepHashTable *table = g_new0(SepHashTable, 1);
+    table->slots = (guint32 *)(contents + layout.hash_slots);
+    table->capacity = header.hash_capacity;
+    table->count = header.hash_count;
+    table->longitudes = data->longitudes;
+    table->latitudes = data->latitudes;
+    table->adjustments = data->adjustments;
+    data->hash_table = table;
+}
+
+// 將資料結構指向模型資料；標頭或長度不符時回傳 FALSE
+static gboolean sep_model_attach(SepDataStructure *data, const gchar *contents, gsize length) {
+    SepModelHeader header;
+    if (!sep_model_check(contents, length, &header)) return FALSE;
+
+    sep_model_bind(data, contents, length, &header);
+    return TRUE;
+}
+
+// 以 FNV-1a 累加檔案接下來的 length 位元組
+static gboolean fnv1a_update(FILE *file, gint64 length, guint64 *hash) {
+    guchar buffer[65536];
+
+    while (length > 0) {
+        size_t want = (size_t)MIN(length, (gint64)sizeof(buffer));
+        if (fread(buffer, 1, want, file) != want) return FALSE;
+
+        for (size_t i = 0; i < want; i++) {
+            *hash ^= buffer[i];
+            *hash *= G_GUINT64_CONSTANT(1099511628211);
+        }
+        length -= (gint64)want;
+    }
+    return TRUE;
+}
+
+// 取得來源SEP檔案的大小、修改時間與取樣雜湊（開頭與結尾各 1 MiB，小檔案即整個檔案）
+static gboolean sep_source_info(const char *sep_path, SepModelHeader *source) {
+    GStatBuf st;
+    if (g_stat(sep_path, &st) != 0) return FALSE;
+
+    source->source_size = (gint64)st.st_size;
+    source->source_mtime = (gint64)st.st_mtime;
+
+    FILE *file = fopen(sep_path, "rb");
+    if (!file) return FALSE;
+
+    gint64 head = MIN(source->source_size, SEP_MODEL_HASH_SAMPLE);
+    gint64 tail = MIN(SEP_MODEL_HASH_SAMPLE, source->source_size - head);
+    guint64 hash = G_GUINT64_CONSTANT(14695981039346656037);
+
+    gboolean ok = fnv1a_update(file, head, &hash);
+    if (ok && tail > 0) {
+        ok = fseek(file, -(long)tail, SEEK_END) == 0 && fnv1a_update(file, tail, &hash);
+    }
+    fclose(file);
+
+    source->source_hash = hash;
+    return ok;
+}
+
+// 快取標頭記錄的來源檔案資訊是否與目前的SEP檔案一致
+static gboolean sep_model_matches_source(const gchar *contents, gsize length, const SepModelHeader *source) {
+    SepModelHeader header;
+    if (!contents || length < sizeof(header)) return FALSE;
+    memcpy(&header, contents, sizeof(header));
+
+    return header.source_size == source->source_size &&
+           header.source_mtime == source->source_mtime &&
+           header.source_hash == source->source_hash;
+}
+
+// 解析SEP文字檔的一行（或超長行的一段），格式正確時加入點陣列
+static void sep_parse_line(char *line, SepPointArray *points) {
+    // 移除注释和空白
+    char *comment_pos = strchr(line, ';');
+    if (comment_pos) *comment_pos = '\0';
+
+    // 将制表符和多个空格转换为单个空格
+    char *ptr = line;
+    while (*ptr) {
+        if (*ptr == '\t') *ptr = ' ';
+        ptr++;
+    }
+
+    // 跳过空行
+    g_strstrip(line);
+    if (strlen(line) == 0) return;
+
+    // 解析经纬度和调整值
+    double longitude, latitude, adjustment;
+    if (sscanf(line, "%lf %lf %lf", &longitude, &latitude, &adjustment) == 3) {
+        sep_point_array_add(points, longitude, latitude, adjustment);
+    }
+    // 忽略格式錯誤的行
+}
+
+// 平行解析的工作：chunk_start[i] 到 chunk_start[i + 1] 為第 i 個區塊，區塊邊界都在換行之後
+typedef struct {
+    const char *text;
+    gsize *chunk_start;         // [chunk_count + 1]
+    SepPointArray **chunk_points; // 各區塊的解析結果（執行緒各自持有）
+} SepParseJob;
+
+// 解析一個區塊：與 fgets(line, 512, ...) 相同，讀到換行或緩衝區滿為止切成一段
+static void sep_parse_chunk(int part, gpointer user_data) {
+    SepParseJob *job = (SepParseJob *)user_data;
+    const char *p = job->text + job->chunk_start[part];
+    const char *end = job->text + job->chunk_start[part + 1];
+    SepPointArray *points = sep_point_array_init(1024); // 預估容量
+    char line[SEP_LINE_BUFFER];
+
+    while (p < end) {
+        gsize limit = MIN((gsize)(end - p), sizeof(line) - 1);
+        const char *newline = memchr(p, '\n', limit);
+        gsize length = newline ? (gsize)(newline - p) + 1 : limit;
+
+        memcpy(line, p, length);
+        line[length] = '\0';
+        p += length;
+        sep_parse_line(line, points);
+    }
+    job->chunk_points[part] = points;
+}
+
+// 解析SEP文字檔為點陣列，檔案無法開啟時回傳 NULL
+// 檔案以唯讀映射讀取，依行界切成區塊平行解析，再依區塊順序串接，點的順序與逐行解析相同。
+// thread_count 回傳使用的執行緒數，peak_bytes 回傳解析過程的尖峰記憶體估計值（各區塊陣列 + 串接結果）
+static SepPointArray* sep_parse_text_file(const char *sep_path, int *thread_count, gsize *peak_bytes) {
+    GMappedFile *mapped = g_mapped_file_new(sep_path, FALSE, NULL);
+    if (!mapped) {
+        return NULL;
+    }
+    const char *text = g_mapped_file_get_contents(mapped);
+    gsize length = text ? g_mapped_file_get_length(mapped) : 0;
+
+    // 1. 切出區塊：均分後把每個邊界移到下一個換行之後
+    int chunk_count = sep_load_thread_count((gint64)length, SEP_PARSE_MIN_CHUNK);
+    SepParseJob job = { text, g_new(gsize, chunk_count + 1), g_new0(SepPointArray *, chunk_count) };
+    job.chunk_start[0] = 0;
+    for (int i = 1; i < chunk_count; i++) {
+        gsize start = MAX(length / chunk_count * i, job.chunk_start[i - 1]);
+        const char *newline = start < length ? memchr(text + start, '\n', length - start) : NULL;
+        job.chunk_start[i] = newline ? (gsize)(newline - text) + 1 : length;
+    }
+    job.chunk_start[chunk_count] = length;
+
+    // 2. 平行解析，各區塊寫入自己的點陣列
+    sep_parallel_run(chunk_count, sep_parse_chunk, &job);
+
+    // 3. 依區塊順序串接
+    int total = 0;
+    gsize chunk_bytes = 0;
+    for (int i = 0; i < chunk_count; i++) {
+        total += job.chunk_points[i]->count;
+        chunk_bytes += 3 * sizeof(double) * (gsize)job.chunk_points[i]->capacity;
+    }
+    SepPointArray *points = sep_point_array_init(MAX(total, 1));
+    for (int i = 0; i < chunk_count; i++) {
+        const SepPointArray *chunk = job.chunk_points[i];
+        memcpy(points->longitudes + points->count, chunk->longitudes, sizeof(double) * (gsize)chunk->count);
+        memcpy(points->latitudes + points->count, chunk->latitudes, sizeof(double) * (gsize)chunk->count);
+        memcpy(points->adjustments + points->count, chunk->adjustments, sizeof(double) * (gsize)chunk->count);
+        points->count += chunk->count;
+        sep_point_array_free(job.chunk_points[i]);
+    }
+
+    g_free(job.chunk_points);
+    g_free(job.chunk_start);
+    g_mapped_file_unref(mapped);
+
+    *thread_count = chunk_count;
+    *peak_bytes = chunk_bytes + 3 * sizeof(double) * (gsize)points->capacity;
+    return points;
+}
+
+// 載入SEP文件到複合結構：優先映射與來源一致的二進位快取，否則解析文字檔並寫出快取
+SepDataStructure* load_sep_file_optimized(const char *sep_path) {
+    gint64 start_time = g_get_monotonic_time();
+
+    SepModelHeader source;
+    memset(&source, 0, sizeof(source));
+    if (!sep_source_info(sep_path, &source)) {
+        return NULL;
+    }
+
+    SepDataStructure *data = sep_data_init();
+    data->cache_path = g_strdup_printf("%s.sepbin", sep_path);
+
+    // 1. 二進位快取：大小、修改時間與取樣雜湊皆一致時直接唯讀映射
+    GMappedFile *mapped = g_mapped_file_new(data->cache_path, FALSE, NULL);
+    if (mapped) {
+        const gchar *contents = g_mapped_file_get_contents(mapped);
+        gsize length = g_mapped_file_get_length(mapped);
+        if (sep_model_matches_source(contents, length, &source) && sep_model_attach(data, contents, length)) {
+            data->mapped = mapped;
+            data->from_cache = TRUE;
+            data->peak_bytes = length;
+            data->load_milliseconds = (g_get_monotonic_time() - start_time) / 1000.0;
+            return data;
+        }
+        g_mapped_file_unref(mapped);
+    }
+
+    // 2. 解析文字檔並建立模型
+    gsize parse_peak = 0;
+    SepPointArray *points = sep_parse_text_file(sep_path, &data->load_threads, &parse_peak);
+    if (!points) {
+        sep_data_free(data);
+        return NULL;
+    }
+
+    gsize length = 0;
+    data->owned_buffer = sep_model_build(points, &source, &length, &data->peak_bytes);
+    data->peak_bytes = MAX(data->peak_bytes, parse_peak);
+    sep_point_array_free(points);
+    if (!sep_model_attach(data, data->owned_buffer, length)) {
+        sep_data_free(data);
+        return NULL;
+    }
+
+    // 3. 寫出快取供下次使用（g_file_set_contents 以暫存檔加 rename 寫入；失敗不影響本次轉換）
+    data->cache_written = g_file_set_contents(data->cache_path, data->owned_buffer, (gssize)length, NULL);
+    data->load_milliseconds = (g_get_monotonic_time() - start_time) / 1000.0;
+    return data;
+}
+
+// ===========================================
+// 分塊模型：SEP範圍切成固定大小的分塊，每個分塊各是一份完整的二進位模型
+// （分塊內的點加上周圍鄰域內的點），查詢落入某個分塊時才建立該分塊的索引
+// ===========================================
+
+#define SEP_TILES_MAGIC "SEPTILES"
+#define SEP_TILES_VERSION 2
+#define SEP_TILES_HALO_FRACTION 0.25            // 鄰域寬度（相對於分塊大小）
+#define SEP_TILES_MAX_CELLS (4 * 1024 * 1024)   // 分塊格數上限，超過時加大分塊
+
+// 分塊檔標頭（所有欄位皆為 8 位元組對齊，直接以記憶體格式寫出）
+typedef struct {
+    char magic[8];              // SEP_TILES_MAGIC
+    guint32 version;            // SEP_TILES_VERSION
+    guint32 reserved;
+    gint64 source_size;         // 來源SEP文字檔大小
+    gint64 source_mtime;        // 來源SEP文字檔修改時間
+    guint64 source_hash;        // 來源SEP文字檔取樣雜湊
+    gint64 point_count;         // 全部SEP點數（鄰域重複的點不重複計入）
+    double min_lon, max_lon, min_lat, max_lat;
+    double requested_tile_size; // 建立時要求的分塊大小（度）
+    double tile_size;           // 實際分塊大小（分塊格數過多時加大）
+    double halo;                // 鄰域寬度（度）
+    gint32 tiles_x, tiles_y;    // 經度、緯度方向的分塊格數
+    gint32 tile_count;          // 有點的分塊數（目錄項目數）
+    gint32 reserved2;
+} SepTilesHeader;
+
+// 分塊目錄項目
+typedef struct {
+    gint32 tx, ty;              // 分塊格位置
+    gint64 point_count;         // 分塊內（不含鄰域）的點數
+    guint64 offset;             // 分塊模型資料在檔案中的位移（8 位元組對齊）
+    guint64 length;             // 分塊模型資料長度
+} SepTileEntry;
+
+// 分塊檔配置：標頭、目錄 SepTileEntry[tile_count]、格位對照 gint32[tiles_x * tiles_y]，之後為各分塊的模型資料。
+// 格位對照記錄每個分塊格查詢時使用的目錄項目：有點的格位是自己，空格位是最近的有點分塊
+struct SepTileSet {
+    SepTilesHeader header;
+    const gchar *contents;      // 分塊檔的唯讀映射
+    const SepTileEntry *directory;
+    const gint32 *cell_tiles;
+    SepDataStructure **models;  // [tile_count]，尚未載入為 NULL；載入後直到釋放都不會改變
+    guint64 tiles_bytes;        // 全部分塊模型資料的大小
+    GMutex mutex;               // 載入分塊時持有
+    int loaded_count;           // 已載入的分塊數（持有鎖時更新）
+    gsize loaded_bytes;
+    gboolean built;             // 本次由文字檔建立分塊檔
+    double min_cos_lat;         // 全部點緯度範圍內 cos(緯度) 的最小值，供距離下界使用
+};
+
+static void sep_tile_set_free(struct SepTileSet *tiles) {
+    if (!tiles) return;
+
+    for (int t = 0; t < tiles->header.tile_count; t++) {
+        sep_data_free(tiles->models[t]);
+    }
+    g_free(tiles->models);
+    g_mutex_clear(&tiles->mutex);
+    g_free(tiles);
+}
+
+static guint64 sep_tiles_cells_offset(const SepTilesHeader *header) {
+    return sizeof(SepTilesHeader) + (guint64)header->tile_count * sizeof(SepTileEntry);
+}
+
+static guint64 sep_tiles_data_offset(const SepTilesHeader *header) {
+    guint64 cells = (guint64)header->tiles_x * header->tiles_y;
+    return align8(sep_tiles_cells_offset(header) + cells * sizeof(gint32));
+}
+
+// 座標所在的分塊格（範圍外的座標夾擠到邊緣的分塊格）
+static void sep_tiles_cell_of(const SepTilesHeader *header, double longitude, double latitude, int *tx, int *ty) {
+    double fx = floor((longitude - header->min_lon) / header->tile_size);
+    double fy = floor((latitude - header->min_lat) / header->tile_size);
+
+    // 先以浮點數夾擠，避免極端值或 NAN 轉成整數時溢位
+    *tx = fx >= 0.0 ? (int)MIN(fx, (double)(header->tiles_x - 1)) : 0;
+    *ty = fy >= 0.0 ? (int)MIN(fy, (double)(header->tiles_y - 1)) : 0;
+}
+
+static int compare_gint32(const void *a, const void *b) {
+    gint32 va = *(const gint32 *)a, vb = *(const gint32 *)b;
+    return va < vb ? -1 : (va > vb ? 1 : 0);
+}
+
+// 每個空格位以 8 鄰接的廣度優先搜尋找出最近的有點分塊（有點的格位已填入自己的目錄索引，其餘為 -1）
+static void sep_tiles_fill_empty_cells(gint32 *cell_tiles, int tiles_x, int tiles_y) {
+    int cells = tiles_x * tiles_y;
+    gint32 *queue = g_new(gint32, cells);
+    int head = 0, tail = 0;
+
+    for (int c = 0; c < cells; c++) {
+        if (cell_tiles[c] >= 0) queue[tail++] = c;
+    }
+    while (head < tail) {
+        int c = queue[head++];
+        int cx = c % tiles_x, cy = c / tiles_x;
+        for (int dy = -1; dy <= 1; dy++) {
+            for (int dx = -1; dx <= 1; dx++) {
+                int nx = cx + dx, ny = cy + dy;
+                if (nx < 0 || ny < 0 || nx >= tiles_x || ny >= tiles_y) continue;
+                if (cell_tiles[ny * tiles_x + nx] >= 0) continue;
+                cell_tiles[ny * tiles_x + nx] = cell_tiles[c];
+                queue[tail++] = ny * tiles_x + nx;
+            }
+        }
+    }
+    g_free(queue);
+}
+
+// 寫出 length 位元組並累計檔案位置
+static gboolean sep_tiles_write(FILE *file, const void *buffer, gsize length, guint64 *position) {
+    if (length > 0 && fwrite(buffer, 1, length, file) != length) return FALSE;
+    *position += length;
+    return TRUE;
+}
+
+// 補零到 8 位元組對齊
+static gboolean sep_tiles_pad(FILE *file, guint64 *position) {
+    static const gchar zeros[8] = { 0 };
+    return sep_tiles_write(file, zeros, (gsize)(align8(*position) - *position), position);
+}
+
+// 由解析後的SEP點建立分塊檔：逐個分塊建立模型並直接寫出，同時間只有一個分塊的模型資料在記憶體中。
+// 先寫到暫存檔，完成後才 rename 成正式檔名；peak_bytes 回傳建立過程的尖峰記憶體估計值
+static gboolean sep_tiles_build_file(const char *tiles_path, const SepPointArray *points,
+                                     const SepModelHeader *source, double tile_size, gsize *peak_bytes) {
+    int n = points->count;
+    if (n <= 0) return FALSE;
+
+    SepTilesHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SEP_TILES_MAGIC, sizeof(header.magic));
+    header.version = SEP_TILES_VERSION;
+    header.source_size = source->source_size;
+    header.source_mtime = source->source_mtime;
+    header.source_hash = source->source_hash;
+    header.point_count = n;
+    header.requested_tile_size = tile_size;
+
+    header.min_lon = header.min_lat = G_MAXDOUBLE;
+    header.max_lon = header.max_lat = -G_MAXDOUBLE;
+    for (int k = 0; k < n; k++) {
+        header.min_lon = MIN(header.min_lon, points->longitudes[k]);
+        header.max_lon = MAX(header.max_lon, points->longitudes[k]);
+        header.min_lat = MIN(header.min_lat, points->latitudes[k]);
+        header.max_lat = MAX(header.max_lat, points->latitudes[k]);
+    }
+
+    // 分塊格數過多時加大分塊，格位對照表的大小因此有上限
+    double tiles_x, tiles_y;
+    for (;;) {
+        tiles_x = floor((header.max_lon - header.min_lon) / tile_size) + 1.0;
+        tiles_y = floor((header.max_lat - header.min_lat) / tile_size) + 1.0;
+        if (tiles_x * tiles_y <= SEP_TILES_MAX_CELLS) break;
+        tile_size *= 2.0;
+    }
+    header.tile_size = tile_size;
+    header.halo = tile_size * SEP_TILES_HALO_FRACTION;
+    header.tiles_x = (gint32)tiles_x;
+    header.tiles_y = (gint32)tiles_y;
+
+    // 1. 以計數排序將點依分塊格排列（分塊格內維持載入順序）
+    int cells = header.tiles_x * header.tiles_y;
+    gint32 *cell_start = g_new0(gint32, cells + 1);
+    gint32 *point_cells = g_new(gint32, n);
+    for (int k = 0; k < n; k++) {
+        int tx, ty;
+        sep_tiles_cell_of(&header, points->longitudes[k], points->latitudes[k], &tx, &ty);
+        point_cells[k] = ty * header.tiles_x + tx;
+        cell_start[point_cells[k] + 1]++;
+    }
+    for (int c = 0; c < cells; c++) {
+        cell_start[c + 1] += cell_start[c];
+    }
+    gint32 *order = g_new(gint32, n);
+    gint32 *cursor = g_new(gint32, cells);
+    memcpy(cursor, cell_start, sizeof(gint32) * cells);
+    for (int k = 0; k < n; k++) {
+        order[cursor[point_cells[k]]++] = k;
+    }
+    g_free(cursor);
+    g_free(point_cells);
+
+    // 2. 目錄依列優先順序列出有點的分塊格，空格位對照到最近的分塊
+    gint32 *cell_tiles = g_new(gint32, cells);
+    for (int c = 0; c < cells; c++) {
+        cell_tiles[c] = cell_start[c + 1] > cell_start[c] ? header.tile_count++ : -1;
+    }
+    sep_tiles_fill_empty_cells(cell_tiles, header.tiles_x, header.tiles_y);
+    SepTileEntry *directory = g_new0(SepTileEntry, header.tile_count);
+
+    gsize index_bytes = sizeof(gint32) * ((gsize)cells * 2 + 1 + n) + sizeof(SepTileEntry) * header.tile_count;
+    *peak_bytes = 3 * sizeof(double) * (gsize)points->capacity + index_bytes;
+
+    char *temp_path = g_strdup_printf("%s.tmp", tiles_path);
+    FILE *file = g_fopen(temp_path, "wb");
+    guint64 position = 0;
+    gboolean ok = file != NULL;
+
+    // 3. 標頭與目錄先佔位，分塊寫完後再回頭填入位移
+    ok = ok && sep_tiles_write(file, &header, sizeof(header), &position);
+    ok = ok && sep_tiles_write(file, directory, sizeof(SepTileEntry) * header.tile_count, &position);
+    ok = ok && sep_tiles_write(file, cell_tiles, sizeof(gint32) * cells, &position);
+    ok = ok && sep_tiles_pad(file, &position);
+
+    // 4. 每個分塊收集分塊內與鄰域內的點（依載入順序，重複座標的覆蓋規則與完整模型相同）並建立模型
+    int rings = (int)ceil(header.halo / header.tile_size);
+    int gathered_capacity = 1024;
+    gint32 *gathered = g_new(gint32, gathered_capacity);
+    int t = 0;
+    for (int c = 0; ok && c < cells; c++) {
+        if (cell_start[c + 1] == cell_start[c]) continue;
+
+        int tx = c % header.tiles_x, ty = c / header.tiles_x;
+        double west = header.min_lon + tx * header.tile_size - header.halo;
+        double east = header.min_lon + (tx + 1) * header.tile_size + header.halo;
+        double south = header.min_lat + ty * header.tile_size - header.halo;
+        double north = header.min_lat + (ty + 1) * header.tile_size + header.halo;
+
+        int gathered_count = 0;
+        for (int ny = MAX(0, ty - rings); ny <= MIN(header.tiles_y - 1, ty + rings); ny++) {
+            for (int nx = MAX(0, tx - rings); nx <= MIN(header.tiles_x - 1, tx + rings); nx++) {
+                int nc = ny * header.tiles_x + nx;
+                for (gint32 s = cell_start[nc]; s < cell_start[nc + 1]; s++) {
+                    int k = order[s];
+                    if (nc != c && (points->longitudes[k] < west || points->longitudes[k] > east ||
+                                    points->latitudes[k] < south || points->latitudes[k] > north)) {
+                        continue;
+                    }
+                    if (gathered_count >= gathered_capacity) {
+                        gathered_capacity *= 2;
+                        gathered = g_renew(gint32, gathered, gathered_capacity);
+                    }
+                    gathered[gathered_count++] = k;
+                }
+            }
+        }
+        qsort(gathered, gathered_count, sizeof(gint32), compare_gint32);
+
+        SepPointArray *subset = sep_point_array_init(gathered_count);
+        for (int g = 0; g < gathered_count; g++) {
+            int k = gathered[g];
+            sep_point_array_add(subset, points->longitudes[k], points->latitudes[k], points->adjustments[k]);
+        }
+
+        gsize length = 0, tile_peak = 0;
+        gchar *buffer = sep_model_build(subset, source, &length, &tile_peak);
+        sep_point_array_free(subset);
+        *peak_bytes = MAX(*peak_bytes, 3 * sizeof(double) * (gsize)points->capacity + index_bytes + tile_peak);
+
+        directory[t].tx = tx;
+        directory[t].ty = ty;
+        directory[t].point_count = cell_start[c + 1] - cell_start[c];
+        directory[t].offset = position;
+        directory[t].length = length;
+        ok = sep_tiles_write(file, buffer, length, &position) && sep_tiles_pad(file, &position);
+        g_free(buffer);
+        t++;
+    }
+    g_free(gathered);
+
+    ok = ok && fseek(file, 0, SEEK_SET) == 0;
+    position = 0;
+    ok = ok && sep_tiles_write(file, &header, sizeof(header), &position);
+    ok = ok && sep_tiles_write(file, directory, sizeof(SepTileEntry) * header.tile_count, &position);
+    if (file) {
+        ok = (fclose(file) == 0) && ok;
+    }
+    ok = ok && g_rename(temp_path, tiles_path) == 0;
+    if (!ok && file) {
+        g_unlink(temp_path);
+    }
+
+    g_free(temp_path);
+    g_free(directory);
+    g_free(cell_tiles);
+    g_free(order);
+    g_free(cell_start);
+    return ok;
+}
+
+// 檢查分塊檔並建立分塊集合（只讀取標頭、目錄、格位對照與各分塊模型的標頭）；
+// 與來源或要求的分塊大小不符，或任一分塊的模型資料損壞時回傳 NULL，由呼叫端重新建立分塊檔
+static struct SepTileSet* sep_tiles_open(const gchar *contents, gsize length, const SepModelHeader *source,
+                                         double tile_size) {
+    SepTilesHeader header;
+    if (!contents || length < sizeof(header)) return NULL;
+    memcpy(&header, contents, sizeof(header));
+
+    if (memcmp(header.magic, SEP_TILES_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SEP_TILES_VERSION ||
+        header.source_size != source->source_size ||
+        header.source_mtime != source->source_mtime ||
+        header.source_hash != source->source_hash ||
+        header.requested_tile_size != tile_size ||
+        !(header.tile_size > 0.0) ||
+        header.tiles_x <= 0 || header.tiles_y <= 0 ||
+        (double)header.tiles_x * header.tiles_y > SEP_TILES_MAX_CELLS ||
+        header.tile_count <= 0 || header.tile_count > header.tiles_x * header.tiles_y ||
+        header.point_count <= 0 || header.point_count > G_MAXINT) {
+        return NULL;
+    }
+
+    guint64 data_offset = sep_tiles_data_offset(&header);
+    if (data_offset > (guint64)length) return NULL;
+
+    const SepTileEntry *directory = (const SepTileEntry *)(contents + sizeof(SepTilesHeader));
+    guint64 tiles_bytes = 0;
+    for (int t = 0; t < header.tile_count; t++) {
+        const SepTileEntry *entry = &directory[t];
+        SepModelHeader tile_header;
+        if (entry->offset < data_offset || entry->offset % 8 != 0 ||
+            entry->length > (guint64)length || entry->offset > (guint64)length - entry->length ||
+            !sep_model_check(contents + entry->offset, (gsize)entry->length, &tile_header)) {
+            return NULL;
+        }
+        tiles_bytes += entry->length;
+    }
+
+    const gint32 *cell_tiles = (const gint32 *)(contents + sep_tiles_cells_offset(&header));
+    for (gint32 c = 0; c < header.tiles_x * header.tiles_y; c++) {
+        if (cell_tiles[c] < 0 || cell_tiles[c] >= header.tile_count) return NULL;
+    }
+
+    struct SepTileSet *tiles = g_new0(struct SepTileSet, 1);
+    tiles->header = header;
+    tiles->contents = contents;
+    tiles->directory = directory;
+    tiles->cell_tiles = cell_tiles;
+    tiles->models = g_new0(SepDataStructure *, header.tile_count);
+    tiles->tiles_bytes = tiles_bytes;
+    tiles->min_cos_lat = MIN(cos(header.min_lat * G_PI / 180.0), cos(header.max_lat * G_PI / 180.0));
+    g_mutex_init(&tiles->mutex);
+    return tiles;
+}
+
+// 座標查詢時使用的分塊（目錄索引）
+static int sep_tiles_slot_of(const struct SepTileSet *tiles, double longitude, double latitude) {
+    int tx, ty;
+    sep_tiles_cell_of(&tiles->header, longitude, latitude, &tx, &ty);
+    return tiles->cell_tiles[ty * tiles->header.tiles_x + tx];
+}
+
+// 取得分塊的模型，第一次使用時才建立索引（多個工作執行緒可同時呼叫）
+// 各分塊的模型資料已在 sep_tiles_open 檢查過，映射唯讀，這裡只需指向資料，不會失敗
+static const SepDataStructure* sep_tiles_model(struct SepTileSet *tiles, int slot) {
+    SepDataStructure *model = g_atomic_pointer_get(&tiles->models[slot]);
+    if (model) return model;
+
+    g_mutex_lock(&tiles->mutex);
+    model = tiles->models[slot];
+    if (!model) {
+        const SepTileEntry *entry = &tiles->directory[slot];
+        const gchar *contents = tiles->contents + entry->offset;
+        SepModelHeader header;
+        memcpy(&header, contents, sizeof(header));
+        model = sep_data_init();
+        sep_model_bind(model, contents, (gsize)entry->length, &header);
+        tiles->loaded_count++;
+        tiles->loaded_bytes += (gsize)entry->length;
+        g_atomic_pointer_set(&tiles->models[slot], model);
+    }
+    g_mutex_unlock(&tiles->mutex);
+    return model;
+}
+
+// 分塊格 [x0, x1] x [y0, y1] 各邊向外放寬 margin 度的矩形以外的點到目標點的距離下界（公尺）
+// 矩形邊已達全部點的範圍時該方向沒有點，不列入；點所在分塊格的捨入以分塊大小的容差涵蓋
+static double sep_tiles_outside_bound(const struct SepTileSet *tiles, int x0, int x1, int y0, int y1, double margin,
+                                      double longitude, double latitude) {
+    const SepTilesHeader *header = &tiles->header;
+    double tolerance = header->tile_size * 1e-9;
+
+    double lon_gap = DBL_MAX;
+    if (x0 > 0) lon_gap = MIN(lon_gap, longitude - (header->min_lon + x0 * header->tile_size - margin));
+    if (x1 < header->tiles_x - 1) {
+        lon_gap = MIN(lon_gap, header->min_lon + (x1 + 1) * header->tile_size + margin - longitude);
+    }
+    if (lon_gap < DBL_MAX) lon_gap = MAX(0.0, lon_gap - tolerance);
+
+    double lat_gap = DBL_MAX;
+    if (y0 > 0) lat_gap = MIN(lat_gap, latitude - (header->min_lat + y0 * header->tile_size - margin));
+    if (y1 < header->tiles_y - 1) {
+        lat_gap = MIN(lat_gap, header->min_lat + (y1 + 1) * header->tile_size + margin - latitude);
+    }
+    if (lat_gap < DBL_MAX) lat_gap = MAX(0.0, lat_gap - tolerance);
+
+    return gap_distance_bound(lat_gap, lon_gap, latitude, tiles->min_cos_lat);
+}
+
+// 分塊模型中的兩個最近鄰
+static void sep_model_two_nearest(const SepDataStructure *model, double longitude, double latitude,
+                                  Neighbor2 *best0, Neighbor2 *best1) {
+    if (model->lattice) {
+        int ci, cj;
+        lattice_cell_of(model->lattice, longitude, latitude, &ci, &cj);
+        sep_lattice_two_nearest(model->lattice, ci, cj, longitude, latitude, best0, best1, NULL);
+    } else {
+        sep_grid_two_nearest(model->spatial_grid, longitude, latitude, best0, best1);
+    }
+}
+
+// 合併各分塊的近鄰：鄰域內的點同時出現在相鄰分塊，座標相同者視為同一點
+static void sep_tiles_offer_neighbor(Neighbor2 *best0, Neighbor2 *best1, const Neighbor2 *candidate) {
+    if (candidate->distance == DBL_MAX) return;
+    for (int k = 0; k < 2; k++) {
+        const Neighbor2 *best = k == 0 ? best0 : best1;
+        if (best->distance < DBL_MAX &&
+            fabs(best->longitude - candidate->longitude) < 1e-10 &&
+            fabs(best->latitude - candidate->latitude) < 1e-10) {
+            return;
+        }
+    }
+
+    if (candidate->distance < best0->distance) {
+        *best1 = *best0;
+        *best0 = *candidate;
+    } else if (candidate->distance < best1->distance) {
+        *best1 = *candidate;
+    }
+}
+
+// 跨分塊搜尋兩個最近鄰：以查詢所在分塊格為中心逐圈合併有點分塊的兩個最近鄰，
+// 已找到兩點且已掃分塊格以外的距離下界超過第二近鄰時停止，結果與完整模型相同
+static double sep_tiles_search_neighbors(struct SepTileSet *tiles, double longitude, double latitude) {
+    const SepTilesHeader *header = &tiles->header;
+    int cx, cy;
+    sep_tiles_cell_of(header, longitude, latitude, &cx, &cy);
+
+    Neighbor2 best0 = { .distance = DBL_MAX, .adjustment = 0.0 };
+    Neighbor2 best1 = { .distance = DBL_MAX, .adjustment = 0.0 };
+
+    const int max_r = MAX(header->tiles_x, header->tiles_y);
+    for (int r = 0; r < max_r; ++r) {
+        int x0 = MAX(0, cx - r), x1 = MIN(header->tiles_x - 1, cx + r);
+        int y0 = MAX(0, cy - r), y1 = MIN(header->tiles_y - 1, cy + r);
+
+        for (int y = y0; y <= y1; ++y) {
+            // 不在上下兩列時只有左右兩欄屬於第 r 圈
+            int step = (y == cy - r || y == cy + r) ? 1 : MAX(2 * r, 1);
+            for (int x = cx - r; x <= cx + r; x += step) {
+                if (x < 0 || x >= header->tiles_x) continue;
+
+                // 空格位對照到其他分塊，本身沒有點
+                int slot = tiles->cell_tiles[y * header->tiles_x + x];
+                if (tiles->directory[slot].tx != x || tiles->directory[slot].ty != y) continue;
+
+                Neighbor2 near0, near1;
+                sep_model_two_nearest(sep_tiles_model(tiles, slot), longitude, latitude, &near0, &near1);
+                sep_tiles_offer_neighbor(&best0, &best1, &near0);
+                sep_tiles_offer_neighbor(&best0, &best1, &near1);
+            }
+        }
+
+        if (best1.distance < DBL_MAX &&
+            sep_tiles_outside_bound(tiles, x0, x1, y0, y1, 0.0, longitude, latitude) > best1.distance) {
+            break;
+        }
+    }
+
+    return interpolate_two_nearest(best0, best1);
+}
+
+// 分塊模型只含分塊內與鄰域內的點：插值的第二近鄰不比鄰域外的點到查詢點的距離下界更近時，
+// 鄰域外可能有更近的點，改為跨分塊搜尋
+static double sep_tiles_resolve(struct SepTileSet *tiles, int slot, double longitude, double latitude,
+                                double adjustment, SepMatchKind kind, double second_distance) {
+    if (kind != SEP_MATCH_INTERPOLATED) return adjustment;
+
+    const SepTileEntry *entry = &tiles->directory[slot];
+    if (sep_tiles_outside_bound(tiles, entry->tx, entry->tx, entry->ty, entry->ty, tiles->header.halo,
+                                longitude, latitude) > second_distance) {
+        return adjustment;
+    }
+    return sep_tiles_search_neighbors(tiles, longitude, latitude);
+}
+
+static double sep_tiles_lookup(struct SepTileSet *tiles, double longitude, double latitude, SepMatchKind *kind) {
+    int slot = sep_tiles_slot_of(tiles, longitude, latitude);
+    SepMatchKind tile_kind;
+    double second_distance;
+    double adjustment = sep_model_lookup(sep_tiles_model(tiles, slot), longitude, latitude, &tile_kind,
+                                         &second_distance);
+    if (kind) *kind = tile_kind;
+    return sep_tiles_resolve(tiles, slot, longitude, latitude, adjustment, tile_kind, second_distance);
+}
+
+// 依分塊切成連續的子批次交給各分塊的模型；測量資料在時間上連續，同一分塊的查詢通常相鄰
+static void sep_tiles_lookup_batch(struct SepTileSet *tiles, SepLookupContext *ctx,
+                                   const double *longitudes, const double *latitudes, int count,
+                                   double *adjustments, SepMatchKind *kinds) {
+    double *second_distances = g_new(double, count);
+    int start = 0;
+    while (start < count) {
+        int slot = sep_tiles_slot_of(tiles, longitudes[start], latitudes[start]);
+        int end = start + 1;
+        while (end < count && sep_tiles_slot_of(tiles, longitudes[end], latitudes[end]) == slot) {
+            end++;
+        }
+
+        sep_model_lookup_batch(sep_tiles_model(tiles, slot), ctx, longitudes + start, latitudes + start,
+                               end - start, adjustments + start, kinds + start, second_distances + start);
+        for (int q = start; q < end; q++) {
+            adjustments[q] = sep_tiles_resolve(tiles, slot, longitudes[q], latitudes[q],
+                                               adjustments[q], kinds[q], second_distances[q]);
+        }
+        start = end;
+    }
+    g_free(second_distances);
+}
+
+// 載入分塊模型：優先映射與來源一致的分塊檔，否則解析文字檔建立分塊檔後再映射
+SepDataStructure* load_sep_file_tiled(const char *sep_path, double tile_size) {
+    gint64 start_time = g_get_monotonic_time();
+    if (!(tile_size > 0.0)) {
+        tile_size = SEP_TILES_DEFAULT_SIZE;
+    }
+
+    SepModelHeader source;
+    memset(&source, 0, sizeof(source));
+    if (!sep_source_info(sep_path, &source)) {
+        return NULL;
+    }
+
+    SepDataStructure *data = sep_data_init();
+    data->cache_path = g_strdup_printf("%s.septiles", sep_path);
+
+    // 1. 既有的分塊檔：只讀取標頭、目錄與格位對照，分塊本身留待查詢時才使用
+    struct SepTileSet *tiles = NULL;
+    GMappedFile *mapped = g_mapped_file_new(data->cache_path, FALSE, NULL);
+    if (mapped) {
+        tiles = sep_tiles_open(g_mapped_file_get_contents(mapped), g_mapped_file_get_length(mapped),
+                               &source, tile_size);
+        if (!tiles) {
+            g_mapped_file_unref(mapped);   // 先釋放舊映射，Windows 上才能以新檔取代
+            mapped = NULL;
+        }
+    }
+
+    // 2. 解析文字檔並建立分塊檔；無法寫出時回傳 NULL，由呼叫端改用完整模型
+    if (!tiles) {
+        gsize parse_peak = 0;
+        SepPointArray *points = sep_parse_text_file(sep_path, &data->load_threads, &parse_peak);
+        gboolean built = points && sep_tiles_build_file(data->cache_path, points, &source, tile_size,
+                                                        &data->peak_bytes);
+        data->peak_bytes = MAX(data->peak_bytes, parse_peak);
+        sep_point_array_free(points);
+
+        mapped = built ? g_mapped_file_new(data->cache_path, FALSE, NULL) : NULL;
+        if (mapped) {
+            tiles = sep_tiles_open(g_mapped_file_get_contents(mapped), g_mapped_file_get_length(mapped),
+                                   &source, tile_size);
+        }
+        if (!tiles) {
+            if (mapped) g_mapped_file_unref(mapped);
+            sep_data_free(data);
+            return NULL;
+        }
+        tiles->built = TRUE;
+        data->cache_written = TRUE;
+    } else {
+        data->from_cache = TRUE;
+        data->peak_bytes = (gsize)sep_tiles_data_offset(&tiles->header);
+    }
+
+    data->mapped = mapped;
+    data->tiles = tiles;
+    data->point_count = (int)tiles->header.point_count;
+    data->min_lon = tiles->header.min_lon;
+    data->max_lon = tiles->header.max_lon;
+    data->min_lat = tiles->header.min_lat;
+    data->max_lat = tiles->header.max_lat;
+    data->load_milliseconds = (g_get_monotonic_time() - start_time) / 1000.0;
+    return data;
+}
+
+// 附加分塊模型的來源與分塊配置說明到報告
+static void sep_tiles_describe(const SepDataStructure *data, GString *report) {
+    const SepTilesHeader *header = &data->tiles->header;
+
+    if (data->tiles->built) {
+        g_string_append_printf(report, "SEP模型: 解析文字檔並建立分塊檔 %s（%.1f 毫秒，%d 個執行緒解析）\n",
+                               data->cache_path, data->load_milliseconds, data->load_threads);
+    } else {
+        g_string_append_printf(report, "SEP模型: 開啟分塊檔 %s（%.1f 毫秒，只讀取分塊目錄）\n",
+                               data->cache_path, data->load_milliseconds);
+    }
+
+    g_string_append_printf(report, "SEP分塊: %d x %d 格，%d 個有資料的分塊（每塊 %.3f 度，鄰域 %.3f 度），查詢落入分塊時才建立索引\n",
+                           header->tiles_x, header->tiles_y, header->tile_count, header->tile_size, header->halo);
+    if (header->tile_size != header->requested_tile_size) {
+        g_string_append_printf(report, "SEP分塊: 分塊格數過多，分塊大小由 %.3f 度加大為 %.3f 度\n",
+                               header->requested_tile_size, header->tile_size);
+    }
+
+    g_string_append_printf(report, "SEP記憶體: 全部分塊 %.2f MB，%s約 %.2f MB\n",
+                           data->tiles->tiles_bytes / (1024.0 * 1024.0),
+                           data->tiles->built ? "建立分塊檔的尖峰" : "開啟時讀取",
+                           data->peak_bytes / (1024.0 * 1024.0));
+}
+
+// 附加目前已載入的分塊數與大小到報告（非分塊模型時不附加）
+void sep_data_describe_tiles_loaded(const SepDataStructure *data, GString *report) {
+    if (!data || !data->tiles) return;
+
+    struct SepTileSet *tiles = data->tiles;
+    g_mutex_lock(&tiles->mutex);
+    g_string_append_printf(report, "SEP分塊: 已載入 %d / %d 個分塊（%.2f / %.2f MB）\n",
+                           tiles->loaded_count, tiles->header.tile_count,
+                           tiles->loaded_bytes / (1024.0 * 1024.0), tiles->tiles_bytes / (1024.0 * 1024.0));
+    g_mutex_unlock(&tiles->mutex);
+}
+
+// 取得已載入的SEP對照點數量
+int sep_data_point_count(const SepDataStructure *data) {
+    if (!data) return 0;
+    return data->point_count;
+}
+
+// 附加模型來源與索引結構說明到報告
+void sep_data_describe(const SepDataStructure *data, GString *report) {
+    if (data->tiles) {
+        sep_tiles_describe(data, report);
+        return;
+    }
+
+    if (data->from_cache) {
+        g_string_append_printf(report, "SEP模型: 由二進位快取載入 %s（%.1f 毫秒）\n",
+                               data->cache_path, data->load_milliseconds);
+    } else if (data->cache_written) {
+        g_string_append_printf(report, "SEP模型: 解析文字檔並建立二進位快取 %s（%.1f 毫秒，%d 個執行緒）\n",
+                               data->cache_path, data->load_milliseconds, data->load_threads);
+    } else {
+        g_string_append_printf(report, "SEP模型: 解析文字檔（%.1f 毫秒，%d 個執行緒），無法寫入二進位快取 %s\n",
+                               data->load_milliseconds, data->load_threads, data->cache_path);
+    }
+
+    const SepLattice *lattice = data->lattice;
+    if (lattice) {
+        g_string_append_printf(report, "SEP索引: 規則格網 %d x %d（步距 %.9f x %.9f 度，填滿率 %.1f%%），以索引運算直接查詢\n",
+                               lattice->nx, lattice->ny, lattice->step_lon, lattice->step_lat,
+                               sep_data_point_count(data) * 100.0 / ((double)lattice->nx * lattice->ny));
+    } else {
+        g_string_append_printf(report, "SEP索引: 一般索引（精確匹配表 %u / %u 槽 + 空間網格）\n",
+                               data->hash_table->count, data->hash_table->capacity);
+    }
+
+    g_string_append_printf(report, "SEP記憶體: 模型 %.2f MB（每點 %.1f 位元組），載入尖峰約 %.2f MB\n",
+                           data->model_bytes / (1024.0 * 1024.0),
+                           data->point_count > 0 ? (double)data->model_bytes / data->point_count : 0.0,
+                           data->peak_bytes / (1024.0 * 1024.0));
+}
+
+// 取得模型資料大小與載入過程的尖峰記憶體估計值（位元組）
+void sep_data_memory_usage(const SepDataStructure *data, gsize *model_bytes, gsize *peak_bytes) {
+    if (model_bytes && data->tiles) {
+        g_mutex_lock(&data->tiles->mutex);
+        *model_bytes = data->tiles->loaded_bytes;
+        g_mutex_unlock(&data->tiles->mutex);
+    } else if (model_bytes) {
+        *model_bytes = data->model_bytes;
+    }
+    if (peak_bytes) *peak_bytes = data->peak_bytes;
+}
+
+// 取得SEP對照點的經緯度範圍；沒有任何點時回傳 FALSE
+gboolean sep_data_get_bounds(const SepDataStructure *data, double *min_lon, double *max_lon,
+                             double *min_lat, double *max_lat) {
+    if (sep_data_point_count(data) <= 0) return FALSE;
+
+    *min_lon = data->min_lon;
+    *max_lon = data->max_lon;
+    *min_lat = data->min_lat;
+    *max_lat = data->max_lat;
+    return TRUE;
+}
+
+// 取得第 index 個SEP對照點（一般索引依 cell 順序，規則格網依載入順序並回傳節點座標）
+void sep_data_get_point(const SepDataStructure *data, int index,
+                        double *longitude, double *latitude, double *adjustment) {
+    const SepLattice *lattice = data->lattice;
+    if (lattice) {
+        gint32 node = lattice->point_nodes[index];
+        *longitude = lattice->node_longitudes[node % lattice->nx];
+        *latitude = lattice->node_latitudes[node / lattice->nx];
+        *adjustment = lattice->values[node];
+        return;
+    }
+
+    *longitude = data->longitudes[index];
+    *latitude = data->latitudes[index];
+    *adjustment = data->adjustments[index];
+}
+
+// 非分塊模型的單筆查詢：先精確匹配，找不到再進行網格插值；second_distance 不為 NULL 時回傳
+// 第二近鄰的距離（精確匹配為 0，不足兩點時為 DBL_MAX）
+static double sep_model_lookup(const SepDataStructure *data, double longitude, double latitude, SepMatchKind *kind,
+                               double *second_distance) {
+    if (data->lattice) {
+        SepMatchKind lattice_kind;
+        double lattice_adjustment = sep_lattice_lookup(data->lattice, longitude, latitude, &lattice_kind, NULL,
+                                                       second_distance);
+        if (kind) *kind = lattice_kind;
+        return lattice_adjustment;
+    }
+
+    double adjustment = sep_hash_lookup(data->hash_table, longitude, latitude);
+    if (adjustment > -99998.0) {
+        if (kind) *kind = SEP_MATCH_EXACT;
+        if (second_distance) *second_distance = 0.0;
+        return adjustment;
+    }
+
+    adjustment = sep_grid_lookup_with_interpolation(data->spatial_grid, longitude, latitude, second_distance);
+    if (kind) *kind = adjustment > -99998.0 ? SEP_MATCH_INTERPOLATED : SEP_MATCH_NONE;
+    return adjustment;
+}
+
+// 查詢單一座標的調整值：先精確匹配，找不到再進行網格插值
+double sep_data_lookup(const SepDataStructure *data, double longitude, double latitude, SepMatchKind *kind) {
+    if (data->tiles) {
+        return sep_tiles_lookup(data->tiles, longitude, latitude, kind);
+    }
+    return sep_model_lookup(data, longitude, latitude, kind, NULL);
+}
+
+// ===========================================
+// 批次查詢：Morton 排序 + 同 cell 共用候選清單
+// ===========================================
+
+// 排序鍵：cell 的 Morton 碼與原始查詢序號
+typedef struct {
+    guint32 code;
+    guint32 index;
+} SepSortKey;
+
+struct SepLookupContext {
+    SepSortKey *keys;           // 排序鍵
+    int keys_capacity;
+
+    // 目前 cell 的共用候選清單（與逐筆查詢的擴圈掃描順序一致）
+    const SepDataStructure *cand_data;  // 候選清單所屬的資料結構
+    SepPointArray *candidates;
+    int cand_ci, cand_cj;       // 候選清單所屬 cell，-1 表示尚未建立
+    int cand_rings;             // 候選清單已涵蓋的圈數（第 0 到 cand_rings - 1 圈）
+
+    // 時間連續性游標：上一筆查詢的位置、結果與兩個近鄰在候選清單中的位置
+    const SepDataStructure *prev_data;  // 上一筆查詢所用的資料結構，NULL 表示沒有上一筆
+    double prev_longitude, prev_latitude;
+    double prev_adjustment;
+    SepMatchKind prev_kind;
+    int prev_near0, prev_near1; // -1 表示沒有可用的近鄰
+    double prev_second_distance; // 第二近鄰的距離（精確匹配為 0，不足兩點時為 DBL_MAX）
+
+    SepLookupStats stats;
+};
+
+SepLookupContext* sep_lookup_context_new(void) {
+    SepLookupContext *ctx = g_new0(SepLookupContext, 1);
+    ctx->candidates = sep_point_array_init(256);
+    ctx->cand_ci = -1;
+    ctx->cand_cj = -1;
+    ctx->prev_near0 = -1;
+    ctx->prev_near1 = -1;
+    return ctx;
+}
+
+void sep_lookup_context_free(SepLookupContext *ctx) {
+    if (!ctx) return;
+
+    g_free(ctx->keys);
+    sep_point_array_free(ctx->candidates);
+    g_free(ctx);
+}
+
+void sep_lookup_context_get_stats(const SepLookupContext *ctx, SepLookupStats *stats) {
+    *stats = ctx->stats;
+}
+
+// 將 16 位元整數的位元交錯展開（Morton 編碼用）
+static guint32 morton_spread_bits(guint32 v) {
+    v &= 0x0000FFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+static guint32 morton_encode(int ci, int cj) {
+    return (morton_spread_bits((guint32)ci) << 1) | morton_spread_bits((guint32)cj);
+}
+
+static int compare_sort_keys(const void *a, const void *b) {
+    const SepSortKey *ka = (const SepSortKey *)a;
+    const SepSortKey *kb = (const SepSortKey *)b;
+
+    if (ka->code != kb->code) return ka->code < kb->code ? -1 : 1;
+    if (ka->index != kb->index) return ka->index < kb->index ? -1 : 1;
+    return 0;
+}
+
+// 目標點所在 cell（含邊界夾擠）
+static void grid_cell_of(const SpatialGrid *grid, double longitude, double latitude, int *ci, int *cj) {
+    lat_lon_to_grid_indices(grid, latitude, longitude, ci, cj);
+    *ci = CLAMP(*ci, 0, grid->lat_grid_size - 1);
+    *cj = CLAMP(*cj, 0, grid->lon_grid_size - 1);
+}
+
+// 把候選清單所屬 cell 的下一圈（第 cand_rings 圈）的點依掃描順序附加到候選清單
+static void append_candidate_ring(const SpatialGrid *grid, SepLookupContext *ctx) {
+    int cells[8 * SEP_GRID_SIZE + 1];
+    int cell_count = grid_ring_cells(grid, ctx->cand_ci, ctx->cand_cj, ctx->cand_rings, cells);
+
+    for (int c = 0; c < cell_count; ++c) {
+        for (gint32 k = grid->cell_start[cells[c]]; k < grid->cell_start[cells[c] + 1]; ++k) {
+            sep_point_array_add(ctx->candidates, grid->longitudes[k], grid->latitudes[k], grid->adjustments[k]);
+        }
+    }
+    ctx->cand_rings++;
+}
+
+// 建立某個 cell 的候選清單：依擴圈順序收集點，直到累積至少兩點為止
+// 停止條件只與 cell 有關，因此同一 cell 內的查詢可共用這份清單；個別查詢需要更多圈時由
+// context_lookup 再附加（只會附加在後面，已有候選點的位置不變）。回傳掃描的圈數
+static int build_cell_candidates(const SepDataStructure *data, SepLookupContext *ctx, int ci, int cj) {
+    const SpatialGrid *grid = data->spatial_grid;
+    ctx->candidates->count = 0;
+    ctx->cand_data = data;
+    ctx->cand_ci = ci;
+    ctx->cand_cj = cj;
+    ctx->cand_rings = 0;
+
+    const int max_r = MAX(grid->lat_grid_size, grid->lon_grid_size);
+    while (ctx->cand_rings < max_r) {
+        append_candidate_ring(grid, ctx);
+        if (ctx->candidates->count >= 2) break;
+    }
+    return ctx->cand_rings;
+}
+
+// 候選近鄰：距離相同時以候選清單中的位置先後決定，與逐點掃描的結果一致
+typedef struct {
+    double distance;
+    int position;
+} CandidateNeighbor;
+
+static gboolean candidate_is_closer(double distance, int position, const CandidateNeighbor *than) {
+    return distance < than->distance || (distance == than->distance && position < than->position);
+}
+
+static void candidate_offer(CandidateNeighbor *best0, CandidateNeighbor *best1, double distance, int position) {
+    if (candidate_is_closer(distance, position, best0)) {
+        *best1 = *best0;
+        best0->distance = distance;
+        best0->position = position;
+    } else if (candidate_is_closer(distance, position, best1)) {
+        best1->distance = distance;
+        best1->position = position;
+    }
+}
+
+// 在候選清單中找兩個最近鄰並插值，second_distance 回傳第二近鄰的距離（不足兩點時為 DBL_MAX）
+// 若上一筆查詢的近鄰仍在同一份候選清單中，先以它們到新位置的距離作為上界（暖啟動），
+// 緯度差換算的距離已超過上界的候選點不必計算大圓距離
+static double interpolate_from_candidates(SepLookupContext *ctx, double longitude, double latitude,
+                                          gboolean warm_start, double *second_distance) {
+    const SepPointArray *cand = ctx->candidates;
+    CandidateNeighbor best0 = { .distance = DBL_MAX, .position = G_MAXINT };
+    CandidateNeighbor best1 = { .distance = DBL_MAX, .position = G_MAXINT };
+
+    int seed0 = -1, seed1 = -1;
+    if (warm_start) {
+        seed0 = ctx->prev_near0;
+        seed1 = ctx->prev_near1;
+        if (seed0 >= 0) {
+            candidate_offer(&best0, &best1, calculate_distance(latitude, longitude,
+                            cand->latitudes[seed0], cand->longitudes[seed0]), seed0);
+        }
+        if (seed1 >= 0) {
+            candidate_offer(&best0, &best1, calculate_distance(latitude, longitude,
+                            cand->latitudes[seed1], cand->longitudes[seed1]), seed1);
+        }
+    }
+
+    // 大圓距離不小於緯度差對應的弧長，也不小於 2R * sqrt(cos(lat1) * cos(lat2)) * sin(dlon / 2)
+    // （sin(x) >= x - x^3 / 6，cos(lat2) 以網格範圍內最小值代入，不需三角函數）；保留少許餘裕避免浮點誤差誤刪
+    const double meters_per_degree = 6371000.0 * G_PI / 180.0 * (1.0 - 1e-9);
+    double cos_product = cos(latitude * G_PI / 180.0) * ctx->cand_data->spatial_grid->min_cos_lat;
+    const double lon_scale = 2.0 * 6371000.0 * sqrt(MAX(cos_product, 0.0)) * (1.0 - 1e-9);
+    for (int k = 0; k < cand->count; ++k) {
+        if (k == seed0 || k == seed1) continue;
+
+        if (best1.distance < DBL_MAX) {
+            if (fabs(cand->latitudes[k] - latitude) * meters_per_degree > best1.distance) continue;
+            double h = fabs(cand->longitudes[k] - longitude) * G_PI / 360.0;
+            if (h <= G_PI / 2 && lon_scale * (h - h * h * h / 6.0) > best1.distance) continue;
+        }
+
+        double d = calculate_distance(latitude, longitude, cand->latitudes[k], cand->longitudes[k]);
+        candidate_offer(&best0, &best1, d, k);
+    }
+
+    ctx->prev_near0 = best0.distance < DBL_MAX ? best0.position : -1;
+    ctx->prev_near1 = best1.distance < DBL_MAX ? best1.position : -1;
+    *second_distance = best1.distance;
+
+    Neighbor2 n0 = { .distance = best0.distance,
+                     .adjustment = ctx->prev_near0 >= 0 ? cand->adjustments[ctx->prev_near0] : 0.0 };
+    Neighbor2 n1 = { .distance = best1.distance,
+                     .adjustment = ctx->prev_near1 >= 0 ? cand->adjustments[ctx->prev_near1] : 0.0 };
+    return interpolate_two_nearest(n0, n1);
+}
+
+// 記住本筆查詢的位置與結果，供下一筆沿用
+static double context_remember(SepLookupContext *ctx, const SepDataStructure *data,
+                               double longitude, double latitude, double adjustment, SepMatchKind kind,
+                               double second_distance) {
+    ctx->prev_data = data;
+    ctx->prev_second_distance = second_distance;
+    ctx->prev_longitude = longitude;
+    ctx->prev_latitude = latitude;
+    ctx->prev_adjustment = adjustment;
+    ctx->prev_kind = kind;
+    return adjustment;
+}
+
+// 帶游標的單筆查詢：位置未變直接沿用結果，同一 cell 暖啟動，否則重建候選清單
+static double context_lookup(const SepDataStructure *data, SepLookupContext *ctx,
+                             double longitude, double latitude, SepMatchKind *kind) {
+    ctx->stats.lookups++;
+
+    if (ctx->prev_data == data &&
+        longitude == ctx->prev_longitude && latitude == ctx->prev_latitude) {
+        ctx->stats.reuse_hits++;
+        *kind = ctx->prev_kind;
+        return ctx->prev_adjustment;
+    }
+
+    if (data->lattice) {
+        // 規則格網：索引運算已是 O(1) 起步，不需要候選清單
+        ctx->stats.lattice_lookups++;
+        double second_distance;
+        double adjustment = sep_lattice_lookup(data->lattice, longitude, latitude, kind, &ctx->stats.rings_scanned,
+                                               &second_distance);
+        return context_remember(ctx, data, longitude, latitude, adjustment, *kind, second_distance);
+    }
+
+    double adjustment = sep_hash_lookup(data->hash_table, longitude, latitude);
+    double second_distance = 0.0;
+    if (adjustment > -99998.0) {
+        *kind = SEP_MATCH_EXACT;
+    } else {
+        int ci, cj;
+        grid_cell_of(data->spatial_grid, longitude, latitude, &ci, &cj);
+
+        gboolean warm_start = (ctx->cand_data == data && ci == ctx->cand_ci && cj == ctx->cand_cj);
+        if (warm_start) {
+            ctx->stats.warm_starts++;
+        } else {
+            ctx->stats.rings_scanned += (guint64)build_cell_candidates(data, ctx, ci, cj);
+            ctx->prev_near0 = -1;
+            ctx->prev_near1 = -1;
+            ctx->stats.cold_starts++;
+        }
+
+        // 候選清單以外的點可能比第二近鄰更近時逐圈附加，直到其餘 cell 的距離下界超過目前的第二近鄰
+        // （附加後第二近鄰只會更近，停止條件與 sep_grid_lookup_with_interpolation 相同），再重新找一次近鄰
+        const SpatialGrid *grid = data->spatial_grid;
+        const int max_r = MAX(grid->lat_grid_size, grid->lon_grid_size);
+        adjustment = interpolate_from_candidates(ctx, longitude, latitude, warm_start, &second_distance);
+        int rings_before = ctx->cand_rings;
+        while (ctx->cand_rings < max_r &&
+               !(second_distance < DBL_MAX &&
+                 grid_outside_ring_bound(grid, ci, cj, ctx->cand_rings - 1, longitude, latitude) > second_distance)) {
+            append_candidate_ring(grid, ctx);
+            ctx->stats.rings_scanned++;
+            if (second_distance == DBL_MAX && ctx->candidates->count >= 2) {
+                adjustment = interpolate_from_candidates(ctx, longitude, latitude, TRUE, &second_distance);
+            }
+        }
+        if (ctx->cand_rings != rings_before) {
+            adjustment = interpolate_from_candidates(ctx, longitude, latitude, TRUE, &second_distance);
+        }
+        *kind = adjustment > -99998.0 ? SEP_MATCH_INTERPOLATED : SEP_MATCH_NONE;
+    }
+
+    return context_remember(ctx, data, longitude, latitude, adjustment, *kind, second_distance);
+}
+
+// 非分塊模型的批次查詢；second_distances 不為 NULL 時依原始順序寫入每筆查詢的第二近鄰距離
+static void sep_model_lookup_batch(const SepDataStructure *data, SepLookupContext *ctx,
+                                   const double *longitudes, const double *latitudes, int count,
+                                   double *adjustments, SepMatchKind *kinds, double *second_distances) {
+    // 規則格網不需要空間排序，依原始順序查詢以保留時間連續性
+    if (data->lattice) {
+        for (int q = 0; q < count; q++) {
+            adjustments[q] = context_lookup(data, ctx, longitudes[q], latitudes[q], &kinds[q]);
+            if (second_distances) second_distances[q] = ctx->prev_second_distance;
+        }
+        return;
+    }
+
+    const SpatialGrid *grid = data->spatial_grid;
+
+    if (count > ctx->keys_capacity) {
+        ctx->keys_capacity = MAX(count, ctx->keys_capacity * 2);
+        ctx->keys = g_renew(SepSortKey, ctx->keys, ctx->keys_capacity);
+    }
+
+    // 1. 計算每筆查詢所在 cell 的 Morton 碼並排序
+    //    同一 cell 內保持原始（時間）順序，靜止或緩慢移動的連續查詢因此仍相鄰
+    for (int q = 0; q < count; q++) {
+        int ci, cj;
+        grid_cell_of(grid, longitudes[q], latitudes[q], &ci, &cj);
+        ctx->keys[q].code = morton_encode(ci, cj);
+        ctx->keys[q].index = (guint32)q;
+    }
+    qsort(ctx->keys, count, sizeof(SepSortKey), compare_sort_keys);
+
+    // 2. 依排序順序解析，結果依原始順序寫回
+    for (int s = 0; s < count; s++) {
+        int q = (int)ctx->keys[s].index;
+        adjustments[q] = context_lookup(data, ctx, longitudes[q], latitudes[q], &kinds[q]);
+        if (second_distances) second_distances[q] = ctx->prev_second_distance;
+    }
+}
+
+// 批次查詢
+void sep_data_lookup_batch(const SepDataStructure *data, SepLookupContext *ctx,
+                           const double *longitudes, const double *latitudes, int count,
+                           double *adjustments, SepMatchKind *kinds) {
+    if (count <= 0) return;
+
+    if (data->tiles) {
+        sep_tiles_lookup_batch(data->tiles, ctx, longitudes, latitudes, count, adjustments, kinds);
+        return;
+    }
+    sep_model_lookup_batch(data, ctx, longitudes, latitudes, count, adjustments, kinds, NULL);
+}
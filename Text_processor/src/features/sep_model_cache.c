@@ -0,0 +1,360 @@
+// SEP 模型常駐快取實現
+// 以路徑為鍵，並記錄檔案大小與修改時間；檔案改變時視為新模型重新載入
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <errno.h>
+#include <string.h>
+#include "../../include/sep_model_cache.h"
+
+struct SepModel {
+    gint ref_count;
+    SepDataStructure *data;
+};
+
+// 快取項目狀態
+typedef enum {
+    SEP_CACHE_ENTRY_LOADING = 0,   // 正在某個執行緒中載入
+    SEP_CACHE_ENTRY_READY,         // 已載入，model 有效
+    SEP_CACHE_ENTRY_FAILED         // 載入失敗，下次取得時重試
+} SepCacheEntryState;
+
+typedef struct {
+    char *path;                // 雜湊表的鍵（與項目同生命週期）
+    gint64 file_size;
+    gint64 file_mtime;
+    SepCacheEntryState state;
+    SepModel *model;           // READY 時有效，快取持有一個參考
+    gsize model_bytes;         // 計入記憶體上限的大小
+    guint64 last_used;         // LRU 時鐘
+    gboolean prefetched;       // 由背景預先載入
+    gboolean acquired;         // 是否已被取得過（區分預先載入與沿用）
+    gboolean discard;          // 預先載入已取消：載入完成後直接釋放，不放進快取
+} SepCacheEntry;
+
+struct SepModelCache {
+    gint ref_count;
+    GMutex mutex;
+    GCond entry_loaded;        // 任何項目離開 LOADING 狀態時廣播
+    GHashTable *entries;       // path -> SepCacheEntry*
+    gsize memory_limit;
+    gsize memory_used;
+    guint64 use_clock;
+};
+
+// 背景載入執行緒的參數
+typedef struct {
+    SepModelCache *cache;      // 持有一個參考
+    SepCacheEntry *entry;      // LOADING 狀態的項目不會被移除，指標保持有效
+} SepCacheLoadJob;
+
+// ---------- SepModel ----------
+
+SepModel* sep_model_new(SepDataStructure *data) {
+    if (!data) return NULL;
+
+    SepModel *model = g_new(SepModel, 1);
+    model->ref_count = 1;
+    model->data = data;
+    return model;
+}
+
+SepModel* sep_model_ref(SepModel *model) {
+    if (model) {
+        g_atomic_int_inc(&model->ref_count);
+    }
+    return model;
+}
+
+void sep_model_unref(SepModel *model) {
+    if (!model) return;
+
+    if (g_atomic_int_dec_and_test(&model->ref_count)) {
+        sep_data_free(model->data);
+        g_free(model);
+    }
+}
+
+const SepDataStructure* sep_model_get_data(const SepModel *model) {
+    return model ? model->data : NULL;
+}
+
+// ---------- 快取項目 ----------
+
+static void sep_cache_entry_free(gpointer data) {
+    SepCacheEntry *entry = data;
+    sep_model_unref(entry->model);
+    g_free(entry->path);
+    g_free(entry);
+}
+
+// 讀取SEP檔案的大小與修改時間
+static gboolean sep_cache_stat(const char *sep_path, gint64 *size, gint64 *mtime, GError **error) {
+    GStatBuf st;
+    if (g_stat(sep_path, &st) != 0) {
+        int saved_errno = errno;
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(saved_errno),
+                    "無法讀取SEP檔案資訊: %s (%s)", sep_path, g_strerror(saved_errno));
+        return FALSE;
+    }
+
+    *size = (gint64)st.st_size;
+    *mtime = (gint64)st.st_mtime;
+    return TRUE;
+}
+
+// 移除項目並扣除記憶體用量（需持有鎖，項目不可為 LOADING）
+static void sep_cache_remove_locked(SepModelCache *cache, SepCacheEntry *entry) {
+    if (entry->state == SEP_CACHE_ENTRY_READY) {
+        cache->memory_used -= entry->model_bytes;
+    }
+    g_hash_table_remove(cache->entries, entry->path);
+}
+
+// 超過記憶體上限時依 LRU 移出項目，keep 不會被移出（需持有鎖）
+// 被移出的模型若仍有轉換在使用，由該轉換持有的參考延續到使用完畢
+static void sep_cache_evict_locked(SepModelCache *cache, const SepCacheEntry *keep) {
+    while (cache->memory_used > cache->memory_limit) {
+        SepCacheEntry *oldest = NULL;
+        GHashTableIter iter;
+        gpointer value;
+
+        g_hash_table_iter_init(&iter, cache->entries);
+        while (g_hash_table_iter_next(&iter, NULL, &value)) {
+            SepCacheEntry *entry = value;
+            if (entry == keep || entry->state != SEP_CACHE_ENTRY_READY) {
+                continue;
+            }
+            if (!oldest || entry->last_used < oldest->last_used) {
+                oldest = entry;
+            }
+        }
+
+        if (!oldest) {
+            break;  // 只剩 keep 本身，單一模型超過上限時仍保留
+        }
+
+        g_print("SEP常駐快取: 超過記憶體上限，移出 %s\n", oldest->path);
+        sep_cache_remove_locked(cache, oldest);
+    }
+}
+
+// 建立 LOADING 狀態的項目並加入快取（需持有鎖）
+static SepCacheEntry* sep_cache_insert_loading_locked(SepModelCache *cache, const char *sep_path,
+                                                      gint64 file_size, gint64 file_mtime) {
+    SepCacheEntry *entry = g_new0(SepCacheEntry, 1);
+    entry->path = g_strdup(sep_path);
+    entry->file_size = file_size;
+    entry->file_mtime = file_mtime;
+    entry->state = SEP_CACHE_ENTRY_LOADING;
+    g_hash_table_insert(cache->entries, entry->path, entry);
+    return entry;
+}
+
+// 載入項目的SEP模型並公布結果（不可持有鎖呼叫，載入本身在鎖外進行）
+static void sep_cache_load_entry(SepModelCache *cache, SepCacheEntry *entry) {
+    // LOADING 期間 path 不會改變，可在鎖外讀取
+    SepDataStructure *data = load_sep_file_optimized(entry->path);
+
+    g_mutex_lock(&cache->mutex);
+    if (entry->discard) {
+        // 載入期間預先載入被取消，也沒有轉換在等待這個模型
+        g_hash_table_remove(cache->entries, entry->path);
+        g_cond_broadcast(&cache->entry_loaded);
+        g_mutex_unlock(&cache->mutex);
+        sep_data_free(data);
+        return;
+    }
+    if (data) {
+        gsize model_bytes = 0;
+        sep_data_memory_usage(data, &model_bytes, NULL);
+
+        entry->model = sep_model_new(data);
+        entry->model_bytes = model_bytes;
+        entry->last_used = ++cache->use_clock;
+        entry->state = SEP_CACHE_ENTRY_READY;
+        cache->memory_used += model_bytes;
+        sep_cache_evict_locked(cache, entry);
+    } else {
+        entry->state = SEP_CACHE_ENTRY_FAILED;
+    }
+    g_cond_broadcast(&cache->entry_loaded);
+    g_mutex_unlock(&cache->mutex);
+}
+
+static gpointer sep_cache_load_thread(gpointer user_data) {
+    SepCacheLoadJob *job = user_data;
+
+    sep_cache_load_entry(job->cache, job->entry);
+    sep_model_cache_unref(job->cache);
+    g_free(job);
+    return NULL;
+}
+
+// ---------- SepModelCache ----------
+
+SepModelCache* sep_model_cache_new(gsize memory_limit) {
+    SepModelCache *cache = g_new0(SepModelCache, 1);
+    cache->ref_count = 1;
+    g_mutex_init(&cache->mutex);
+    g_cond_init(&cache->entry_loaded);
+    cache->entries = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, sep_cache_entry_free);
+    cache->memory_limit = memory_limit;
+    return cache;
+}
+
+SepModelCache* sep_model_cache_ref(SepModelCache *cache) {
+    if (cache) {
+        g_atomic_int_inc(&cache->ref_count);
+    }
+    return cache;
+}
+
+void sep_model_cache_unref(SepModelCache *cache) {
+    if (!cache) return;
+
+    if (g_atomic_int_dec_and_test(&cache->ref_count)) {
+        // 背景載入執行緒持有參考，走到這裡時不會再有 LOADING 項目
+        g_hash_table_destroy(cache->entries);
+        g_cond_clear(&cache->entry_loaded);
+        g_mutex_clear(&cache->mutex);
+        g_free(cache);
+    }
+}
+
+void sep_model_cache_prefetch(SepModelCache *cache, const char *sep_path) {
+    if (!cache || !sep_path) return;
+
+    gint64 file_size, file_mtime;
+    if (!sep_cache_stat(sep_path, &file_size, &file_mtime, NULL)) {
+        return;  // 錯誤留待轉換時由 acquire 回報
+    }
+
+    g_mutex_lock(&cache->mutex);
+    SepCacheEntry *entry = g_hash_table_lookup(cache->entries, sep_path);
+    if (entry) {
+        if (entry->state == SEP_CACHE_ENTRY_LOADING) {
+            entry->discard = FALSE;
+            g_mutex_unlock(&cache->mutex);
+            return;
+        }
+        if (entry->state == SEP_CACHE_ENTRY_READY &&
+            entry->file_size == file_size && entry->file_mtime == file_mtime) {
+            entry->last_used = ++cache->use_clock;
+            g_mutex_unlock(&cache->mutex);
+            return;
+        }
+        sep_cache_remove_locked(cache, entry);
+    }
+
+    entry = sep_cache_insert_loading_locked(cache, sep_path, file_size, file_mtime);
+    entry->prefetched = TRUE;
+    g_mutex_unlock(&cache->mutex);
+
+    SepCacheLoadJob *job = g_new(SepCacheLoadJob, 1);
+    job->cache = sep_model_cache_ref(cache);
+    job->entry = entry;
+    g_thread_unref(g_thread_new("sep-prefetch", sep_cache_load_thread, job));
+}
+
+void sep_model_cache_cancel_prefetch(SepModelCache *cache, const char *sep_path) {
+    if (!cache || !sep_path) return;
+
+    g_mutex_lock(&cache->mutex);
+    SepCacheEntry *entry = g_hash_table_lookup(cache->entries, sep_path);
+    if (entry && entry->prefetched && !entry->acquired) {
+        if (entry->state == SEP_CACHE_ENTRY_LOADING) {
+            entry->discard = TRUE;  // 載入無法中斷，完成後由載入執行緒釋放
+        } else {
+            sep_cache_remove_locked(cache, entry);
+        }
+    }
+    g_mutex_unlock(&cache->mutex);
+}
+
+SepModel* sep_model_cache_acquire(SepModelCache *cache, const char *sep_path,
+                                  SepModelCacheResult *result, GError **error) {
+    if (!cache || !sep_path) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "SEP模型快取或檔案路徑無效");
+        return NULL;
+    }
+
+    gint64 file_size, file_mtime;
+    if (!sep_cache_stat(sep_path, &file_size, &file_mtime, error)) {
+        return NULL;
+    }
+
+    SepModel *model = NULL;
+    gboolean loaded_here = FALSE;
+    gboolean load_attempted = FALSE;
+
+    g_mutex_lock(&cache->mutex);
+    while (!model) {
+        SepCacheEntry *entry = g_hash_table_lookup(cache->entries, sep_path);
+
+        if (entry && entry->state == SEP_CACHE_ENTRY_LOADING) {
+            // 背景（或另一個轉換）正在載入同一個檔案，等它完成
+            entry->discard = FALSE;
+            g_cond_wait(&cache->entry_loaded, &cache->mutex);
+            continue;
+        }
+
+        if (entry && entry->state == SEP_CACHE_ENTRY_FAILED && load_attempted) {
+            sep_cache_remove_locked(cache, entry);
+            g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_FAILED, "無法載入SEP檔案: %s", sep_path);
+            break;
+        }
+
+        if (entry && (entry->state == SEP_CACHE_ENTRY_FAILED ||
+                      entry->file_size != file_size || entry->file_mtime != file_mtime)) {
+            // 背景載入失敗時重試一次；檔案已改變則捨棄舊模型
+            sep_cache_remove_locked(cache, entry);
+            entry = NULL;
+        }
+
+        if (!entry) {
+            entry = sep_cache_insert_loading_locked(cache, sep_path, file_size, file_mtime);
+            g_mutex_unlock(&cache->mutex);
+            sep_cache_load_entry(cache, entry);
+            g_mutex_lock(&cache->mutex);
+            loaded_here = TRUE;
+            load_attempted = TRUE;
+            continue;
+        }
+
+        // READY
+        if (result) {
+            if (loaded_here) {
+                *result = SEP_MODEL_CACHE_LOADED;
+            } else if (entry->prefetched && !entry->acquired) {
+                *result = SEP_MODEL_CACHE_PREFETCHED;
+            } else {
+                *result = SEP_MODEL_CACHE_HIT;
+            }
+        }
+        entry->acquired = TRUE;
+        entry->last_used = ++cache->use_clock;
+        model = sep_model_ref(entry->model);
+    }
+    g_mutex_unlock(&cache->mutex);
+
+    return model;
+}
+
+void sep_model_cache_describe(SepModelCache *cache, GString *report) {
+    if (!cache || !report) return;
+
+    g_mutex_lock(&cache->mutex);
+    guint entry_count = 0;
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, cache->entries);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        if (((SepCacheEntry *)value)->state == SEP_CACHE_ENTRY_READY) {
+            entry_count++;
+        }
+    }
+    g_string_append_printf(report, "SEP常駐快取: %u 個模型，%.1f / %.1f MB\n", entry_count,
+                           cache->memory_used / (1024.0 * 1024.0), cache->memory_limit / (1024.0 * 1024.0));
+    g_mutex_unlock(&cache->mutex);
+}
@@ -0,0 +1,330 @@
+// SEP 預計算調整值網格模組
+// 在SEP範圍上以固定解析度預先計算兩近鄰插值結果，並以快取檔保存於SEP檔案旁
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "sep_raster.h"
+
+// 快取檔案識別碼與版本
+#define SEP_RASTER_MAGIC "SEPRAST1"
+#define SEP_RASTER_VERSION 1
+
+// 快取檔案標頭（所有欄位皆為 8 位元組對齊，直接以記憶體格式寫出）
+typedef struct {
+    char magic[8];          // SEP_RASTER_MAGIC
+    guint32 version;        // SEP_RASTER_VERSION
+    guint32 reserved;
+    guint32 nx, ny;         // 經度、緯度方向節點數
+    double min_lon, min_lat;
+    double resolution;      // 節點間距（度）
+    gint64 source_size;     // 建立時SEP檔案大小
+    gint64 source_mtime;    // 建立時SEP檔案修改時間
+    double max_error;       // 建立時的誤差報告
+    double max_error_lon, max_error_lat;
+    double rms_error;
+    guint64 samples;
+} SepRasterFileHeader;
+
+struct SepRaster {
+    int nx, ny;             // 經度、緯度方向節點數
+    double min_lon, min_lat;
+    double resolution;
+    double *values;         // 節點調整值 [j * nx + i]
+
+    // 與逐點插值比較的誤差
+    double max_error;
+    double max_error_lon, max_error_lat;
+    double rms_error;
+    guint64 samples;
+};
+
+void sep_raster_free(SepRaster *raster) {
+    if (!raster) return;
+
+    g_free(raster->values);
+    g_free(raster);
+}
+
+double sep_raster_lookup(const SepRaster *raster, double longitude, double latitude) {
+    double fx = (longitude - raster->min_lon) / raster->resolution;
+    double fy = (latitude - raster->min_lat) / raster->resolution;
+
+    // 範圍外（含 NaN）交由呼叫端處理
+    if (!(fx >= 0.0 && fy >= 0.0 && fx <= raster->nx - 1 && fy <= raster->ny - 1)) {
+        return SEP_NOT_FOUND;
+    }
+
+    int ix = MIN((int)fx, raster->nx - 2);
+    int iy = MIN((int)fy, raster->ny - 2);
+    double tx = fx - ix;
+    double ty = fy - iy;
+
+    const double *row0 = raster->values + (gsize)iy * raster->nx + ix;
+    const double *row1 = row0 + raster->nx;
+
+    double bottom = row0[0] + (row0[1] - row0[0]) * tx;
+    double top = row1[0] + (row1[1] - row1[0]) * tx;
+    return bottom + (top - bottom) * ty;
+}
+
+void sep_raster_lookup_batch(const SepRaster *raster, const double *longitudes, const double *latitudes,
+                             int count, double *adjustments, SepMatchKind *kinds) {
+    for (int i = 0; i < count; i++) {
+        adjustments[i] = sep_raster_lookup(raster, longitudes[i], latitudes[i]);
+        kinds[i] = adjustments[i] == SEP_NOT_FOUND ? SEP_MATCH_NONE : SEP_MATCH_RASTER;
+    }
+}
+
+// 累計網格查詢與逐點插值的差異
+static void raster_accumulate_error(SepRaster *raster, const double *longitudes, const double *latitudes,
+                                    const double *exact, int count, double *sum_squares) {
+    for (int i = 0; i < count; i++) {
+        if (exact[i] == SEP_NOT_FOUND) continue;
+
+        double value = sep_raster_lookup(raster, longitudes[i], latitudes[i]);
+        if (value == SEP_NOT_FOUND) continue;
+
+        double diff = fabs(value - exact[i]);
+        if (diff > raster->max_error) {
+            raster->max_error = diff;
+            raster->max_error_lon = longitudes[i];
+            raster->max_error_lat = latitudes[i];
+        }
+        *sum_squares += diff * diff;
+        raster->samples++;
+    }
+}
+
+// 以網格中心與所有SEP點為取樣點，計算與逐點插值的誤差
+static void raster_evaluate_error(SepRaster *raster, const SepDataStructure *data, SepLookupContext *ctx) {
+    int capacity = MAX(raster->nx, SEP_BATCH_BLOCK_ROWS);
+    double *longitudes = g_new(double, capacity);
+    double *latitudes = g_new(double, capacity);
+    double *exact = g_new(double, capacity);
+    SepMatchKind *kinds = g_new(SepMatchKind, capacity);
+    double sum_squares = 0.0;
+
+    raster->max_error = 0.0;
+    raster->max_error_lon = raster->min_lon;
+    raster->max_error_lat = raster->min_lat;
+    raster->samples = 0;
+
+    // 網格中心：雙線性內插誤差最大的位置
+    for (int j = 0; j + 1 < raster->ny; j++) {
+        int count = raster->nx - 1;
+        for (int i = 0; i < count; i++) {
+            longitudes[i] = raster->min_lon + (i + 0.5) * raster->resolution;
+            latitudes[i] = raster->min_lat + (j + 0.5) * raster->resolution;
+        }
+        sep_data_lookup_batch(data, ctx, longitudes, latitudes, count, exact, kinds);
+        raster_accumulate_error(raster, longitudes, latitudes, exact, count, &sum_squares);
+    }
+
+    // SEP點本身：檢查網格是否保留了原始對照值
+    int point_count = sep_data_point_count(data);
+    for (int start = 0; start < point_count; start += capacity) {
+        int count = MIN(capacity, point_count - start);
+        for (int i = 0; i < count; i++) {
+            sep_data_get_point(data, start + i, &longitudes[i], &latitudes[i], &exact[i]);
+        }
+        raster_accumulate_error(raster, longitudes, latitudes, exact, count, &sum_squares);
+    }
+
+    raster->rms_error = raster->samples > 0 ? sqrt(sum_squares / raster->samples) : 0.0;
+
+    g_free(longitudes);
+    g_free(latitudes);
+    g_free(exact);
+    g_free(kinds);
+}
+
+// 在SEP範圍上建立網格：每個節點的值等於該位置的逐點插值結果
+static SepRaster* sep_raster_build(const SepDataStructure *data, double resolution, GError **error) {
+    double min_lon, max_lon, min_lat, max_lat;
+    if (!sep_data_get_bounds(data, &min_lon, &max_lon, &min_lat, &max_lat)) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "SEP檔案沒有任何對照點，無法建立調整值網格");
+        return NULL;
+    }
+
+    double nx_span = ceil((max_lon - min_lon) / resolution) + 1.0;
+    double ny_span = ceil((max_lat - min_lat) / resolution) + 1.0;
+    if (nx_span * ny_span > SEP_RASTER_MAX_NODES) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_NOMEM,
+                    "調整值網格解析度 %.6f 度過細（%.0f x %.0f 節點），請調大解析度",
+                    resolution, nx_span, ny_span);
+        return NULL;
+    }
+
+    SepRaster *raster = g_new0(SepRaster, 1);
+    raster->nx = MAX((int)nx_span, 2);
+    raster->ny = MAX((int)ny_span, 2);
+    raster->min_lon = min_lon;
+    raster->min_lat = min_lat;
+    raster->resolution = resolution;
+    raster->values = g_new(double, (gsize)raster->nx * raster->ny);
+
+    // 逐列批次查詢節點值，列內經度遞增讓查詢游標得以沿用近鄰
+    SepLookupContext *ctx = sep_lookup_context_new();
+    double *longitudes = g_new(double, raster->nx);
+    double *latitudes = g_new(double, raster->nx);
+    SepMatchKind *kinds = g_new(SepMatchKind, raster->nx);
+
+    for (int j = 0; j < raster->ny; j++) {
+        for (int i = 0; i < raster->nx; i++) {
+            longitudes[i] = min_lon + i * resolution;
+            latitudes[i] = min_lat + j * resolution;
+        }
+        sep_data_lookup_batch(data, ctx, longitudes, latitudes, raster->nx,
+                              raster->values + (gsize)j * raster->nx, kinds);
+    }
+
+    g_free(longitudes);
+    g_free(latitudes);
+    g_free(kinds);
+
+    raster_evaluate_error(raster, data, ctx);
+    sep_lookup_context_free(ctx);
+
+    return raster;
+}
+
+// 讀取快取檔；格式不符、SEP檔案已變更或解析度不同時回傳 NULL
+static SepRaster* sep_raster_load_cache(const char *cache_path, const GStatBuf *source_stat, double resolution) {
+    gchar *contents = NULL;
+    gsize length = 0;
+    if (!g_file_get_contents(cache_path, &contents, &length, NULL)) {
+        return NULL;
+    }
+
+    SepRasterFileHeader header;
+    if (length < sizeof(header)) {
+        g_free(contents);
+        return NULL;
+    }
+    memcpy(&header, contents, sizeof(header));
+
+    gsize node_count = (gsize)header.nx * header.ny;
+    if (memcmp(header.magic, SEP_RASTER_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SEP_RASTER_VERSION ||
+        header.nx < 2 || header.ny < 2 ||
+        length != sizeof(header) + node_count * sizeof(double) ||
+        header.resolution != resolution ||
+        header.source_size != (gint64)source_stat->st_size ||
+        header.source_mtime != (gint64)source_stat->st_mtime) {
+        g_free(contents);
+        return NULL;
+    }
+
+    SepRaster *raster = g_new0(SepRaster, 1);
+    raster->nx = (int)header.nx;
+    raster->ny = (int)header.ny;
+    raster->min_lon = header.min_lon;
+    raster->min_lat = header.min_lat;
+    raster->resolution = header.resolution;
+    raster->max_error = header.max_error;
+    raster->max_error_lon = header.max_error_lon;
+    raster->max_error_lat = header.max_error_lat;
+    raster->rms_error = header.rms_error;
+    raster->samples = header.samples;
+    raster->values = g_new(double, node_count);
+    memcpy(raster->values, contents + sizeof(header), node_count * sizeof(double));
+
+    g_free(contents);
+    return raster;
+}
+
+// 寫出快取檔（g_file_set_contents 以暫存檔加 rename 保證不會留下半個檔案）
+static gboolean sep_raster_save_cache(const SepRaster *raster, const char *cache_path,
+                                      const GStatBuf *source_stat, GError **error) {
+    gsize node_bytes = (gsize)raster->nx * raster->ny * sizeof(double);
+    gsize length = sizeof(SepRasterFileHeader) + node_bytes;
+    gchar *buffer = g_malloc(length);
+
+    SepRasterFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SEP_RASTER_MAGIC, sizeof(header.magic));
+    header.version = SEP_RASTER_VERSION;
+    header.nx = (guint32)raster->nx;
+    header.ny = (guint32)raster->ny;
+    header.min_lon = raster->min_lon;
+    header.min_lat = raster->min_lat;
+    header.resolution = raster->resolution;
+    header.source_size = (gint64)source_stat->st_size;
+    header.source_mtime = (gint64)source_stat->st_mtime;
+    header.max_error = raster->max_error;
+    header.max_error_lon = raster->max_error_lon;
+    header.max_error_lat = raster->max_error_lat;
+    header.rms_error = raster->rms_error;
+    header.samples = raster->samples;
+
+    memcpy(buffer, &header, sizeof(header));
+    memcpy(buffer + sizeof(header), raster->values, node_bytes);
+
+    gboolean ok = g_file_set_contents(cache_path, buffer, (gssize)length, error);
+    g_free(buffer);
+    return ok;
+}
+
+static void raster_append_error_report(const SepRaster *raster, GString *report) {
+    g_string_append_printf(report, "網格誤差報告（與逐點插值比較）:\n");
+    g_string_append_printf(report, "   • 取樣點數: %" G_GUINT64_FORMAT "（網格中心與SEP點）\n", raster->samples);
+    g_string_append_printf(report, "   • 最大誤差: %.4f m，位置 (%.7f, %.7f)\n",
+                           raster->max_error, raster->max_error_lon, raster->max_error_lat);
+    g_string_append_printf(report, "   • 均方根誤差: %.4f m\n", raster->rms_error);
+}
+
+SepRaster* sep_raster_load_or_build(const char *sep_path, const SepDataStructure *data,
+                                    double resolution, GString *report, GError **error) {
+    if (!(resolution > 0.0)) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "調整值網格解析度必須大於 0");
+        return NULL;
+    }
+
+    char *cache_path = g_strdup_printf("%s.raster", sep_path);
+    GStatBuf source_stat;
+    gboolean have_stat = g_stat(sep_path, &source_stat) == 0;
+
+    // 1. 嘗試使用快取
+    SepRaster *raster = have_stat ? sep_raster_load_cache(cache_path, &source_stat, resolution) : NULL;
+    if (raster) {
+        if (report) {
+            g_string_append_printf(report, "調整值網格: 由快取載入 %s（%d x %d 節點，解析度 %.6f 度）\n",
+                                   cache_path, raster->nx, raster->ny, raster->resolution);
+            raster_append_error_report(raster, report);
+        }
+        g_free(cache_path);
+        return raster;
+    }
+
+    // 2. 重新建立並寫回快取
+    gint64 build_start = g_get_monotonic_time();
+    raster = sep_raster_build(data, resolution, error);
+    if (!raster) {
+        g_free(cache_path);
+        return NULL;
+    }
+    double build_seconds = (g_get_monotonic_time() - build_start) / 1000000.0;
+
+    if (report) {
+        g_string_append_printf(report, "調整值網格: 已建立 %d x %d 節點（解析度 %.6f 度，耗時 %.2f 秒）\n",
+                               raster->nx, raster->ny, raster->resolution, build_seconds);
+        raster_append_error_report(raster, report);
+    }
+
+    GError *save_error = NULL;
+    if (!have_stat) {
+        if (report) g_string_append_printf(report, "警告: 無法取得SEP檔案資訊，網格不寫入快取\n");
+    } else if (!sep_raster_save_cache(raster, cache_path, &source_stat, &save_error)) {
+        // 快取寫入失敗不影響本次轉換
+        if (report) g_string_append_printf(report, "警告: 無法寫入網格快取 %s: %s\n", cache_path, save_error->message);
+        g_error_free(save_error);
+    } else if (report) {
+        g_string_append_printf(report, "網格快取已儲存: %s\n", cache_path);
+    }
+
+    g_free(cache_path);
+    return raster;
+}
@@ -0,0 +1,746 @@
+// SEP 不規則三角網（TIN）模組
+// 以逐點插入加邊翻轉（Lawson）建立 Delaunay 三角網，查詢時沿相鄰三角形走訪定位後以重心座標線性內插
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "sep_tin.h"
+
+// 快取檔案識別碼與版本
+#define SEP_TIN_MAGIC "SEPTIN01"
+#define SEP_TIN_VERSION 2
+
+// 方向與外接圓判斷的相對容差：結果絕對值小於此比例乘以各項絕對值和時視為 0，
+// 避免規則格網上大量共圓的點因捨入誤差反覆翻轉
+#define SEP_TIN_EPSILON 1e-12
+
+// 外包三角形相對於正規化範圍（單位正方形）的大小
+#define SEP_TIN_SUPER_SIZE 32.0
+
+// 視為同一點的經緯度差（度），與精確匹配的容差一致
+#define SEP_TIN_DUPLICATE_TOLERANCE 1e-10
+
+// 外包三角形的頂點數；這些頂點接在SEP頂點之後，含有它們的三角形稱為外圍三角形
+#define SEP_TIN_SUPER_VERTICES 3
+
+// 快取檔案標頭（所有欄位皆為 8 位元組對齊，直接以記憶體格式寫出）
+// 標頭之後依序為頂點 x[n+3]、y[n+3]、調整值[n+3]（double），三角形頂點[3m]、相鄰三角形[3m]（gint32），
+// 頂點 n..n+2 為外包三角形的頂點（調整值為 NAN）
+typedef struct {
+    char magic[8];              // SEP_TIN_MAGIC
+    guint32 version;            // SEP_TIN_VERSION
+    guint32 data_triangle_count; // 不含外包頂點的三角形數
+    gint64 source_size;         // 建立時SEP檔案大小
+    gint64 source_mtime;        // 建立時SEP檔案修改時間
+    guint32 vertex_count;       // SEP頂點數 n（不含外包頂點）
+    guint32 triangle_count;     // 含外圍三角形的總數 m
+    guint32 duplicate_count;    // 建立時合併的重複點數
+    guint32 start_triangle;     // 每批查詢的起始三角形（範圍中心附近）
+    double origin_lon, origin_lat;
+    double scale_lon, scale_lat;    // 正規化座標 x = (經度 - origin_lon) * scale_lon
+} SepTinFileHeader;
+
+// 三角網的陣列檢視：三角形 t 的頂點為 tri_v[3t..3t+2]（逆時針），
+// tri_n[3t + i] 為頂點 i 對邊另一側的三角形，-1 表示三角網邊界
+typedef struct {
+    const double *x, *y;
+    const gint32 *tri_v;
+    const gint32 *tri_n;
+    int triangle_count;
+} TinMesh;
+
+struct SepTin {
+    TinMesh mesh;
+    const double *values;       // 頂點調整值
+    int vertex_count;           // SEP頂點數，索引不小於此值的是外包頂點
+    int data_triangle_count;
+    int duplicate_count;
+    gint32 start_triangle;
+    double origin_lon, origin_lat;
+    double scale_lon, scale_lat;
+
+    GMappedFile *mapped;        // 由快取載入時的唯讀映射
+    gchar *owned_buffer;        // 新建立時持有的快取內容
+};
+
+void sep_tin_free(SepTin *tin) {
+    if (!tin) return;
+
+    if (tin->mapped) g_mapped_file_unref(tin->mapped);
+    g_free(tin->owned_buffer);
+    g_free(tin);
+}
+
+// 方向判斷：> 0 表示 a、b、c 為逆時針；bound 回傳此結果可信的下限
+static double tin_orient(double ax, double ay, double bx, double by, double cx, double cy, double *bound) {
+    double left = (bx - ax) * (cy - ay);
+    double right = (by - ay) * (cx - ax);
+    *bound = SEP_TIN_EPSILON * (fabs(left) + fabs(right));
+    return left - right;
+}
+
+// 外接圓判斷：> 0 表示 d 在逆時針三角形 a、b、c 的外接圓內
+static double tin_incircle(double ax, double ay, double bx, double by, double cx, double cy,
+                           double dx, double dy, double *bound) {
+    double adx = ax - dx, ady = ay - dy;
+    double bdx = bx - dx, bdy = by - dy;
+    double cdx = cx - dx, cdy = cy - dy;
+
+    double alift = adx * adx + ady * ady;
+    double blift = bdx * bdx + bdy * bdy;
+    double clift = cdx * cdx + cdy * cdy;
+
+    double bc = bdx * cdy - bdy * cdx;
+    double ca = cdx * ady - cdy * adx;
+    double ab = adx * bdy - ady * bdx;
+
+    double permanent = alift * (fabs(bdx * cdy) + fabs(bdy * cdx)) +
+                       blift * (fabs(cdx * ady) + fabs(cdy * adx)) +
+                       clift * (fabs(adx * bdy) + fabs(ady * bdx));
+    *bound = SEP_TIN_EPSILON * permanent;
+    return alift * bc + blift * ca + clift * ab;
+}
+
+// 檢查 (px, py) 相對於三角形 t 的位置：回傳點在外側的一條邊（-1 表示在三角形內或邊上），
+// on_edge 回傳點所在的邊（-1 不在邊上，3 表示同時在兩條邊上，即與頂點重合）
+static int tin_outside_edge(const TinMesh *mesh, gint32 t, int first, double px, double py, int *on_edge) {
+    const gint32 *v = mesh->tri_v + 3 * (gsize)t;
+    *on_edge = -1;
+    for (int k = 0; k < 3; k++) {
+        int i = (first + k) % 3;
+        gint32 a = v[(i + 1) % 3];
+        gint32 b = v[(i + 2) % 3];
+        double bound;
+        double o = tin_orient(mesh->x[a], mesh->y[a], mesh->x[b], mesh->y[b], px, py, &bound);
+        if (o < -bound) return i;
+        if (o <= bound) *on_edge = *on_edge < 0 ? i : 3;
+    }
+    return -1;
+}
+
+/**
+ * 從三角形 start 沿相鄰三角形走訪到包含 (px, py) 的三角形
+ *
+ * 每一步越過點所在外側的一條邊；檢查順序隨步數輪換，避免在非嚴格 Delaunay 的區域繞圈。
+ *
+ * @return 包含該點的三角形；走出三角網邊界時回傳 -1，超過 max_steps 回傳 -2
+ */
+static gint32 tin_locate(const TinMesh *mesh, gint32 start, double px, double py,
+                         gint64 max_steps, int *on_edge) {
+    gint32 t = start;
+    for (gint64 step = 0; step <= max_steps; step++) {
+        int edge = tin_outside_edge(mesh, t, (int)(step % 3), px, py, on_edge);
+        if (edge < 0) return t;
+
+        t = mesh->tri_n[3 * (gsize)t + edge];
+        if (t < 0) return -1;
+    }
+    return -2;
+}
+
+// 逐一檢查所有三角形（走訪失敗時的後備）
+static gint32 tin_locate_scan(const TinMesh *mesh, double px, double py, int *on_edge) {
+    for (gint32 t = 0; t < mesh->triangle_count; t++) {
+        if (tin_outside_edge(mesh, t, 0, px, py, on_edge) < 0) return t;
+    }
+    return -1;
+}
+
+// 三角形中離 (px, py) 最近的頂點
+static gint32 tin_nearest_vertex(const TinMesh *mesh, const gint32 *v, double px, double py) {
+    gint32 nearest = v[0];
+    double best = G_MAXDOUBLE;
+    for (int i = 0; i < 3; i++) {
+        double dx = mesh->x[v[i]] - px;
+        double dy = mesh->y[v[i]] - py;
+        if (dx * dx + dy * dy < best) {
+            best = dx * dx + dy * dy;
+            nearest = v[i];
+        }
+    }
+    return nearest;
+}
+
+// ========== 建立 ==========
+
+typedef struct {
+    double *x, *y;          // 正規化座標，頂點 n..n+2 為外包三角形
+    double *values;
+    const double *longitudes, *latitudes;
+    int point_count;        // n
+    gint32 *tri_v, *tri_n;
+    int triangle_count;
+    gint32 *stack;          // 待檢查的 (三角形, 插入點) 配對
+    gsize stack_count, stack_capacity;
+} TinBuilder;
+
+static TinMesh tin_builder_mesh(const TinBuilder *b) {
+    TinMesh mesh = { b->x, b->y, b->tri_v, b->tri_n, b->triangle_count };
+    return mesh;
+}
+
+static void tin_set_triangle(TinBuilder *b, gint32 t, gint32 v0, gint32 v1, gint32 v2,
+                             gint32 n0, gint32 n1, gint32 n2) {
+    gint32 *v = b->tri_v + 3 * (gsize)t;
+    gint32 *n = b->tri_n + 3 * (gsize)t;
+    v[0] = v0; v[1] = v1; v[2] = v2;
+    n[0] = n0; n[1] = n1; n[2] = n2;
+}
+
+// 旋轉三角形的頂點順序，讓原本的第 k 個頂點成為第 0 個
+static void tin_rotate(TinBuilder *b, gint32 t, int k) {
+    if (k == 0) return;
+    gint32 *v = b->tri_v + 3 * (gsize)t;
+    gint32 *n = b->tri_n + 3 * (gsize)t;
+    gint32 v0 = v[k], v1 = v[(k + 1) % 3], v2 = v[(k + 2) % 3];
+    gint32 n0 = n[k], n1 = n[(k + 1) % 3], n2 = n[(k + 2) % 3];
+    tin_set_triangle(b, t, v0, v1, v2, n0, n1, n2);
+}
+
+static int tin_vertex_index(const TinBuilder *b, gint32 t, gint32 vertex) {
+    const gint32 *v = b->tri_v + 3 * (gsize)t;
+    for (int i = 0; i < 3; i++) {
+        if (v[i] == vertex) return i;
+    }
+    return -1;
+}
+
+static int tin_neighbor_index(const TinBuilder *b, gint32 t, gint32 other) {
+    const gint32 *n = b->tri_n + 3 * (gsize)t;
+    for (int i = 0; i < 3; i++) {
+        if (n[i] == other) return i;
+    }
+    return -1;
+}
+
+static void tin_replace_neighbor(TinBuilder *b, gint32 t, gint32 old_neighbor, gint32 new_neighbor) {
+    if (t < 0) return;
+    int i = tin_neighbor_index(b, t, old_neighbor);
+    if (i >= 0) b->tri_n[3 * (gsize)t + i] = new_neighbor;
+}
+
+static void tin_push(TinBuilder *b, gint32 t, gint32 vertex) {
+    if (b->stack_count + 2 > b->stack_capacity) {
+        b->stack_capacity = MAX(b->stack_capacity * 2, 64);
+        b->stack = g_renew(gint32, b->stack, b->stack_capacity);
+    }
+    b->stack[b->stack_count++] = t;
+    b->stack[b->stack_count++] = vertex;
+}
+
+// 點 p 在三角形 t 內：分成三個三角形
+static void tin_split_triangle(TinBuilder *b, gint32 t, gint32 p) {
+    const gint32 *v = b->tri_v + 3 * (gsize)t;
+    const gint32 *n = b->tri_n + 3 * (gsize)t;
+    gint32 a = v[0], c1 = v[1], c2 = v[2];
+    gint32 na = n[0], n1 = n[1], n2 = n[2];
+    gint32 t1 = b->triangle_count++;
+    gint32 t2 = b->triangle_count++;
+
+    tin_set_triangle(b, t, p, c1, c2, na, t1, t2);
+    tin_set_triangle(b, t1, a, p, c2, t, n1, t2);
+    tin_set_triangle(b, t2, a, c1, p, t, t1, n2);
+    tin_replace_neighbor(b, n1, t, t1);
+    tin_replace_neighbor(b, n2, t, t2);
+
+    tin_push(b, t, p);
+    tin_push(b, t1, p);
+    tin_push(b, t2, p);
+}
+
+// 點 p 在三角形 t 第 edge 個頂點的對邊上：與對面的三角形一起分成四個（邊界邊則分成兩個）
+static void tin_split_edge(TinBuilder *b, gint32 t, int edge, gint32 p) {
+    tin_rotate(b, t, edge);
+    const gint32 *v = b->tri_v + 3 * (gsize)t;
+    const gint32 *n = b->tri_n + 3 * (gsize)t;
+    gint32 a = v[0], c1 = v[1], c2 = v[2];
+    gint32 o = n[0], na = n[1], nb = n[2];
+    gint32 t1 = b->triangle_count++;
+
+    if (o < 0) {
+        tin_set_triangle(b, t, a, c1, p, -1, t1, nb);
+        tin_set_triangle(b, t1, a, p, c2, -1, na, t);
+        tin_replace_neighbor(b, na, t, t1);
+        tin_push(b, t, p);
+        tin_push(b, t1, p);
+        return;
+    }
+
+    // 對面的三角形為 (q, c2, c1)
+    tin_rotate(b, o, tin_neighbor_index(b, o, t));
+    const gint32 *ov = b->tri_v + 3 * (gsize)o;
+    const gint32 *on = b->tri_n + 3 * (gsize)o;
+    gint32 q = ov[0];
+    gint32 nc = on[1], nd = on[2];
+    gint32 o1 = b->triangle_count++;
+
+    tin_set_triangle(b, t, a, c1, p, o1, t1, nb);
+    tin_set_triangle(b, t1, a, p, c2, o, na, t);
+    tin_set_triangle(b, o, q, c2, p, t1, o1, nd);
+    tin_set_triangle(b, o1, q, p, c1, t, nc, o);
+    tin_replace_neighbor(b, na, t, t1);
+    tin_replace_neighbor(b, nc, o, o1);
+
+    tin_push(b, t, p);
+    tin_push(b, t1, p);
+    tin_push(b, o, p);
+    tin_push(b, o1, p);
+}
+
+// 檢查插入點周圍的邊，不符合 Delaunay 條件（對面頂點落在外接圓內）就翻轉
+static void tin_legalize(TinBuilder *b) {
+    while (b->stack_count > 0) {
+        gint32 p = b->stack[--b->stack_count];
+        gint32 t = b->stack[--b->stack_count];
+
+        // 三角形已被其他翻轉改變時，它的邊已由新的三角形負責檢查
+        int k = tin_vertex_index(b, t, p);
+        if (k < 0) continue;
+        tin_rotate(b, t, k);
+
+        gint32 o = b->tri_n[3 * (gsize)t];
+        if (o < 0) continue;
+        tin_rotate(b, o, tin_neighbor_index(b, o, t));
+
+        const gint32 *v = b->tri_v + 3 * (gsize)t;
+        const gint32 *n = b->tri_n + 3 * (gsize)t;
+        const gint32 *ov = b->tri_v + 3 * (gsize)o;
+        const gint32 *on = b->tri_n + 3 * (gsize)o;
+        gint32 x = v[1], y = v[2], q = ov[0];
+
+        double bound;
+        double in = tin_incircle(b->x[p], b->y[p], b->x[x], b->y[x], b->x[y], b->y[y],
+                                 b->x[q], b->y[q], &bound);
+        if (in <= bound) continue;
+
+        gint32 na = n[1], nb = n[2], nc = on[1], nd = on[2];
+        tin_set_triangle(b, t, p, x, q, nc, o, nb);
+        tin_set_triangle(b, o, p, q, y, nd, na, t);
+        tin_replace_neighbor(b, nc, o, t);
+        tin_replace_neighbor(b, na, t, o);
+
+        tin_push(b, t, p);
+        tin_push(b, o, p);
+    }
+}
+
+// 依空間位置（Morton 順序）排列的插入順序鍵，同一位置依讀取順序
+typedef struct {
+    guint32 code;
+    gint32 index;
+} TinInsertKey;
+
+static guint32 tin_spread_bits(guint32 v) {
+    v &= 0x0000FFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+static int compare_insert_keys(const void *a, const void *b) {
+    const TinInsertKey *ka = (const TinInsertKey *)a;
+    const TinInsertKey *kb = (const TinInsertKey *)b;
+    if (ka->code != kb->code) return ka->code < kb->code ? -1 : 1;
+    return (ka->index > kb->index) - (ka->index < kb->index);
+}
+
+static TinInsertKey* tin_insert_order(const TinBuilder *b) {
+    TinInsertKey *keys = g_new(TinInsertKey, b->point_count);
+    for (int i = 0; i < b->point_count; i++) {
+        guint32 cx = (guint32)CLAMP(b->x[i] * 65535.0, 0.0, 65535.0);
+        guint32 cy = (guint32)CLAMP(b->y[i] * 65535.0, 0.0, 65535.0);
+        keys[i].code = (tin_spread_bits(cx) << 1) | tin_spread_bits(cy);
+        keys[i].index = i;
+    }
+    qsort(keys, b->point_count, sizeof(TinInsertKey), compare_insert_keys);
+    return keys;
+}
+
+// 插入第 p 個點；與既有頂點重合時合併（後讀到的調整值覆蓋先前的，與精確匹配一致）
+static gint32 tin_insert(TinBuilder *b, gint32 p, gint32 hint, int *duplicate_count) {
+    TinMesh mesh = tin_builder_mesh(b);
+    int on_edge;
+    gint32 t = tin_locate(&mesh, hint, b->x[p], b->y[p], b->triangle_count, &on_edge);
+    if (t < 0) t = tin_locate_scan(&mesh, b->x[p], b->y[p], &on_edge);
+    if (t < 0) return hint;
+
+    if (on_edge == 3) {
+        gint32 nearest = tin_nearest_vertex(&mesh, b->tri_v + 3 * (gsize)t, b->x[p], b->y[p]);
+        if (nearest < b->point_count) {
+            b->values[nearest] = b->values[p];
+            (*duplicate_count)++;
+            return t;
+        }
+        on_edge = -1;
+    }
+
+    // 與頂點距離在容差內（但尚未小到落在兩條邊上）也視為重複點
+    const gint32 *v = b->tri_v + 3 * (gsize)t;
+    for (int i = 0; i < 3; i++) {
+        gint32 w = v[i];
+        if (w < b->point_count &&
+            fabs(b->longitudes[w] - b->longitudes[p]) <= SEP_TIN_DUPLICATE_TOLERANCE &&
+            fabs(b->latitudes[w] - b->latitudes[p]) <= SEP_TIN_DUPLICATE_TOLERANCE) {
+            b->values[w] = b->values[p];
+            (*duplicate_count)++;
+            return t;
+        }
+    }
+
+    if (on_edge >= 0) {
+        tin_split_edge(b, t, on_edge, p);
+    } else {
+        tin_split_triangle(b, t, p);
+    }
+    tin_legalize(b);
+    return t;
+}
+
+// 將建立結果整理成快取格式：只保留被引用的頂點（重複點被合併，不會被引用），外包頂點接在最後。
+// 含外包頂點的外圍三角形也保留：移除後三角網的邊界可能內凹，走訪可能從凹處走出邊界而找不到
+// 其實在三角網內的點；保留時整個外包三角形都有三角形覆蓋，走訪能越過凹處
+static gchar* tin_pack(const TinBuilder *b, SepTinFileHeader *header, gsize *length) {
+    int n = b->point_count;
+    gint32 *vertex_map = g_new(gint32, n + SEP_TIN_SUPER_VERTICES);
+    int data_triangle_count = 0;
+    int vertex_count = 0;
+
+    for (int i = 0; i < n; i++) vertex_map[i] = -1;
+    for (gint32 t = 0; t < b->triangle_count; t++) {
+        const gint32 *v = b->tri_v + 3 * (gsize)t;
+        for (int i = 0; i < 3; i++) {
+            if (v[i] < n) vertex_map[v[i]] = 0;
+        }
+        if (v[0] < n && v[1] < n && v[2] < n) data_triangle_count++;
+    }
+    for (int i = 0; i < n; i++) {
+        if (vertex_map[i] == 0) vertex_map[i] = vertex_count++;
+    }
+    for (int i = 0; i < SEP_TIN_SUPER_VERTICES; i++) {
+        vertex_map[n + i] = vertex_count + i;
+    }
+
+    int triangle_count = b->triangle_count;
+    int stored_vertices = vertex_count + SEP_TIN_SUPER_VERTICES;
+    header->vertex_count = (guint32)vertex_count;
+    header->triangle_count = (guint32)triangle_count;
+    header->data_triangle_count = (guint32)data_triangle_count;
+
+    gsize vertex_bytes = (gsize)stored_vertices * sizeof(double);
+    gsize triangle_bytes = (gsize)triangle_count * 3 * sizeof(gint32);
+    *length = sizeof(SepTinFileHeader) + 3 * vertex_bytes + 2 * triangle_bytes;
+    gchar *buffer = g_malloc(*length);
+
+    double *x = (double *)(buffer + sizeof(SepTinFileHeader));
+    double *y = x + stored_vertices;
+    double *values = y + stored_vertices;
+    gint32 *tri_v = (gint32 *)(values + stored_vertices);
+    gint32 *tri_n = tri_v + 3 * (gsize)triangle_count;
+
+    for (int i = 0; i < n + SEP_TIN_SUPER_VERTICES; i++) {
+        if (vertex_map[i] < 0) continue;
+        x[vertex_map[i]] = b->x[i];
+        y[vertex_map[i]] = b->y[i];
+        values[vertex_map[i]] = i < n ? b->values[i] : NAN;
+    }
+    for (gsize k = 0; k < 3 * (gsize)triangle_count; k++) {
+        tri_v[k] = vertex_map[b->tri_v[k]];
+        tri_n[k] = b->tri_n[k];
+    }
+
+    g_free(vertex_map);
+    return buffer;
+}
+
+// 讓三角網檢視指向快取格式的內容
+static void sep_tin_attach(SepTin *tin, const gchar *contents) {
+    SepTinFileHeader header;
+    memcpy(&header, contents, sizeof(header));
+
+    const double *x = (const double *)(contents + sizeof(SepTinFileHeader));
+    gsize stored_vertices = (gsize)header.vertex_count + SEP_TIN_SUPER_VERTICES;
+    tin->vertex_count = (int)header.vertex_count;
+    tin->data_triangle_count = (int)header.data_triangle_count;
+    tin->mesh.x = x;
+    tin->mesh.y = x + stored_vertices;
+    tin->values = x + 2 * stored_vertices;
+    tin->mesh.tri_v = (const gint32 *)(x + 3 * stored_vertices);
+    tin->mesh.tri_n = tin->mesh.tri_v + 3 * (gsize)header.triangle_count;
+    tin->mesh.triangle_count = (int)header.triangle_count;
+    tin->duplicate_count = (int)header.duplicate_count;
+    tin->start_triangle = (gint32)header.start_triangle;
+    tin->origin_lon = header.origin_lon;
+    tin->origin_lat = header.origin_lat;
+    tin->scale_lon = header.scale_lon;
+    tin->scale_lat = header.scale_lat;
+}
+
+static SepTin* sep_tin_build(const SepDataStructure *data, const GStatBuf *source_stat, GError **error) {
+    int n = sep_data_point_count(data);
+    double min_lon, max_lon, min_lat, max_lat;
+    if (n < 3 || !sep_data_get_bounds(data, &min_lon, &max_lon, &min_lat, &max_lat)) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "SEP對照點不足 3 個，無法建立三角網");
+        return NULL;
+    }
+    if (n > SEP_TIN_MAX_POINTS) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_NOMEM,
+                    "SEP對照點過多（%d 個），超過三角網上限 %d", n, SEP_TIN_MAX_POINTS);
+        return NULL;
+    }
+
+    // 正規化到單位正方形：經度乘上中心緯度的餘弦，讓三角形形狀接近實際距離
+    double lon_factor = cos((min_lat + max_lat) * 0.5 * G_PI / 180.0);
+    double extent = MAX((max_lon - min_lon) * lon_factor, max_lat - min_lat);
+    if (!(extent > 0.0)) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "SEP對照點全部重合，無法建立三角網");
+        return NULL;
+    }
+
+    SepTinFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SEP_TIN_MAGIC, sizeof(header.magic));
+    header.version = SEP_TIN_VERSION;
+    header.source_size = source_stat ? (gint64)source_stat->st_size : 0;
+    header.source_mtime = source_stat ? (gint64)source_stat->st_mtime : 0;
+    header.origin_lon = min_lon;
+    header.origin_lat = min_lat;
+    header.scale_lon = lon_factor / extent;
+    header.scale_lat = 1.0 / extent;
+
+    TinBuilder b;
+    memset(&b, 0, sizeof(b));
+    b.point_count = n;
+    b.x = g_new(double, n + 3);
+    b.y = g_new(double, n + 3);
+    b.values = g_new(double, n);
+    double *longitudes = g_new(double, n);
+    double *latitudes = g_new(double, n);
+    b.longitudes = longitudes;
+    b.latitudes = latitudes;
+
+    for (int i = 0; i < n; i++) {
+        sep_data_get_point(data, i, &longitudes[i], &latitudes[i], &b.values[i]);
+        b.x[i] = (longitudes[i] - min_lon) * header.scale_lon;
+        b.y[i] = (latitudes[i] - min_lat) * header.scale_lat;
+    }
+
+    // 外包三角形（逆時針）涵蓋整個單位正方形；每插入一點增加兩個三角形
+    b.x[n] = 0.5 - 2.0 * SEP_TIN_SUPER_SIZE;     b.y[n] = 0.5 - SEP_TIN_SUPER_SIZE;
+    b.x[n + 1] = 0.5 + 2.0 * SEP_TIN_SUPER_SIZE; b.y[n + 1] = 0.5 - SEP_TIN_SUPER_SIZE;
+    b.x[n + 2] = 0.5;                            b.y[n + 2] = 0.5 + 2.0 * SEP_TIN_SUPER_SIZE;
+    b.tri_v = g_new(gint32, 3 * (2 * (gsize)n + 1));
+    b.tri_n = g_new(gint32, 3 * (2 * (gsize)n + 1));
+    b.triangle_count = 1;
+    tin_set_triangle(&b, 0, n, n + 1, n + 2, -1, -1, -1);
+
+    // 依空間順序插入，每次定位都從上一點所在的三角形出發，只需走訪幾步
+    TinInsertKey *order = tin_insert_order(&b);
+    int duplicate_count = 0;
+    gint32 hint = 0;
+    for (int i = 0; i < n; i++) {
+        hint = tin_insert(&b, order[i].index, hint, &duplicate_count);
+    }
+    g_free(order);
+
+    header.duplicate_count = (guint32)duplicate_count;
+    gsize length = 0;
+    gchar *buffer = tin_pack(&b, &header, &length);
+
+    g_free(b.x);
+    g_free(b.y);
+    g_free(b.values);
+    g_free(longitudes);
+    g_free(latitudes);
+    g_free(b.tri_v);
+    g_free(b.tri_n);
+    g_free(b.stack);
+
+    if (header.data_triangle_count == 0) {
+        g_free(buffer);
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "SEP對照點全部共線，無法建立三角網");
+        return NULL;
+    }
+
+    SepTin *tin = g_new0(SepTin, 1);
+    tin->owned_buffer = buffer;
+    memcpy(buffer, &header, sizeof(header));
+    sep_tin_attach(tin, buffer);
+
+    // 起始三角形：範圍中心所在的三角形
+    int on_edge;
+    gint32 center = tin_locate(&tin->mesh, 0, (max_lon - min_lon) * 0.5 * header.scale_lon,
+                               (max_lat - min_lat) * 0.5 * header.scale_lat,
+                               tin->mesh.triangle_count, &on_edge);
+    header.start_triangle = (guint32)MAX(center, 0);
+    memcpy(buffer, &header, sizeof(header));
+    tin->start_triangle = (gint32)header.start_triangle;
+
+    return tin;
+}
+
+// 檢查快取內容的標頭、長度與索引範圍；任何不符都視為快取失效
+static gboolean sep_tin_cache_valid(const gchar *contents, gsize length, const GStatBuf *source_stat, int point_count) {
+    SepTinFileHeader header;
+    if (length < sizeof(header)) return FALSE;
+    memcpy(&header, contents, sizeof(header));
+
+    if (memcmp(header.magic, SEP_TIN_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SEP_TIN_VERSION ||
+        header.source_size != (gint64)source_stat->st_size ||
+        header.source_mtime != (gint64)source_stat->st_mtime ||
+        header.vertex_count < 3 || header.vertex_count > (guint32)point_count ||
+        header.data_triangle_count == 0 || header.data_triangle_count > header.triangle_count ||
+        header.start_triangle >= header.triangle_count ||
+        length != sizeof(header) + ((gsize)header.vertex_count + SEP_TIN_SUPER_VERTICES) * 3 * sizeof(double) +
+                  (gsize)header.triangle_count * 6 * sizeof(gint32)) {
+        return FALSE;
+    }
+
+    // 走訪時直接以索引存取，損壞的索引必須在此排除
+    guint32 stored_vertices = header.vertex_count + SEP_TIN_SUPER_VERTICES;
+    const gint32 *tri_v = (const gint32 *)(contents + sizeof(header) + (gsize)stored_vertices * 3 * sizeof(double));
+    const gint32 *tri_n = tri_v + 3 * (gsize)header.triangle_count;
+    for (gsize i = 0; i < 3 * (gsize)header.triangle_count; i++) {
+        if (tri_v[i] < 0 || (guint32)tri_v[i] >= stored_vertices) return FALSE;
+        if (tri_n[i] < -1 || (tri_n[i] >= 0 && (guint32)tri_n[i] >= header.triangle_count)) return FALSE;
+    }
+    return TRUE;
+}
+
+// 以唯讀記憶體映射載入快取；格式不符或SEP檔案已變更時回傳 NULL
+static SepTin* sep_tin_load_cache(const char *cache_path, const GStatBuf *source_stat, int point_count) {
+    GMappedFile *mapped = g_mapped_file_new(cache_path, FALSE, NULL);
+    if (!mapped) return NULL;
+
+    const gchar *contents = g_mapped_file_get_contents(mapped);
+    gsize length = g_mapped_file_get_length(mapped);
+    if (!contents || !sep_tin_cache_valid(contents, length, source_stat, point_count)) {
+        g_mapped_file_unref(mapped);
+        return NULL;
+    }
+
+    SepTin *tin = g_new0(SepTin, 1);
+    tin->mapped = mapped;
+    sep_tin_attach(tin, contents);
+    return tin;
+}
+
+static void tin_append_summary(const SepTin *tin, GString *report) {
+    g_string_append_printf(report, "   • %d 個頂點、%d 個三角形", tin->vertex_count, tin->data_triangle_count);
+    if (tin->duplicate_count > 0) {
+        g_string_append_printf(report, "（合併重複點 %d 個）", tin->duplicate_count);
+    }
+    g_string_append_printf(report, "\n   • 三角網範圍外的查詢改用兩近鄰插值\n");
+}
+
+SepTin* sep_tin_load_or_build(const char *sep_path, const SepDataStructure *data,
+                              GString *report, GError **error) {
+    char *cache_path = g_strdup_printf("%s.septin", sep_path);
+    GStatBuf source_stat;
+    gboolean have_stat = g_stat(sep_path, &source_stat) == 0;
+
+    // 1. 嘗試使用快取
+    SepTin *tin = have_stat ? sep_tin_load_cache(cache_path, &source_stat, sep_data_point_count(data)) : NULL;
+    if (tin) {
+        if (report) {
+            g_string_append_printf(report, "三角網: 由快取載入 %s\n", cache_path);
+            tin_append_summary(tin, report);
+        }
+        g_free(cache_path);
+        return tin;
+    }
+
+    // 2. 重新建立並寫回快取
+    gint64 build_start = g_get_monotonic_time();
+    tin = sep_tin_build(data, have_stat ? &source_stat : NULL, error);
+    if (!tin) {
+        g_free(cache_path);
+        return NULL;
+    }
+    double build_seconds = (g_get_monotonic_time() - build_start) / 1000000.0;
+
+    if (report) {
+        g_string_append_printf(report, "三角網: 已建立（耗時 %.2f 秒）\n", build_seconds);
+        tin_append_summary(tin, report);
+    }
+
+    GError *save_error = NULL;
+    gsize length = sizeof(SepTinFileHeader) + ((gsize)tin->vertex_count + SEP_TIN_SUPER_VERTICES) * 3 * sizeof(double) +
+                   (gsize)tin->mesh.triangle_count * 6 * sizeof(gint32);
+    if (!have_stat) {
+        if (report) g_string_append_printf(report, "警告: 無法取得SEP檔案資訊，三角網不寫入快取\n");
+    } else if (!g_file_set_contents(cache_path, tin->owned_buffer, (gssize)length, &save_error)) {
+        // 快取寫入失敗不影響本次轉換
+        if (report) g_string_append_printf(report, "警告: 無法寫入三角網快取 %s: %s\n", cache_path, save_error->message);
+        g_error_free(save_error);
+    } else if (report) {
+        g_string_append_printf(report, "三角網快取已儲存: %s\n", cache_path);
+    }
+
+    g_free(cache_path);
+    return tin;
+}
+
+// ========== 查詢 ==========
+
+// 三角形是否含有外包頂點（外圍三角形）
+static gboolean tin_is_outer(const SepTin *tin, const gint32 *v) {
+    return v[0] >= tin->vertex_count || v[1] >= tin->vertex_count || v[2] >= tin->vertex_count;
+}
+
+void sep_tin_lookup_batch(const SepTin *tin, const double *longitudes, const double *latitudes,
+                          int count, double *adjustments, SepMatchKind *kinds) {
+    const TinMesh *mesh = &tin->mesh;
+    gint32 t = tin->start_triangle;
+
+    for (int q = 0; q < count; q++) {
+        double px = (longitudes[q] - tin->origin_lon) * tin->scale_lon;
+        double py = (latitudes[q] - tin->origin_lat) * tin->scale_lat;
+        int on_edge;
+        gint32 found = isfinite(px) && isfinite(py)
+                       ? tin_locate(mesh, t, px, py, mesh->triangle_count, &on_edge) : -1;
+        if (found < 0) {
+            adjustments[q] = SEP_NOT_FOUND;
+            kinds[q] = SEP_MATCH_NONE;
+            continue;
+        }
+        t = found;
+
+        // 落在外圍三角形（SEP點的三角形都不包含此點，例如凸包外或邊界內凹處）時由呼叫端改用兩近鄰插值；
+        // 點剛好在三角網邊界上時改用邊另一側的三角形，與頂點重合時直接使用該頂點的值
+        const gint32 *v = mesh->tri_v + 3 * (gsize)t;
+        if (tin_is_outer(tin, v)) {
+            gint32 inner = on_edge >= 0 && on_edge < 3 ? mesh->tri_n[3 * (gsize)t + on_edge] : -1;
+            if (inner >= 0 && !tin_is_outer(tin, mesh->tri_v + 3 * (gsize)inner)) {
+                t = inner;
+                v = mesh->tri_v + 3 * (gsize)t;
+            } else {
+                gint32 vertex = on_edge == 3 ? tin_nearest_vertex(mesh, v, px, py) : -1;
+                gboolean on_vertex = vertex >= 0 && vertex < tin->vertex_count;
+                adjustments[q] = on_vertex ? tin->values[vertex] : SEP_NOT_FOUND;
+                kinds[q] = on_vertex ? SEP_MATCH_TIN : SEP_MATCH_NONE;
+                continue;
+            }
+        }
+
+        double ax = mesh->x[v[0]], ay = mesh->y[v[0]];
+        double bx = mesh->x[v[1]], by = mesh->y[v[1]];
+        double cx = mesh->x[v[2]], cy = mesh->y[v[2]];
+        double area = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+        if (!(area > 0.0)) {
+            adjustments[q] = SEP_NOT_FOUND;
+            kinds[q] = SEP_MATCH_NONE;
+            continue;
+        }
+        double wa = ((bx - px) * (cy - py) - (by - py) * (cx - px)) / area;
+        double wb = ((cx - px) * (ay - py) - (cy - py) * (ax - px)) / area;
+        double wc = 1.0 - wa - wb;
+
+        adjustments[q] = wa * tin->values[v[0]] + wb * tin->values[v[1]] + wc * tin->values[v[2]];
+        kinds[q] = SEP_MATCH_TIN;
+    }
+}
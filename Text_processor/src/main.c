@@ -4,8 +4,76 @@
 #include <string.h>
 #include "ui/ui.h"
 #include "callbacks.h"
+#include "elevation_processing.h"
+#include "tide_format.h"
+
+// 串流模式下所有訊息改寫到標準錯誤，標準輸出只留給轉換結果
+static void print_to_stderr(const gchar *message) {
+    fputs(message, stderr);
+}
+
+// 命令列串流模式：text_processor --stream <SEP檔案> [--workers N] [--raster 解析度] [--tin] [--tiles 分塊大小] [--format 格式]
+// 從標準輸入讀取潮位資料，轉換後的資料行寫到標準輸出，轉換報告寫到標準錯誤
+static int run_stream_mode(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "用法: %s --stream <SEP檔案> [--workers N] [--raster 解析度] [--tin] [--tiles 分塊大小] [--format 格式] < 輸入 > 輸出\n", argv[0]);
+        return 2;
+    }
+
+    ElevationOptions options;
+    TideFormat tide_format;
+    elevation_options_init(&options);
+    for (int i = 3; i < argc; i++) {
+        if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc) {
+            options.worker_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--raster") == 0 && i + 1 < argc) {
+            options.use_raster = TRUE;
+            options.raster_resolution = g_ascii_strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--tin") == 0) {
+            options.use_tin = TRUE;
+        } else if (strcmp(argv[i], "--tiles") == 0 && i + 1 < argc) {
+            options.use_tiles = TRUE;
+            options.tile_size = g_ascii_strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            GError *format_error = NULL;
+            if (!tide_format_from_spec(&tide_format, argv[++i], &format_error)) {
+                fprintf(stderr, "輸入格式設定錯誤: %s\n", format_error->message);
+                g_error_free(format_error);
+                return 2;
+            }
+            options.tide_format = &tide_format;
+        } else {
+            fprintf(stderr, "未知的參數: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    g_set_print_handler(print_to_stderr);
+
+    GString *report = g_string_new(NULL);
+    GError *error = NULL;
+    gboolean ok = process_elevation_stream(fileno(stdin), fileno(stdout), argv[2], &options,
+                                           report, &error, NULL);
+    fputs(report->str, stderr);
+    if (!ok) {
+        fprintf(stderr, "錯誤: %s\n", error ? error->message : "串流轉換失敗");
+        g_clear_error(&error);
+    }
+    g_string_free(report, TRUE);
+    return ok ? 0 : 1;
+}
 
 int main(int argc, char **argv) {
+    // 分段轉換的工作行程由本程式以 posix_spawn 啟動，不初始化 GTK
+    if (argc >= 2 && strcmp(argv[1], ELEVATION_SHARD_WORKER_ARG) == 0) {
+        return elevation_shard_worker_main(argc, argv);
+    }
+    elevation_set_shard_executable(argv[0]);
+
+    if (argc >= 2 && strcmp(argv[1], "--stream") == 0) {
+        return run_stream_mode(argc, argv);
+    }
+
     GtkApplication *app;
     int status;
     AppState *state = malloc(sizeof(AppState));
@@ -0,0 +1,129 @@
+// 進度通道：工作執行緒與 UI 執行緒之間的無鎖進度交換
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "progress_channel.h"
+
+// 取樣端讀取訊息時的重試次數，超過則沿用上次的訊息
+#define PROGRESS_SAMPLE_RETRIES 4
+
+// 重置進度通道
+void progress_channel_reset(ProgressChannel *channel) {
+    if (!channel) return;
+
+    g_atomic_int_set(&channel->current, 0);
+    g_atomic_int_set(&channel->total, 0);
+    g_atomic_int_set(&channel->phase, PROGRESS_PHASE_PREPARING);
+    g_atomic_int_set(&channel->message_sequence, 0);
+    channel->message[0] = '\0';
+    g_atomic_int_inc(&channel->version);
+}
+
+// 設定處理階段
+void progress_channel_set_phase(ProgressChannel *channel, ProgressPhase phase) {
+    if (!channel) return;
+
+    g_atomic_int_set(&channel->phase, (gint)phase);
+    g_atomic_int_inc(&channel->version);
+}
+
+// 設定目前進度與總量
+void progress_channel_set_counts(ProgressChannel *channel, int current, int total) {
+    if (!channel) return;
+
+    // 兩個欄位分開寫入，取樣端可能看到新舊混合的組合；
+    // 比例在取樣端會限制在 0-1 之間，下一次取樣即恢復一致
+    g_atomic_int_set(&channel->total, total);
+    g_atomic_int_set(&channel->current, current);
+    g_atomic_int_inc(&channel->version);
+}
+
+// 截斷後的訊息結尾可能是不完整的 UTF-8 字元，往前退到完整字元為止（UI 只接受有效的 UTF-8）
+static void progress_message_trim_utf8(char *message) {
+    gsize length = strlen(message);
+    while (length > 0 && !g_utf8_validate(message, (gssize)length, NULL)) {
+        const gchar *previous = g_utf8_find_prev_char(message, message + length);
+        length = previous ? (gsize)(previous - message) : 0;
+    }
+    message[length] = '\0';
+}
+
+// 設定進度訊息（超過長度時在字元邊界截斷）
+void progress_channel_set_message(ProgressChannel *channel, const char *message) {
+    if (!channel || !message) return;
+
+    // 以 CAS 將序號由偶數改為奇數取得寫入權，失敗表示另一個執行緒正在寫入
+    gint sequence = g_atomic_int_get(&channel->message_sequence);
+    if ((sequence & 1) ||
+        !g_atomic_int_compare_and_exchange(&channel->message_sequence, sequence, sequence + 1)) {
+        return;
+    }
+
+    if (g_strlcpy(channel->message, message, sizeof(channel->message)) >= sizeof(channel->message)) {
+        progress_message_trim_utf8(channel->message);
+    }
+
+    // 寫入完成：序號回到偶數（atomic 寫入同時作為記憶體屏障）
+    g_atomic_int_set(&channel->message_sequence, sequence + 2);
+    g_atomic_int_inc(&channel->version);
+}
+
+// 以格式字串設定進度訊息
+void progress_channel_set_messagef(ProgressChannel *channel, const char *format, ...) {
+    if (!channel || !format) return;
+
+    char buffer[PROGRESS_MESSAGE_SIZE];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (length >= (int)sizeof(buffer)) {
+        progress_message_trim_utf8(buffer);
+    }
+
+    progress_channel_set_message(channel, buffer);
+}
+
+// 取樣目前進度
+gboolean progress_channel_sample(const ProgressChannel *channel, ProgressSnapshot *snapshot) {
+    if (!channel || !snapshot) return FALSE;
+
+    gint version = g_atomic_int_get(&channel->version);
+    if (version == snapshot->version) {
+        return FALSE;
+    }
+
+    snapshot->version = version;
+    snapshot->current = g_atomic_int_get(&channel->current);
+    snapshot->total = g_atomic_int_get(&channel->total);
+    snapshot->phase = (ProgressPhase)g_atomic_int_get(&channel->phase);
+
+    // seqlock 讀取：前後序號相同且為偶數，表示複製期間沒有寫入
+    char message[PROGRESS_MESSAGE_SIZE];
+    for (int attempt = 0; attempt < PROGRESS_SAMPLE_RETRIES; attempt++) {
+        gint before = g_atomic_int_get(&channel->message_sequence);
+        if (before & 1) {
+            continue;
+        }
+
+        memcpy(message, channel->message, sizeof(message));
+        if (g_atomic_int_get(&channel->message_sequence) == before) {
+            message[sizeof(message) - 1] = '\0';
+            memcpy(snapshot->message, message, sizeof(snapshot->message));
+            break;
+        }
+    }
+
+    return TRUE;
+}
+
+// 取得取樣結果的完成比例
+double progress_snapshot_fraction(const ProgressSnapshot *snapshot) {
+    if (!snapshot || snapshot->total <= 0) {
+        return -1.0;
+    }
+
+    double fraction = (double)snapshot->current / snapshot->total;
+    return CLAMP(fraction, 0.0, 1.0);
+}
@@ -0,0 +1,450 @@
+// 潮位資料格式：設定驗證、編譯期產生的專用解析函數與通用對應表解析
+
+#include <stdlib.h>
+#include <string.h>
+#include "tide_format.h"
+
+// 內建版面：識別名稱、設定名稱、分隔符、datetime 欄數與六個數值欄位的順序（datetime 固定在最前面）
+// 每個版面由下方的巨集展開成一個專用解析函數，分隔符與欄位順序都是編譯期常數
+#define TIDE_FORMAT_BUILTIN_LAYOUTS(X) \
+    X(slash,      "slash",      '/',  4, TIDE, LONGITUDE, LATITUDE, PROCESSED_DEPTH, COL6, COL7) \
+    X(csv,        "csv",        ',',  1, TIDE, LONGITUDE, LATITUDE, PROCESSED_DEPTH, COL6, COL7) \
+    X(csv_latlon, "csv-latlon", ',',  1, TIDE, LATITUDE, LONGITUDE, PROCESSED_DEPTH, COL6, COL7) \
+    X(tab,        "tab",        '\t', 1, TIDE, LONGITUDE, LATITUDE, PROCESSED_DEPTH, COL6, COL7)
+
+// 欄位對應到 TideDataRow 的成員
+#define TIDE_ROW_MEMBER_TIDE            tide
+#define TIDE_ROW_MEMBER_LONGITUDE       longitude
+#define TIDE_ROW_MEMBER_LATITUDE        latitude
+#define TIDE_ROW_MEMBER_PROCESSED_DEPTH processed_depth
+#define TIDE_ROW_MEMBER_COL6            col6
+#define TIDE_ROW_MEMBER_COL7            col7
+
+// 設定與報告使用的欄位名稱（順序與 TideField 相同）
+static const char * const tide_field_names[TIDE_FIELD_KIND_COUNT] = {
+    "datetime", "tide", "lon", "lat", "depth", "col6", "col7", "skip"
+};
+
+// ---------- 解析基本步驟（以常數參數呼叫時由編譯器特化） ----------
+
+// 跳過前導空白；空白字元本身是分隔符時不跳過
+static inline const char* tide_skip_leading_space(const char *p, char delimiter) {
+    while ((*p == ' ' && delimiter != ' ') || (*p == '\t' && delimiter != '\t') || *p == '\r') p++;
+    return p;
+}
+
+// 複製 datetime（佔 datetime_fields 個欄位），回傳下一欄的開頭；失敗時回傳 NULL
+// more 為 FALSE 表示 datetime 是最後一欄，以行尾結束
+static inline const char* tide_parse_datetime(const char *p, TideDataRow *row, char delimiter,
+                                              int datetime_fields, gboolean more) {
+    const char *q = p;
+    if (more) {
+        int delimiter_count = 0;
+        for (; *q; ++q) {
+            if (*q == delimiter && ++delimiter_count == datetime_fields) break;
+        }
+        if (*q != delimiter) {
+            return NULL;  // 格式不含足夠的分隔符來結束 datetime
+        }
+    } else {
+        q = p + strcspn(p, "\r\n");
+    }
+
+    size_t dt_len = (size_t)(q - p);
+    if (dt_len == 0 || dt_len >= sizeof(row->datetime)) {
+        return NULL;  // datetime 太長或為空
+    }
+    memcpy(row->datetime, p, dt_len);
+    row->datetime[dt_len] = '\0';
+    return more ? q + 1 : q;
+}
+
+// 解析一個數值欄位；不是最後一欄時必須緊接著分隔符
+static inline gboolean tide_parse_number(const char **cursor, double *value, char delimiter, gboolean more) {
+    const char *p = *cursor;
+    if (*p == delimiter) {
+        return FALSE;  // 空欄位（避免 strtod 跳過作為分隔符的空白）
+    }
+
+    char *end = NULL;
+    *value = strtod(p, &end);
+    if (end == p || (more && *end != delimiter)) {
+        return FALSE;
+    }
+    *cursor = end + 1;
+    return TRUE;
+}
+
+// ---------- 編譯期產生的專用解析函數 ----------
+
+#define TIDE_PARSE_FIELD(field, delimiter, more) \
+    if (!tide_parse_number(&p, &row->TIDE_ROW_MEMBER_##field, delimiter, more)) return FALSE;
+
+#define TIDE_DEFINE_LAYOUT_PARSER(id, name, delimiter, datetime_fields, f1, f2, f3, f4, f5, f6) \
+    static gboolean tide_parse_layout_##id(const char *line, TideDataRow *row, const TideFormat *format) { \
+        (void)format; \
+        const char *p = tide_parse_datetime(tide_skip_leading_space(line, delimiter), row, \
+                                            delimiter, datetime_fields, TRUE); \
+        if (!p) return FALSE; \
+        TIDE_PARSE_FIELD(f1, delimiter, TRUE) \
+        TIDE_PARSE_FIELD(f2, delimiter, TRUE) \
+        TIDE_PARSE_FIELD(f3, delimiter, TRUE) \
+        TIDE_PARSE_FIELD(f4, delimiter, TRUE) \
+        TIDE_PARSE_FIELD(f5, delimiter, TRUE) \
+        TIDE_PARSE_FIELD(f6, delimiter, FALSE) \
+        return TRUE; \
+    }
+
+TIDE_FORMAT_BUILTIN_LAYOUTS(TIDE_DEFINE_LAYOUT_PARSER)
+
+// 內建版面表
+typedef struct {
+    const char *name;
+    char delimiter;
+    int datetime_fields;
+    TideField fields[6];
+    TideRowParser parse;
+} TideLayout;
+
+#define TIDE_LAYOUT_ENTRY(id, name, delimiter, datetime_fields, f1, f2, f3, f4, f5, f6) \
+    { name, delimiter, datetime_fields, \
+      { TIDE_FIELD_##f1, TIDE_FIELD_##f2, TIDE_FIELD_##f3, TIDE_FIELD_##f4, TIDE_FIELD_##f5, TIDE_FIELD_##f6 }, \
+      tide_parse_layout_##id },
+
+static const TideLayout tide_layouts[] = {
+    TIDE_FORMAT_BUILTIN_LAYOUTS(TIDE_LAYOUT_ENTRY)
+};
+
+#define TIDE_LAYOUT_COUNT ((int)(sizeof(tide_layouts) / sizeof(tide_layouts[0])))
+
+// ---------- 通用對應表解析 ----------
+
+static double* tide_row_field(TideDataRow *row, TideField field) {
+    switch (field) {
+        case TIDE_FIELD_TIDE:            return &row->tide;
+        case TIDE_FIELD_LONGITUDE:       return &row->longitude;
+        case TIDE_FIELD_LATITUDE:        return &row->latitude;
+        case TIDE_FIELD_PROCESSED_DEPTH: return &row->processed_depth;
+        case TIDE_FIELD_COL6:            return &row->col6;
+        case TIDE_FIELD_COL7:            return &row->col7;
+        default:                         return NULL;
+    }
+}
+
+static gboolean tide_parse_mapped(const char *line, TideDataRow *row, const TideFormat *format) {
+    const char delimiter = format->delimiter;
+    const char *p = tide_skip_leading_space(line, delimiter);
+
+    for (int c = 0; c < format->column_count; c++) {
+        gboolean more = c + 1 < format->column_count;
+        TideField field = format->columns[c];
+
+        if (field == TIDE_FIELD_DATETIME) {
+            p = tide_parse_datetime(p, row, delimiter, format->datetime_fields, more);
+            if (!p) return FALSE;
+        } else if (field == TIDE_FIELD_SKIP) {
+            if (more) {
+                const char *next = strchr(p, delimiter);
+                if (!next) return FALSE;
+                p = next + 1;
+            }
+        } else if (!tide_parse_number(&p, tide_row_field(row, field), delimiter, more)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+// ---------- 公開介面 ----------
+
+static const TideFormat tide_default_format = {
+    .delimiter = '/',
+    .datetime_fields = 4,
+    .column_count = 7,
+    .columns = { TIDE_FIELD_DATETIME, TIDE_FIELD_TIDE, TIDE_FIELD_LONGITUDE, TIDE_FIELD_LATITUDE,
+                 TIDE_FIELD_PROCESSED_DEPTH, TIDE_FIELD_COL6, TIDE_FIELD_COL7 },
+    .parse = tide_parse_layout_slash,
+    .layout_name = "slash"
+};
+
+const TideFormat* tide_format_default(void) {
+    return &tide_default_format;
+}
+
+gboolean tide_format_parse_row(const TideFormat *format, const char *line, TideDataRow *row) {
+    return format->parse(line, row, format);
+}
+
+// 解析失敗原因的說明（順序與 TideRowError 相同）
+static const char * const tide_row_error_names[TIDE_ROW_ERROR_COUNT] = {
+    "空行", "欄位數不足（分隔符不符）", "datetime 為空或過長", "數值欄位無法解析", "其他格式錯誤"
+};
+
+const char * const * tide_format_row_error_names(void) {
+    return tide_row_error_names;
+}
+
+// 依格式的欄位順序重新走一次解析，回報第一個失敗的步驟
+TideRowError tide_format_diagnose_row(const TideFormat *format, const char *line) {
+    const char delimiter = format->delimiter;
+    const char *p = tide_skip_leading_space(line, delimiter);
+    if (p[strspn(p, " \t\r\n")] == '\0') {
+        return TIDE_ROW_ERROR_EMPTY;
+    }
+
+    // 所需的分隔符數：datetime 佔 datetime_fields 欄
+    int required = format->column_count - 1;
+    for (int c = 0; c < format->column_count; c++) {
+        if (format->columns[c] == TIDE_FIELD_DATETIME) required += format->datetime_fields - 1;
+    }
+    int delimiters = 0;
+    for (const char *q = p; *q && *q != '\n'; ++q) {
+        if (*q == delimiter) delimiters++;
+    }
+    if (delimiters < required) {
+        return TIDE_ROW_ERROR_FIELD_COUNT;
+    }
+
+    TideDataRow row;
+    for (int c = 0; c < format->column_count; c++) {
+        gboolean more = c + 1 < format->column_count;
+        TideField field = format->columns[c];
+
+        if (field == TIDE_FIELD_DATETIME) {
+            p = tide_parse_datetime(p, &row, delimiter, format->datetime_fields, more);
+            if (!p) return TIDE_ROW_ERROR_DATETIME;
+        } else if (field == TIDE_FIELD_SKIP) {
+            if (more) {
+                const char *next = strchr(p, delimiter);
+                if (!next) return TIDE_ROW_ERROR_FIELD_COUNT;
+                p = next + 1;
+            }
+        } else {
+            double value;
+            if (!tide_parse_number(&p, &value, delimiter, more)) return TIDE_ROW_ERROR_NUMBER;
+        }
+    }
+    return TIDE_ROW_ERROR_OTHER;
+}
+
+gboolean tide_format_compile(TideFormat *format, GError **error) {
+    if (format->delimiter == '\0' || format->delimiter == '\n' || format->delimiter == '\r') {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "無效的欄位分隔符");
+        return FALSE;
+    }
+    if (format->datetime_fields < 1 || format->datetime_fields > 8) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                    "datetime 欄數必須介於 1 到 8: %d", format->datetime_fields);
+        return FALSE;
+    }
+    if (format->column_count < 2 || format->column_count > TIDE_FORMAT_MAX_COLUMNS) {
+        g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                    "欄位數必須介於 2 到 %d: %d", TIDE_FORMAT_MAX_COLUMNS, format->column_count);
+        return FALSE;
+    }
+
+    // 除了 skip 以外，每種欄位都必須恰好出現一次
+    int seen[TIDE_FIELD_KIND_COUNT] = { 0 };
+    for (int c = 0; c < format->column_count; c++) {
+        TideField field = format->columns[c];
+        if ((int)field < 0 || field >= TIDE_FIELD_KIND_COUNT) {
+            g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "第 %d 欄的欄位類型無效", c + 1);
+            return FALSE;
+        }
+        seen[field]++;
+    }
+    for (int f = 0; f < TIDE_FIELD_SKIP; f++) {
+        if (seen[f] != 1) {
+            g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                        "欄位 %s 必須恰好對應一欄（目前 %d 欄）", tide_field_names[f], seen[f]);
+            return FALSE;
+        }
+    }
+
+    // 與內建版面完全相同時改用專用解析函數
+    format->parse = tide_parse_mapped;
+    format->layout_name = NULL;
+    for (int i = 0; i < TIDE_LAYOUT_COUNT; i++) {
+        const TideLayout *layout = &tide_layouts[i];
+        if (format->column_count != 7 || format->columns[0] != TIDE_FIELD_DATETIME ||
+            format->delimiter != layout->delimiter || format->datetime_fields != layout->datetime_fields ||
+            memcmp(&format->columns[1], layout->fields, sizeof(layout->fields)) != 0) {
+            continue;
+        }
+        format->parse = layout->parse;
+        format->layout_name = layout->name;
+        break;
+    }
+    return TRUE;
+}
+
+// 以內建版面填入格式
+static void tide_format_from_layout(TideFormat *format, const TideLayout *layout) {
+    memset(format, 0, sizeof(*format));
+    format->delimiter = layout->delimiter;
+    format->datetime_fields = layout->datetime_fields;
+    format->column_count = 7;
+    format->columns[0] = TIDE_FIELD_DATETIME;
+    memcpy(&format->columns[1], layout->fields, sizeof(layout->fields));
+    format->parse = layout->parse;
+    format->layout_name = layout->name;
+}
+
+// 解析欄位名稱
+static gboolean tide_field_from_name(const char *name, TideField *field) {
+    for (int f = 0; f < TIDE_FIELD_KIND_COUNT; f++) {
+        if (g_ascii_strcasecmp(name, tide_field_names[f]) == 0) {
+            *field = (TideField)f;
+            return TRUE;
+        }
+    }
+    if (g_ascii_strcasecmp(name, "longitude") == 0) {
+        *field = TIDE_FIELD_LONGITUDE;
+        return TRUE;
+    }
+    if (g_ascii_strcasecmp(name, "latitude") == 0) {
+        *field = TIDE_FIELD_LATITUDE;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+gboolean tide_format_from_spec(TideFormat *format, const char *spec, GError **error) {
+    *format = tide_default_format;
+    if (!spec) {
+        return TRUE;
+    }
+
+    char *text = g_strstrip(g_strdup(spec));
+    for (int i = 0; i < TIDE_LAYOUT_COUNT; i++) {
+        if (g_ascii_strcasecmp(text, tide_layouts[i].name) == 0) {
+            tide_format_from_layout(format, &tide_layouts[i]);
+            g_free(text);
+            return TRUE;
+        }
+    }
+
+    gboolean ok = TRUE;
+    char **items = g_strsplit(text, ";", -1);
+    for (int i = 0; ok && items[i]; i++) {
+        char *item = g_strstrip(items[i]);
+        if (item[0] == '\0') continue;
+
+        char *value = strchr(item, '=');
+        if (!value) {
+            g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "格式設定缺少 '=': %s", item);
+            ok = FALSE;
+            break;
+        }
+        *value++ = '\0';
+        g_strstrip(item);
+        // 分隔符本身可能是空白，只有 delimiter 的值不去除空白
+        if (g_ascii_strcasecmp(item, "delimiter") != 0) {
+            g_strstrip(value);
+        }
+
+        if (g_ascii_strcasecmp(item, "delimiter") == 0) {
+            if (g_ascii_strcasecmp(value, "tab") == 0 || strcmp(value, "\\t") == 0) {
+                format->delimiter = '\t';
+            } else if (g_ascii_strcasecmp(value, "space") == 0) {
+                format->delimiter = ' ';
+            } else if (g_ascii_strcasecmp(value, "semicolon") == 0) {
+                format->delimiter = ';';
+            } else if (strlen(value) == 1) {
+                format->delimiter = value[0];
+            } else {
+                g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "分隔符必須是單一字元: %s", value);
+                ok = FALSE;
+            }
+        } else if (g_ascii_strcasecmp(item, "datetime") == 0) {
+            char *end = NULL;
+            long fields = strtol(value, &end, 10);
+            if (end == value || *end != '\0') {
+                g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "datetime 欄數無效: %s", value);
+                ok = FALSE;
+            } else {
+                format->datetime_fields = (int)fields;
+            }
+        } else if (g_ascii_strcasecmp(item, "columns") == 0) {
+            char **names = g_strsplit(value, ",", -1);
+            int count = 0;
+            for (int n = 0; ok && names[n]; n++) {
+                TideField field;
+                if (count >= TIDE_FORMAT_MAX_COLUMNS) {
+                    g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL,
+                                "欄位數超過 %d", TIDE_FORMAT_MAX_COLUMNS);
+                    ok = FALSE;
+                } else if (!tide_field_from_name(g_strstrip(names[n]), &field)) {
+                    g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "未知的欄位名稱: %s", names[n]);
+                    ok = FALSE;
+                } else {
+                    format->columns[count++] = field;
+                }
+            }
+            format->column_count = count;
+            g_strfreev(names);
+        } else {
+            g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "未知的格式設定: %s", item);
+            ok = FALSE;
+        }
+    }
+    g_strfreev(items);
+    g_free(text);
+
+    return ok && tide_format_compile(format, error);
+}
+
+char* tide_format_to_spec(const TideFormat *format) {
+    if (format->layout_name) {
+        return g_strdup(format->layout_name);
+    }
+
+    GString *spec = g_string_new("delimiter=");
+    if (format->delimiter == '\t') {
+        g_string_append(spec, "tab");
+    } else if (format->delimiter == ' ') {
+        g_string_append(spec, "space");
+    } else if (format->delimiter == ';') {
+        g_string_append(spec, "semicolon");
+    } else {
+        g_string_append_c(spec, format->delimiter);
+    }
+    g_string_append_printf(spec, ";datetime=%d;columns=", format->datetime_fields);
+    for (int c = 0; c < format->column_count; c++) {
+        if (c > 0) g_string_append_c(spec, ',');
+        g_string_append(spec, tide_field_names[format->columns[c]]);
+    }
+    return g_string_free(spec, FALSE);
+}
+
+int tide_format_builtin_count(void) {
+    return TIDE_LAYOUT_COUNT;
+}
+
+const char* tide_format_builtin_name(int index) {
+    return index >= 0 && index < TIDE_LAYOUT_COUNT ? tide_layouts[index].name : NULL;
+}
+
+void tide_format_describe(const TideFormat *format, GString *report) {
+    if (!format || !report) return;
+
+    g_string_append(report, "輸入格式: ");
+    for (int c = 0; c < format->column_count; c++) {
+        if (c > 0) g_string_append_c(report, ',');
+        g_string_append(report, tide_field_names[format->columns[c]]);
+    }
+
+    if (format->delimiter == '\t') {
+        g_string_append(report, "（分隔符 tab");
+    } else if (format->delimiter == ' ') {
+        g_string_append(report, "（分隔符 space");
+    } else {
+        g_string_append_printf(report, "（分隔符 '%c'", format->delimiter);
+    }
+    g_string_append_printf(report, "，datetime 佔 %d 欄，", format->datetime_fields);
+    if (format->layout_name) {
+        g_string_append_printf(report, "專用解析函數 %s）\n", format->layout_name);
+    } else {
+        g_string_append(report, "通用對應表解析）\n");
+    }
+}
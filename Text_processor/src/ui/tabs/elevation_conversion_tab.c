@@ -2,6 +2,10 @@
 
 #include <gtk/gtk.h>
 #include "../../../include/callbacks.h"
+#include "../../../include/sep_raster.h"
+#include "../../../include/sep_data.h"
+#include "../../../include/elevation_processing.h"
+#include "../../../include/tide_format.h"
 
 // 構建高程轉換頁籤
 void build_elevation_conversion_tab(AppState *state, GtkNotebook *notebook) {
@@ -27,6 +31,17 @@ void build_elevation_conversion_tab(AppState *state, GtkNotebook *notebook) {
     g_signal_connect(select_file_button, "clicked", G_CALLBACK(on_select_file), state);
     gtk_box_pack_start(GTK_BOX(button_hbox), select_file_button, FALSE, FALSE, 0);
 
+    // 創建批次選擇按鈕（多個檔案或整個資料夾，共用同一份SEP模型）
+    GtkWidget *select_batch_button = gtk_button_new_with_label("批次選擇檔案");
+    gtk_widget_set_size_request(select_batch_button, 120, 40);
+    g_signal_connect(select_batch_button, "clicked", G_CALLBACK(on_select_batch_files), state);
+    gtk_box_pack_start(GTK_BOX(button_hbox), select_batch_button, FALSE, FALSE, 0);
+
+    GtkWidget *select_folder_button = gtk_button_new_with_label("批次選擇資料夾");
+    gtk_widget_set_size_request(select_folder_button, 120, 40);
+    g_signal_connect(select_folder_button, "clicked", G_CALLBACK(on_select_batch_folder), state);
+    gtk_box_pack_start(GTK_BOX(button_hbox), select_folder_button, FALSE, FALSE, 0);
+
     // 創建選擇SEP檔案按鈕
     GtkWidget *select_sep_button = gtk_button_new_with_label("選擇SEP檔案");
     gtk_widget_set_size_request(select_sep_button, 120, 40);
@@ -52,6 +67,96 @@ void build_elevation_conversion_tab(AppState *state, GtkNotebook *notebook) {
     g_object_set_data(G_OBJECT(state->window), "elevation_stop_button", stop_button);
     g_object_set_data(G_OBJECT(state->window), "convert_button", convert_button);
 
+    // 創建轉換選項區域：預計算調整值網格
+    GtkWidget *option_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_box_pack_start(GTK_BOX(tab_vbox), option_hbox, FALSE, FALSE, 0);
+
+    state->raster_check_button = gtk_check_button_new_with_label("使用預計算調整值網格");
+    gtk_widget_set_tooltip_text(state->raster_check_button,
+                                "首次使用時在SEP範圍上建立網格並存成 .raster 快取，之後每筆查詢為雙線性內插");
+    gtk_box_pack_start(GTK_BOX(option_hbox), state->raster_check_button, FALSE, FALSE, 0);
+
+    GtkWidget *resolution_label = gtk_label_new("網格解析度（度）:");
+    gtk_box_pack_start(GTK_BOX(option_hbox), resolution_label, FALSE, FALSE, 0);
+
+    state->raster_resolution_spin = gtk_spin_button_new_with_range(0.0001, 0.1, 0.0005);
+    gtk_spin_button_set_digits(GTK_SPIN_BUTTON(state->raster_resolution_spin), 4);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(state->raster_resolution_spin), SEP_RASTER_DEFAULT_RESOLUTION);
+    gtk_box_pack_start(GTK_BOX(option_hbox), state->raster_resolution_spin, FALSE, FALSE, 0);
+
+    state->tin_check_button = gtk_check_button_new_with_label("使用三角網線性內插");
+    gtk_widget_set_tooltip_text(state->tin_check_button,
+                                "首次使用時以SEP點建立 Delaunay 三角網並存成 .septin 快取，之後每筆查詢在所在三角形內線性內插"
+                                "（與預計算調整值網格擇一）");
+    gtk_box_pack_start(GTK_BOX(option_hbox), state->tin_check_button, FALSE, FALSE, 0);
+
+    // 分塊模型：大型SEP只載入測量範圍內的分塊
+    GtkWidget *tiles_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_box_pack_start(GTK_BOX(tab_vbox), tiles_hbox, FALSE, FALSE, 0);
+
+    state->tiles_check_button = gtk_check_button_new_with_label("使用分塊模型");
+    gtk_widget_set_tooltip_text(state->tiles_check_button,
+                                "首次使用時將SEP切成分塊存成 .septiles，轉換時只載入資料點所在的分塊，適合涵蓋範圍很大的SEP檔案");
+    gtk_box_pack_start(GTK_BOX(tiles_hbox), state->tiles_check_button, FALSE, FALSE, 0);
+
+    GtkWidget *tile_size_label = gtk_label_new("分塊大小（度）:");
+    gtk_box_pack_start(GTK_BOX(tiles_hbox), tile_size_label, FALSE, FALSE, 0);
+
+    state->tile_size_spin = gtk_spin_button_new_with_range(0.01, 5.0, 0.05);
+    gtk_spin_button_set_digits(GTK_SPIN_BUTTON(state->tile_size_spin), 2);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(state->tile_size_spin), SEP_TILES_DEFAULT_SIZE);
+    gtk_box_pack_start(GTK_BOX(tiles_hbox), state->tile_size_spin, FALSE, FALSE, 0);
+
+    // 查詢方式改變時決定是否預先載入完整SEP模型
+    g_signal_connect(state->raster_check_button, "toggled", G_CALLBACK(on_elevation_backend_toggled), state);
+    g_signal_connect(state->tin_check_button, "toggled", G_CALLBACK(on_elevation_backend_toggled), state);
+    g_signal_connect(state->tiles_check_button, "toggled", G_CALLBACK(on_elevation_backend_toggled), state);
+
+#ifndef G_OS_WIN32
+    // 多行程分段轉換：超大檔案切段後由多個子行程同時轉換（需要 fork，Windows 不提供）
+    GtkWidget *shard_label = gtk_label_new("多行程分段數:");
+    gtk_box_pack_start(GTK_BOX(tiles_hbox), shard_label, FALSE, FALSE, 0);
+
+    state->shard_count_spin = gtk_spin_button_new_with_range(0, 64, 1);
+    gtk_spin_button_set_value(GTK_SPIN_BUTTON(state->shard_count_spin), 0);
+    gtk_widget_set_tooltip_text(state->shard_count_spin,
+                                "大於 1 時把輸入切成數段，每段由獨立的子行程轉換後再依序串接（0 表示不分段，批次轉換不使用）");
+    gtk_box_pack_start(GTK_BOX(tiles_hbox), state->shard_count_spin, FALSE, FALSE, 0);
+#endif
+
+    // 過濾結果的輸出方式（選項順序與 ElevationFilteredOutput 相同）
+    GtkWidget *output_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_box_pack_start(GTK_BOX(tab_vbox), output_hbox, FALSE, FALSE, 0);
+
+    GtkWidget *output_label = gtk_label_new("過濾結果:");
+    gtk_box_pack_start(GTK_BOX(output_hbox), output_label, FALSE, FALSE, 0);
+
+    state->filtered_output_combo = gtk_combo_box_text_new();
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(state->filtered_output_combo), "覆寫原始檔案為過濾後版本");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(state->filtered_output_combo), "不保留（原始檔案不變）");
+    gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(state->filtered_output_combo), "列索引位元圖（原始檔案不變）");
+    gtk_combo_box_set_active(GTK_COMBO_BOX(state->filtered_output_combo), ELEVATION_FILTERED_REWRITE);
+    gtk_widget_set_tooltip_text(state->filtered_output_combo,
+                                "位元圖模式只另存 .filtered.bitmap（每行一個位元），不需重寫整個原始檔案");
+    gtk_box_pack_start(GTK_BOX(output_hbox), state->filtered_output_combo, FALSE, FALSE, 0);
+
+    // 輸入格式：內建版面（使用專用解析函數），也可直接輸入自訂設定
+    GtkWidget *format_hbox = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 10);
+    gtk_box_pack_start(GTK_BOX(tab_vbox), format_hbox, FALSE, FALSE, 0);
+
+    GtkWidget *format_label = gtk_label_new("輸入格式:");
+    gtk_box_pack_start(GTK_BOX(format_hbox), format_label, FALSE, FALSE, 0);
+
+    state->tide_format_combo = gtk_combo_box_text_new_with_entry();
+    for (int i = 0; i < tide_format_builtin_count(); i++) {
+        gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(state->tide_format_combo), tide_format_builtin_name(i));
+    }
+    gtk_combo_box_set_active(GTK_COMBO_BOX(state->tide_format_combo), 0);
+    gtk_widget_set_tooltip_text(state->tide_format_combo,
+                                "選擇內建版面，或輸入自訂設定，例如 "
+                                "delimiter=,;datetime=1;columns=datetime,lat,lon,tide,depth,col6,col7");
+    gtk_box_pack_start(GTK_BOX(format_hbox), state->tide_format_combo, TRUE, TRUE, 0);
+
     // 創建狀態標籤
     GtkWidget *status_label = gtk_label_new("請選擇要轉換的檔案和 SEP 檔案");
     gtk_label_set_xalign(GTK_LABEL(status_label), 0.0);